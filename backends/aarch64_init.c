@@ -61,6 +61,7 @@ aarch64_init (Elf *elf __attribute__ ((unused)),
   eh->frame_nregs = 97;
   HOOK (eh, set_initial_registers_tid);
   HOOK (eh, unwind);
+  HOOK (eh, frame_pointer_unwind);
 
   return eh;
 }
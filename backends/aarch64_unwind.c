@@ -81,3 +81,48 @@ EBLHOOK(unwind) (Ebl *ebl __attribute__ ((unused)), Dwarf_Addr pc __attribute__
   // But if the fp is valid, then the stack should be moving in the right direction.
   return fp == 0 || newSp > sp;
 }
+
+/* A frame that made a call keeps its frame record at FP, the FP of its
+   caller followed by its return address.  LR is what CFI restored it to,
+   its own PC, so the return address can only come from the record.  */
+
+bool
+EBLHOOK(frame_pointer_unwind) (Ebl *ebl __attribute__ ((unused)),
+			       Dwarf_Addr pc __attribute__ ((unused)),
+			       ebl_tid_registers_t *setfunc,
+			       ebl_tid_registers_get_t *getfunc,
+			       ebl_pid_memory_read_t *readfunc, void *arg,
+			       bool *signal_framep __attribute__ ((unused)))
+{
+  Dwarf_Word fp, sp;
+
+  if (!getfunc(FP_REG, 1, &fp, arg) || fp == 0)
+    return false;
+
+  if (!getfunc(SP_REG, 1, &sp, arg))
+    sp = 0;
+
+  Dwarf_Word newPc, newFp, newSp;
+
+  if (!readfunc(fp + LR_OFFSET, &newPc, arg) || newPc == 0)
+    return false;
+
+  if (!readfunc(fp + FP_OFFSET, &newFp, arg))
+    newFp = 0;
+
+  newSp = fp + SP_OFFSET;
+
+  // The stack should be moving in the right direction, and the frame
+  // record of the caller, if there is one, is further up.
+  if (newSp <= sp || (newFp != 0 && newFp < newSp))
+    return false;
+
+  // After the return LR still holds the return address, as with CFI.
+  if (!setfunc(-1, 1, &newPc, arg))
+    return false;
+  setfunc(LR_REG, 1, &newPc, arg);
+  setfunc(FP_REG, 1, &newFp, arg);
+  setfunc(SP_REG, 1, &newSp, arg);
+
+  return true;
+}
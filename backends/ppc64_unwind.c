@@ -74,3 +74,37 @@ EBLHOOK(unwind) (Ebl *ebl __attribute__ ((unused)),
   /* Sanity check the stack grows down.  */
   return newSp > sp;
 }
+
+/* A frame that made a call has its own stack frame.  Its backchain is the
+   SP of its caller, and it saved its return address in the LR save area
+   of its caller's frame.  LR is what CFI restored it to, its own PC, so
+   the return address can only come from the save area.  */
+
+bool
+EBLHOOK(frame_pointer_unwind) (Ebl *ebl __attribute__ ((unused)),
+			       Dwarf_Addr pc __attribute__ ((unused)),
+			       ebl_tid_registers_t *setfunc,
+			       ebl_tid_registers_get_t *getfunc,
+			       ebl_pid_memory_read_t *readfunc, void *arg,
+			       bool *signal_framep __attribute__ ((unused)))
+{
+  Dwarf_Word sp, newSp, newPc;
+
+  if (! getfunc (SP_REG, 1, &sp, arg) || sp == 0)
+    return false;
+
+  /* Sanity check the stack grows down.  */
+  if (! readfunc (sp, &newSp, arg) || newSp <= sp)
+    return false;
+
+  if (! readfunc (newSp + LR_OFFSET, &newPc, arg)
+      || newPc == 0
+      || ! setfunc (-1, 1, &newPc, arg))
+    return false;
+
+  /* After the return LR still holds the return address, as with CFI.  */
+  setfunc (SP_REG, 1, &newSp, arg);
+  setfunc (LR_REG, 1, &newPc, arg);
+
+  return true;
+}
@@ -32,6 +32,7 @@
 
 #include "libeu.h"
 #include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
@@ -64,6 +65,9 @@ crc32_file (int fd, uint32_t *resp)
 	{
 	  do
 	    {
+	      /* We touch every page once, in order.  */
+	      (void) posix_madvise (mapped, mapsize, POSIX_MADV_SEQUENTIAL);
+
 	      if (st.st_size <= (off_t) mapsize)
 		{
 		  *resp = crc32 (crc, mapped, st.st_size);
@@ -79,6 +83,7 @@ crc32_file (int fd, uint32_t *resp)
 	}
     }
 
+  (void) posix_fadvise (fd, off, 0, POSIX_FADV_SEQUENTIAL);
   while ((count = TEMP_FAILURE_RETRY (pread (fd, buffer, sizeof buffer,
 					     off))) > 0)
     {
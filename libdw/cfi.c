@@ -339,9 +339,13 @@ execute_cfi (Dwarf_CFI *cache,
 
 	case DW_CFA_restore_state:
 	  {
-	    /* Pop the current state off and use the old one instead.  */
+	    /* Pop the current state off and use the old one instead.
+	       It still applies from the current row on, not from where
+	       it was remembered.  */
 	    Dwarf_Frame *prev = fs->prev;
 	    cfi_assert (prev != NULL);
+	    prev->start = fs->start;
+	    prev->end = fs->end;
 	    free (fs);
 	    fs = prev;
 	    continue;
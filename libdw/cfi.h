@@ -70,6 +70,15 @@ struct dwarf_fde
   const uint8_t *instructions_end;
 };
 
+/* Entry of the FDE table, like one of .eh_frame_hdr, but with the end
+   of the range.  */
+struct dwarf_fde_range
+{
+  Dwarf_Addr start;
+  Dwarf_Addr end;
+  Dwarf_Off offset;		/* -1 where FDEs overlap.  */
+};
+
 /* This holds everything we cache about the CFI from each ELF file's
    .debug_frame or .eh_frame section.  */
 struct Dwarf_CFI_s
@@ -95,8 +104,26 @@ struct Dwarf_CFI_s
   /* Search tree for the FDEs, indexed by PC address.  */
   void *fde_tree;
 
-  /* Search tree for parsed DWARF expressions, indexed by raw pointer.  */
-  void *expr_tree;
+  /* Without a search_table, the ranges of all FDEs sorted by address,
+     read in one pass over the section on the first lookup.  NULL if not
+     read yet, (void *) -1l if they cannot be read.  Where the table has
+     no FDE for an address we read them one by one until we find it.  */
+  struct dwarf_fde_range *fde_table;
+  size_t fde_table_entries;
+
+  /* Parsed DWARF expressions, indexed by raw pointer.  */
+  _Atomic (Dwarf_Loc_Hash *) expr_hash;
+
+  /* Frame states handed out by dwarf_cfi_addrframe_cached, in sets of
+     two slots indexed by a hash of the PC they were looked up for.
+     Each slot holds one malloc'd frame, the older of a set is replaced
+     when a PC outside both ranges maps to it.  Allocated on first use,
+     with about two slots for each FDE, between 1 << CFI_FRAME_CACHE_MIN_BITS
+     and 1 << CFI_FRAME_CACHE_MAX_BITS slots.  */
+  Dwarf_Frame **frame_cache;
+  unsigned int frame_cache_bits;
+#define CFI_FRAME_CACHE_MIN_BITS	4
+#define CFI_FRAME_CACHE_MAX_BITS	14
 
   /* Backend hook.  */
   struct ebl *ebl;
@@ -234,5 +261,6 @@ INTDECL (dwarf_getcfi)
 INTDECL (dwarf_getcfi_elf)
 INTDECL (dwarf_cfi_end)
 INTDECL (dwarf_cfi_addrframe)
+INTDECL (dwarf_cfi_addrframe_cached)
 
 #endif	/* unwindP.h */
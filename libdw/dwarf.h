@@ -817,6 +817,31 @@ enum
     DW_LNCT_hi_user = 0x3fff
   };
 
+/* DWARF name index attribute encodings.  */
+enum
+  {
+    DW_IDX_compile_unit = 0x1,
+    DW_IDX_type_unit = 0x2,
+    DW_IDX_die_offset = 0x3,
+    DW_IDX_parent = 0x4,
+    DW_IDX_type_hash = 0x5,
+    DW_IDX_lo_user = 0x2000,
+    DW_IDX_hi_user = 0x3fff
+  };
+
+/* DWARF package file section identifiers.  */
+enum
+  {
+    DW_SECT_INFO = 1,
+    /* Reserved = 2, */
+    DW_SECT_ABBREV = 3,
+    DW_SECT_LINE = 4,
+    DW_SECT_LOCLISTS = 5,
+    DW_SECT_STR_OFFSETS = 6,
+    DW_SECT_MACRO = 7,
+    DW_SECT_RNGLISTS = 8,
+  };
+
 /* DWARF standard opcode encodings.  */
 enum
   {
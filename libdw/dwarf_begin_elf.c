@@ -64,9 +64,13 @@ static const char dwarf_scnnames[IDX_last][19] =
   [IDX_debug_str_offsets] = ".debug_str_offsets",
   [IDX_debug_macinfo] = ".debug_macinfo",
   [IDX_debug_macro] = ".debug_macro",
+  [IDX_debug_names] = ".debug_names",
   [IDX_debug_ranges] = ".debug_ranges",
   [IDX_debug_rnglists] = ".debug_rnglists",
-  [IDX_gnu_debugaltlink] = ".gnu_debugaltlink"
+  [IDX_gnu_debugaltlink] = ".gnu_debugaltlink",
+  [IDX_gdb_index] = ".gdb_index",
+  [IDX_debug_cu_index] = ".debug_cu_index",
+  [IDX_debug_tu_index] = ".debug_tu_index"
 };
 #define ndwarf_scnnames (sizeof (dwarf_scnnames) / sizeof (dwarf_scnnames[0]))
 
@@ -183,26 +187,32 @@ check_section (Dwarf *result, size_t shstrndx, Elf_Scn *scn, bool inscngrp)
 }
 
 
-/* Helper function to set debugdir field.  We want to cache the dir
-   where we found this Dwarf ELF file to locate alt and dwo files.  */
 char *
-__libdw_debugdir (int fd)
+__libdw_fdpath (int fd)
 {
   /* strlen ("/proc/self/fd/") = 14 + strlen (<MAXINT>) = 10 + 1 = 25.  */
   char devfdpath[25];
   sprintf (devfdpath, "/proc/self/fd/%u", fd);
   char *fdpath = realpath (devfdpath, NULL);
-  char *fddir;
-  if (fdpath != NULL && fdpath[0] == '/'
-      && (fddir = strrchr (fdpath, '/')) != NULL)
-    {
-      *++fddir = '\0';
-      return fdpath;
-    }
+  if (fdpath != NULL && fdpath[0] == '/')
+    return fdpath;
+  free (fdpath);
   return NULL;
 }
 
 
+/* Helper function to set debugdir field.  We want to cache the dir
+   where we found this Dwarf ELF file to locate alt and dwo files.  */
+char *
+__libdw_debugdir (int fd)
+{
+  char *fdpath = __libdw_fdpath (fd);
+  if (fdpath != NULL)
+    strrchr (fdpath, '/')[1] = '\0';
+  return fdpath;
+}
+
+
 /* Check whether all the necessary DWARF information is available.  */
 static Dwarf *
 valid_p (Dwarf *result)
@@ -244,10 +254,13 @@ valid_p (Dwarf *result)
 	  result->fake_loc_cu->endp
 	    = (result->sectiondata[IDX_debug_loc]->d_buf
 	       + result->sectiondata[IDX_debug_loc]->d_size);
-	  result->fake_loc_cu->locs = NULL;
+	  atomic_store_explicit (&result->fake_loc_cu->locs, NULL,
+				 memory_order_relaxed);
 	  result->fake_loc_cu->address_size = 0;
 	  result->fake_loc_cu->version = 0;
-	  result->fake_loc_cu->split = NULL;
+	  atomic_store_explicit (&result->fake_loc_cu->split, NULL,
+				 memory_order_relaxed);
+	  result->fake_loc_cu->dwp_index = NULL;
 	}
     }
 
@@ -271,10 +284,13 @@ valid_p (Dwarf *result)
 	  result->fake_loclists_cu->endp
 	    = (result->sectiondata[IDX_debug_loclists]->d_buf
 	       + result->sectiondata[IDX_debug_loclists]->d_size);
-	  result->fake_loclists_cu->locs = NULL;
+	  atomic_store_explicit (&result->fake_loclists_cu->locs, NULL,
+				 memory_order_relaxed);
 	  result->fake_loclists_cu->address_size = 0;
 	  result->fake_loclists_cu->version = 0;
-	  result->fake_loclists_cu->split = NULL;
+	  atomic_store_explicit (&result->fake_loclists_cu->split, NULL,
+				 memory_order_relaxed);
+	  result->fake_loclists_cu->dwp_index = NULL;
 	}
     }
 
@@ -303,15 +319,41 @@ valid_p (Dwarf *result)
 	  result->fake_addr_cu->endp
 	    = (result->sectiondata[IDX_debug_addr]->d_buf
 	       + result->sectiondata[IDX_debug_addr]->d_size);
-	  result->fake_addr_cu->locs = NULL;
+	  atomic_store_explicit (&result->fake_addr_cu->locs, NULL,
+				 memory_order_relaxed);
 	  result->fake_addr_cu->address_size = 0;
 	  result->fake_addr_cu->version = 0;
-	  result->fake_addr_cu->split = NULL;
+	  atomic_store_explicit (&result->fake_addr_cu->split, NULL,
+				 memory_order_relaxed);
+	  result->fake_addr_cu->dwp_index = NULL;
 	}
     }
 
+  /* A DWARF package file comes with an index of the unit
+     contributions to each section.  */
+  if (result != NULL && result->sectiondata[IDX_debug_cu_index] != NULL)
+    {
+      result->cu_index = __libdw_dwp_index (result, IDX_debug_cu_index);
+      result->tu_index = __libdw_dwp_index (result, IDX_debug_tu_index);
+    }
+
+  /* The path of the file is also where to find a .dwp file.  Without
+     memory for the dir, act as if the path isn't known.  */
   if (result != NULL)
-    result->debugdir = __libdw_debugdir (result->elf->fildes);
+    {
+      result->elfpath = __libdw_fdpath (result->elf->fildes);
+      if (result->elfpath != NULL)
+	{
+	  const char *base = strrchr (result->elfpath, '/');
+	  result->debugdir = strndup (result->elfpath,
+				      base - result->elfpath + 1);
+	  if (unlikely (result->debugdir == NULL))
+	    {
+	      free (result->elfpath);
+	      result->elfpath = NULL;
+	    }
+	}
+    }
 
   return result;
 }
@@ -429,19 +471,22 @@ dwarf_begin_elf (Elf *elf, Dwarf_Cmd cmd, Elf_Scn *scngrp)
 
   result->elf = elf;
   result->alt_fd = -1;
+  result->dwp_dwarf = (Dwarf *) -1;
 
   /* Initialize the memory handling.  Initial blocks are allocated on first
      actual allocation.  */
   result->mem_default_size = mem_default_size;
   result->oom_handler = __libdw_oom;
-  if (pthread_rwlock_init(&result->mem_rwl, NULL) != 0)
+
+  if (pthread_mutex_init (&result->units_lock, NULL) != 0
+      || pthread_mutex_init (&result->abbrev_lock, NULL) != 0
+      || pthread_mutex_init (&result->split_lock, NULL) != 0
+      || pthread_mutex_init (&result->lines_lock, NULL) != 0)
     {
       free (result);
       __libdw_seterrno (DWARF_E_NOMEM); /* no memory.  */
       return NULL;
     }
-  result->mem_stacks = 0;
-  result->mem_tails = NULL;
 
   if (cmd == DWARF_C_READ || cmd == DWARF_C_RDWR)
     {
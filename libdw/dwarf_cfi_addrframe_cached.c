@@ -0,0 +1,118 @@
+/* Look up a cached frame state at PC.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include "cfi.h"
+
+/* Allocate the table once the first lookup has read the search table or
+   the FDE table, so it can be sized by the number of FDEs.  */
+static bool
+alloc_frame_cache (Dwarf_CFI *cache)
+{
+  size_t nfdes = 0;
+  if (cache->search_table != NULL)
+    nfdes = cache->search_table_entries;
+  else if (cache->fde_table != NULL && cache->fde_table != (void *) -1l)
+    nfdes = cache->fde_table_entries;
+
+  unsigned int bits = CFI_FRAME_CACHE_MIN_BITS;
+  while (bits < CFI_FRAME_CACHE_MAX_BITS && ((size_t) 1 << bits) < 2 * nfdes)
+    bits++;
+
+  cache->frame_cache = calloc ((size_t) 1 << bits, sizeof (Dwarf_Frame *));
+  if (unlikely (cache->frame_cache == NULL))
+    return false;
+  cache->frame_cache_bits = bits;
+  return true;
+}
+
+static size_t
+frame_cache_set (Dwarf_CFI *cache, Dwarf_Addr address)
+{
+  /* Each PC can be in one of two slots, so two hot PCs that hash to
+     the same place don't keep pushing each other out.  Fibonacci
+     hashing spreads nearby PCs over the whole table.  */
+  size_t slot = (((uint64_t) address * 0x9e3779b97f4a7c15ull)
+		 >> (64 - cache->frame_cache_bits));
+  return slot & ~(size_t) 1;
+}
+
+int
+dwarf_cfi_addrframe_cached (Dwarf_CFI *cache, Dwarf_Addr address,
+			    Dwarf_Frame **frame)
+{
+  /* Maybe there was a previous error.  */
+  if (cache == NULL)
+    return -1;
+
+  if (likely (cache->frame_cache != NULL))
+    {
+      Dwarf_Frame **set = &cache->frame_cache[frame_cache_set (cache,
+							       address)];
+      for (int way = 0; way < 2; way++)
+	{
+	  Dwarf_Frame *fs = set[way];
+	  if (fs != NULL && fs->start <= address && address < fs->end)
+	    {
+	      *frame = fs;
+	      return 0;
+	    }
+	}
+    }
+
+  struct dwarf_fde *fde = __libdw_find_fde (cache, address);
+  if (fde == NULL)
+    return -1;
+
+  Dwarf_Frame *fs;
+  int error = __libdw_frame_at_address (cache, fde, address, &fs);
+  if (error != DWARF_E_NOERROR)
+    {
+      __libdw_seterrno (error);
+      return -1;
+    }
+
+  if (unlikely (cache->frame_cache == NULL) && ! alloc_frame_cache (cache))
+    {
+      free (fs);
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return -1;
+    }
+
+  /* The older frame of the two goes.  */
+  Dwarf_Frame **set = &cache->frame_cache[frame_cache_set (cache, address)];
+  free (set[1]);
+  set[1] = set[0];
+  set[0] = fs;
+  *frame = fs;
+  return 0;
+}
+INTDEF (dwarf_cfi_addrframe_cached)
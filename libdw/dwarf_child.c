@@ -38,6 +38,86 @@
 #define INVALID 0xffffe444
 
 
+/* Like __libdw_find_attr, but using the attributes of the abbrev as
+   decoded by __libdw_getabbrev.  Values at a known offset are found
+   directly, only those after a value of variable size are skipped.  */
+static unsigned char *
+find_decoded_attr (Dwarf_Die *die, const Dwarf_Abbrev *abbrevp,
+		   const unsigned char *readp, unsigned int search_name,
+		   unsigned int *codep, unsigned int *formp)
+{
+  const struct libdw_abbrev_attr *attrs = abbrevp->attrs;
+
+  /* Find the attribute, or the zero pair at the end, and remember the
+     last value before it that is at a known offset.  */
+  size_t idx;
+  size_t known_idx = 0;
+  uint32_t known_offset = 0;
+  bool found = false;
+  for (idx = 0; ; idx++)
+    {
+      if (attrs[idx].form != DW_FORM_implicit_const
+	  && attrs[idx].offset != LIBDW_ATTR_OFFSET_UNKNOWN)
+	{
+	  known_idx = idx;
+	  known_offset = attrs[idx].offset;
+	}
+
+      if (attrs[idx].name == 0 && attrs[idx].form == 0)
+	break;
+
+      if (attrs[idx].name == search_name && search_name != INVALID)
+	{
+	  found = true;
+	  break;
+	}
+    }
+
+  if (found && attrs[idx].form == DW_FORM_implicit_const)
+    {
+      /* The value is in the abbrev, the DIE data doesn't matter.  */
+      if (codep != NULL)
+	*codep = search_name;
+      if (formp != NULL)
+	*formp = DW_FORM_implicit_const;
+      return (unsigned char *) abbrevp->attrp + attrs[idx].offset;
+    }
+
+  const unsigned char *endp = die->cu->endp;
+  if (unlikely (known_offset > (size_t) (endp - readp)))
+    {
+      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+      readp = NULL;
+      found = false;
+    }
+  else
+    {
+      readp += known_offset;
+      for (size_t i = known_idx; i < idx; i++)
+	if (attrs[i].form != 0)
+	  {
+	    size_t len = __libdw_form_val_len (die->cu, attrs[i].form, readp);
+	    if (unlikely (len == (size_t) -1l))
+	      {
+		readp = NULL;
+		found = false;
+		break;
+	      }
+
+	    // __libdw_form_val_len will have done a bounds check.
+	    readp += len;
+	  }
+    }
+
+  if (codep != NULL)
+    *codep = found ? search_name : INVALID;
+  if (formp != NULL)
+    *formp = found ? attrs[idx].form : INVALID;
+
+  return (unsigned char *) readp;
+}
+
+
 unsigned char *
 internal_function
 __libdw_find_attr (Dwarf_Die *die, unsigned int search_name,
@@ -53,6 +133,9 @@ __libdw_find_attr (Dwarf_Die *die, unsigned int search_name,
       return NULL;
     }
 
+  if (abbrevp->attrs != NULL)
+    return find_decoded_attr (die, abbrevp, readp, search_name, codep, formp);
+
   /* Search the name attribute.  Attribute has been checked when
      Dwarf_Abbrev was created, we can read unchecked.  */
   const unsigned char *attrp = abbrevp->attrp;
@@ -0,0 +1,104 @@
+/* Decode all location expressions of a CU.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwP.h"
+
+
+static int
+load_attr (Dwarf_Attribute *attr, void *arg __attribute__ ((unused)))
+{
+  /* dwarf_getlocations rejects anything that is not a location or
+     location list quickly, and caches everything it decodes.  */
+  Dwarf_Addr base, start, end;
+  Dwarf_Op *expr;
+  size_t exprlen;
+  ptrdiff_t offset = 0;
+  while ((offset = INTUSE(dwarf_getlocations) (attr, offset, &base,
+					       &start, &end,
+					       &expr, &exprlen)) > 0)
+    ;
+
+  return DWARF_CB_OK;
+}
+
+
+static int
+load_dies (Dwarf_Die *die)
+{
+  Dwarf_Die cur = *die;
+  int res;
+  do
+    {
+      if (INTUSE(dwarf_getattrs) (&cur, load_attr, NULL, 0) < 0)
+	return -1;
+
+      Dwarf_Die child;
+      res = INTUSE(dwarf_child) (&cur, &child);
+      if (res < 0 || (res == 0 && load_dies (&child) != 0))
+	return -1;
+    }
+  while ((res = INTUSE(dwarf_siblingof) (&cur, &cur)) == 0);
+
+  return res < 0 ? -1 : 0;
+}
+
+
+int
+dwarf_cu_load_locations (Dwarf_CU *cu)
+{
+  if (cu == NULL)
+    return -1;
+
+  if (cu->version < 2 || cu->version > 5
+      || cu->unit_type < DW_UT_compile || cu->unit_type > DW_UT_split_type)
+    {
+      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+      return -1;
+    }
+
+  Dwarf_Die cudie = CUDIE (cu);
+  if (load_dies (&cudie) != 0)
+    return -1;
+
+  /* The locations of a skeleton unit are mostly in its split unit.  */
+  if (cu->unit_type == DW_UT_skeleton)
+    {
+      Dwarf_CU *split = __libdw_find_split_unit (cu);
+      if (split != NULL)
+	{
+	  cudie = CUDIE (split);
+	  return load_dies (&cudie);
+	}
+    }
+
+  return 0;
+}
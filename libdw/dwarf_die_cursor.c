@@ -0,0 +1,263 @@
+/* Walk over a DIE tree without recursion.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "libdwP.h"
+
+/* Initial depth of the stack.  Most DIE trees aren't deeper.  */
+#define INITIAL_STACK_SIZE 16
+
+
+/* Make room for one more DIE on the stack.  */
+static bool
+grow_stack (Dwarf_Die_Cursor *cursor, size_t depth)
+{
+  if (depth < cursor->stack_size)
+    return true;
+
+  size_t size = cursor->stack_size * 2;
+  while (size <= depth)
+    size *= 2;
+  Dwarf_Die *stack = realloc (cursor->stack, size * sizeof stack[0]);
+  if (stack == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return false;
+    }
+  cursor->stack = stack;
+  cursor->stack_size = size;
+  return true;
+}
+
+
+Dwarf_Die_Cursor *
+dwarf_die_cursor_begin (Dwarf_Die *die, bool postorder)
+{
+  /* Ignore previous errors.  */
+  if (die == NULL)
+    return NULL;
+
+  Dwarf_Die_Cursor *cursor = malloc (sizeof *cursor);
+  Dwarf_Die *stack = malloc (INITIAL_STACK_SIZE * sizeof stack[0]);
+  if (cursor == NULL || stack == NULL)
+    {
+      free (cursor);
+      free (stack);
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return NULL;
+    }
+
+  stack[0] = *die;
+  cursor->stack = stack;
+  cursor->depth = 0;
+  cursor->stack_size = INITIAL_STACK_SIZE;
+  cursor->postorder = postorder;
+  cursor->skip = false;
+  cursor->state = die_cursor_start;
+  return cursor;
+}
+
+
+int
+dwarf_die_cursor_next (Dwarf_Die_Cursor *cursor, Dwarf_Die *result,
+		       unsigned int *depthp, int *orderp)
+{
+  if (cursor == NULL)
+    return -1;
+
+  switch (cursor->state)
+    {
+    case die_cursor_start:
+      cursor->state = die_cursor_pre;
+      goto found;
+
+    case die_cursor_done:
+      return 1;
+
+    case die_cursor_pre:
+      if (! cursor->skip)
+	{
+	  if (! grow_stack (cursor, cursor->depth + 1))
+	    return -1;
+	  Dwarf_Die *die = &cursor->stack[cursor->depth];
+	  int res = INTUSE(dwarf_child) (die, die + 1);
+	  if (res < 0)
+	    return -1;
+	  if (res == 0)
+	    {
+	      cursor->depth++;
+	      goto found;
+	    }
+	}
+      cursor->skip = false;
+
+      /* A DIE without children is left right away.  */
+      if (cursor->postorder)
+	{
+	  cursor->state = die_cursor_post;
+	  goto found;
+	}
+      break;
+
+    case die_cursor_post:
+      break;
+    }
+
+  /* Go to the next sibling, or leave the parent if there is none.  */
+  while (cursor->depth > 0)
+    {
+      Dwarf_Die *die = &cursor->stack[cursor->depth];
+      int res = INTUSE(dwarf_siblingof) (die, die);
+      if (res < 0)
+	return -1;
+      if (res == 0)
+	{
+	  cursor->state = die_cursor_pre;
+	  goto found;
+	}
+
+      cursor->depth--;
+      if (cursor->postorder)
+	{
+	  cursor->state = die_cursor_post;
+	  goto found;
+	}
+    }
+
+  /* The DIE the walk started at has no siblings we should look at.  */
+  cursor->state = die_cursor_done;
+  return 1;
+
+ found:
+  *result = cursor->stack[cursor->depth];
+  if (depthp != NULL)
+    *depthp = cursor->depth;
+  if (orderp != NULL)
+    *orderp = (cursor->state == die_cursor_pre
+	       ? DWARF_DIE_CURSOR_PRE : DWARF_DIE_CURSOR_POST);
+  return 0;
+}
+
+
+int
+dwarf_die_cursor_skip (Dwarf_Die_Cursor *cursor)
+{
+  if (cursor == NULL)
+    return -1;
+
+  if (cursor->state != die_cursor_pre)
+    {
+      __libdw_seterrno (DWARF_E_NO_ENTRY);
+      return -1;
+    }
+
+  cursor->skip = true;
+  return 0;
+}
+
+
+size_t
+dwarf_die_cursor_position (Dwarf_Die_Cursor *cursor, Dwarf_Off *offsets,
+			   size_t noffsets)
+{
+  if (cursor == NULL)
+    return 0;
+
+  if (cursor->state != die_cursor_pre && cursor->state != die_cursor_post)
+    {
+      __libdw_seterrno (DWARF_E_NO_ENTRY);
+      return 0;
+    }
+
+  for (size_t i = 0; i <= cursor->depth && i < noffsets; i++)
+    offsets[i] = INTUSE(dwarf_dieoffset) (&cursor->stack[i]);
+  return cursor->depth + 1;
+}
+
+
+int
+dwarf_die_cursor_resume (Dwarf_Die_Cursor *cursor, const Dwarf_Off *offsets,
+			 size_t noffsets, int order)
+{
+  if (cursor == NULL)
+    return -1;
+
+  /* The DIE the walk started at must be the same.  All others are
+     after it in the same unit.  */
+  Dwarf_Die *root = &cursor->stack[0];
+  struct Dwarf_CU *cu = root->cu;
+  if (order != DWARF_DIE_CURSOR_PRE && order != DWARF_DIE_CURSOR_POST)
+    {
+      __libdw_seterrno (DWARF_E_INVALID_CMD);
+      return -1;
+    }
+  if (noffsets == 0 || offsets[0] != INTUSE(dwarf_dieoffset) (root))
+    {
+      __libdw_seterrno (DWARF_E_INVALID_OFFSET);
+      return -1;
+    }
+  for (size_t i = 1; i < noffsets; i++)
+    if (offsets[i] <= offsets[i - 1] || offsets[i] >= cu->end)
+      {
+	__libdw_seterrno (DWARF_E_INVALID_OFFSET);
+	return -1;
+      }
+
+  if (! grow_stack (cursor, noffsets - 1))
+    return -1;
+
+  for (size_t i = 1; i < noffsets; i++)
+    {
+      Dwarf_Die *die = &cursor->stack[i];
+      memset (die, '\0', sizeof *die);
+      die->addr = (char *) cu->startp + (offsets[i] - cu->start);
+      die->cu = cu;
+    }
+
+  cursor->depth = noffsets - 1;
+  cursor->skip = false;
+  cursor->state = (order == DWARF_DIE_CURSOR_PRE
+		   ? die_cursor_pre : die_cursor_post);
+  return 0;
+}
+
+
+void
+dwarf_die_cursor_end (Dwarf_Die_Cursor *cursor)
+{
+  if (cursor != NULL)
+    {
+      free (cursor->stack);
+      free (cursor);
+    }
+}
@@ -52,27 +52,66 @@ cu_free (void *arg)
 {
   struct Dwarf_CU *p = (struct Dwarf_CU *) arg;
 
-  tdestroy (p->locs, noop_free);
+  Dwarf_Loc_Hash *locs = atomic_load_explicit (&p->locs,
+					       memory_order_relaxed);
+  if (locs != NULL)
+    __libdw_loc_hash_free (locs, false);
 
   /* Only free the CU internals if its not a fake CU.  */
   if(p != p->dbg->fake_loc_cu && p != p->dbg->fake_loclists_cu
      && p != p->dbg->fake_addr_cu)
     {
-      Dwarf_Abbrev_Hash_free (&p->abbrev_hash);
+      struct libdw_scope_index *scope_index
+	= atomic_load_explicit (&p->scope_index, memory_order_relaxed);
+      if (scope_index != NULL && scope_index != (void *) -1)
+	__libdw_scope_index_free (scope_index);
 
       /* Free split dwarf one way (from skeleton to split).  */
+      struct Dwarf_CU *split = atomic_load_explicit (&p->split,
+						     memory_order_relaxed);
       if (p->unit_type == DW_UT_skeleton
-	  && p->split != NULL && p->split != (void *)-1)
+	  && split != NULL && split != (void *)-1)
 	{
 	  /* The fake_addr_cu might be shared, only release one.  */
-	  if (p->dbg->fake_addr_cu == p->split->dbg->fake_addr_cu)
-	    p->split->dbg->fake_addr_cu = NULL;
-	  INTUSE(dwarf_end) (p->split->dbg);
+	  if (p->dbg->fake_addr_cu == split->dbg->fake_addr_cu)
+	    split->dbg->fake_addr_cu = NULL;
+	  /* A DWARF package file is shared by all skeletons, it is
+	     released once from dwarf_end.  */
+	  if (split->dbg != p->dbg->dwp_dwarf)
+	    INTUSE(dwarf_end) (split->dbg);
 	}
     }
 }
 
 
+static void
+abbrev_table_free (void *arg)
+{
+  struct libdw_abbrev_table *table = (struct libdw_abbrev_table *) arg;
+
+  Dwarf_Abbrev_Hash_free (&table->hash);
+  free (table);
+}
+
+
+static void
+units_free (struct libdw_unit_table *table)
+{
+  size_t n = atomic_load_explicit (&table->nunits, memory_order_relaxed);
+  struct libdw_unit_array *array
+    = atomic_load_explicit (&table->array, memory_order_relaxed);
+  for (size_t i = 0; i < n; i++)
+    cu_free (array->units[i]);
+
+  while (array != NULL)
+    {
+      struct libdw_unit_array *prev = array->prev;
+      free (array);
+      array = prev;
+    }
+}
+
+
 int
 dwarf_end (Dwarf *dwarf)
 {
@@ -84,39 +123,58 @@ dwarf_end (Dwarf *dwarf)
 
       Dwarf_Sig8_Hash_free (&dwarf->sig8_hash);
 
-      /* The search tree for the CUs.  NB: the CU data itself is
-	 allocated separately, but the abbreviation hash tables need
-	 to be handled.  */
-      tdestroy (dwarf->cu_tree, cu_free);
-      tdestroy (dwarf->tu_tree, cu_free);
+      /* The tables of CUs.  NB: the CU data itself is allocated
+	 separately, but the location hash tables need to be handled.  */
+      units_free (&dwarf->cu_table);
+      units_free (&dwarf->tu_table);
+      pthread_mutex_destroy (&dwarf->units_lock);
+      free (atomic_load_explicit (&dwarf->unit_list, memory_order_relaxed));
+
+      /* The abbreviation tables shared by the units.  */
+      tdestroy (dwarf->abbrev_tables, abbrev_table_free);
+      pthread_mutex_destroy (&dwarf->abbrev_lock);
 
       /* Search tree for macro opcode tables.  */
       tdestroy (dwarf->macro_ops, noop_free);
 
       /* Search tree for decoded .debug_lines units.  */
       tdestroy (dwarf->files_lines, noop_free);
+      pthread_mutex_destroy (&dwarf->lines_lock);
 
       /* And the split Dwarf.  */
       tdestroy (dwarf->split_tree, noop_free);
+      pthread_mutex_destroy (&dwarf->split_lock);
 
       /* Free the internally allocated memory.  */
-      for (size_t i = 0; i < dwarf->mem_stacks; i++)
-        {
-          struct libdw_memblock *memp = dwarf->mem_tails[i];
-          while (memp != NULL)
+      for (size_t chunk = 0; chunk < LIBDW_MEM_CHUNKS; chunk++)
+	{
+	  struct libdw_memblock **tails
+	    = atomic_load_explicit (&dwarf->mem_tails[chunk],
+				    memory_order_relaxed);
+	  if (tails == NULL)
+	    continue;
+
+	  for (size_t i = 0; i < ((size_t) 64 << chunk); i++)
 	    {
-	      struct libdw_memblock *prevp = memp->prev;
-	      free (memp);
-	      memp = prevp;
+	      struct libdw_memblock *memp = tails[i];
+	      while (memp != NULL)
+		{
+		  struct libdw_memblock *prevp = memp->prev;
+		  free (memp);
+		  memp = prevp;
+		}
 	    }
-        }
-      if (dwarf->mem_tails != NULL)
-        free (dwarf->mem_tails);
-      pthread_rwlock_destroy (&dwarf->mem_rwl);
+	  free (tails);
+	}
 
       /* Free the pubnames helper structure.  */
       free (dwarf->pubnames_sets);
 
+      /* And the decoded .debug_names headers.  */
+      for (size_t i = 0; i < dwarf->names_nindexes; i++)
+	free (dwarf->names_indexes[i].abbrevs);
+      free (dwarf->names_indexes);
+
       /* Free the ELF descriptor if necessary.  */
       if (dwarf->free_elf)
 	elf_end (dwarf->elf);
@@ -138,6 +196,14 @@ dwarf_end (Dwarf *dwarf)
 	  free (dwarf->fake_addr_cu);
 	}
 
+      /* The DWARF package file is ours if we found one.  */
+      if (dwarf->dwp_dwarf != NULL && dwarf->dwp_dwarf != (Dwarf *) -1)
+	INTUSE(dwarf_end) (dwarf->dwp_dwarf);
+
+      /* The decoded .dwp index sections.  */
+      __libdw_dwp_index_free (dwarf->cu_index);
+      __libdw_dwp_index_free (dwarf->tu_index);
+
       /* Did we find and allocate the alt Dwarf ourselves?  */
       if (dwarf->alt_fd != -1)
 	{
@@ -145,8 +211,9 @@ dwarf_end (Dwarf *dwarf)
 	  close (dwarf->alt_fd);
 	}
 
-      /* The cached dir we found the Dwarf ELF file in.  */
+      /* The cached dir and path we found the Dwarf ELF file in.  */
       free (dwarf->debugdir);
+      free (dwarf->elfpath);
 
       /* Free the context descriptor.  */
       free (dwarf);
@@ -107,7 +107,7 @@ dwarf_frame_register (Dwarf_Frame *fs, int regno, Dwarf_Op ops_mem[3],
 	if (__libdw_intern_expression (NULL,
 				       fs->cache->other_byte_order,
 				       address_size, 4,
-				       &fs->cache->expr_tree, &block,
+				       &fs->cache->expr_hash, &block,
 				       true, reg->rule == reg_val_expression,
 				       ops, nops, IDX_debug_frame) < 0)
 	  return -1;
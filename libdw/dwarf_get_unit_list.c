@@ -0,0 +1,108 @@
+/* Get an array of all units of a Dwarf.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+
+#include "libdwP.h"
+
+
+static struct libdw_unit_list *
+read_unit_list (Dwarf *dbg)
+{
+  size_t nalloc = 16;
+  struct libdw_unit_list *list
+    = malloc (sizeof *list + nalloc * sizeof (Dwarf_CU *));
+  if (list == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return NULL;
+    }
+  list->nunits = 0;
+
+  Dwarf_CU *cu = NULL;
+  int res;
+  while ((res = dwarf_get_units (dbg, cu, &cu, NULL, NULL, NULL, NULL)) == 0)
+    {
+      if (list->nunits == nalloc)
+	{
+	  nalloc *= 2;
+	  struct libdw_unit_list *newp
+	    = realloc (list, sizeof *list + nalloc * sizeof (Dwarf_CU *));
+	  if (newp == NULL)
+	    {
+	      free (list);
+	      __libdw_seterrno (DWARF_E_NOMEM);
+	      return NULL;
+	    }
+	  list = newp;
+	}
+      list->units[list->nunits++] = cu;
+    }
+
+  if (res < 0)
+    {
+      free (list);
+      return NULL;
+    }
+
+  return list;
+}
+
+
+int
+dwarf_get_unit_list (Dwarf *dwarf, Dwarf_CU *const **units, size_t *nunits)
+{
+  if (dwarf == NULL)
+    return -1;
+
+  struct libdw_unit_list *list
+    = atomic_load_explicit (&dwarf->unit_list, memory_order_acquire);
+  if (list == NULL)
+    {
+      /* Reading the unit headers is thread-safe.  If another thread
+	 was quicker, use its list.  */
+      struct libdw_unit_list *newp = read_unit_list (dwarf);
+      if (newp == NULL)
+	return -1;
+
+      if (atomic_compare_exchange_strong_explicit (&dwarf->unit_list, &list,
+						   newp, memory_order_acq_rel,
+						   memory_order_acquire))
+	list = newp;
+      else
+	free (newp);
+    }
+
+  *units = list->units;
+  *nunits = list->nunits;
+  return 0;
+}
+INTDEF (dwarf_get_unit_list)
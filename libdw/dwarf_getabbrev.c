@@ -32,9 +32,188 @@
 #endif
 
 #include <dwarf.h>
+#include <search.h>
+#include <stdlib.h>
 #include "libdwP.h"
 
 
+static int
+compare_abbrev_table (const void *a, const void *b)
+{
+  const struct libdw_abbrev_table *t1 = a;
+  const struct libdw_abbrev_table *t2 = b;
+
+  if (t1->offset != t2->offset)
+    return t1->offset < t2->offset ? -1 : 1;
+  if (t1->version != t2->version)
+    return t1->version < t2->version ? -1 : 1;
+  if (t1->address_size != t2->address_size)
+    return t1->address_size < t2->address_size ? -1 : 1;
+  if (t1->offset_size != t2->offset_size)
+    return t1->offset_size < t2->offset_size ? -1 : 1;
+  return 0;
+}
+
+
+struct libdw_abbrev_table *
+internal_function
+__libdw_abbrev_table (Dwarf *dbg, Dwarf_Off offset, uint16_t version,
+		      uint8_t address_size, uint8_t offset_size)
+{
+  struct libdw_abbrev_table key =
+    {
+      .offset = offset,
+      .version = version,
+      .address_size = address_size,
+      .offset_size = offset_size
+    };
+
+  struct libdw_abbrev_table *table = NULL;
+  pthread_mutex_lock (&dbg->abbrev_lock);
+  struct libdw_abbrev_table **found = tfind (&key, &dbg->abbrev_tables,
+					     compare_abbrev_table);
+  if (found != NULL)
+    table = *found;
+  else
+    {
+      table = malloc (sizeof *table);
+      if (table != NULL)
+	{
+	  *table = key;
+	  Dwarf_Abbrev_Hash_init (&table->hash, 41);
+	  table->last_offset = offset;
+	  for (size_t i = 0; i < LIBDW_SMALL_ABBREV_CODES; i++)
+	    atomic_init (&table->small[i], NULL);
+	  if (tsearch (table, &dbg->abbrev_tables,
+		       compare_abbrev_table) == NULL)
+	    {
+	      Dwarf_Abbrev_Hash_free (&table->hash);
+	      free (table);
+	      table = NULL;
+	    }
+	}
+      if (table == NULL)
+	__libdw_seterrno (DWARF_E_NOMEM);
+    }
+  pthread_mutex_unlock (&dbg->abbrev_lock);
+
+  return table;
+}
+
+
+/* The size of FORM in CU if it is always the same, otherwise -1.  */
+static size_t
+form_fixed_len (struct Dwarf_CU *cu, unsigned int form)
+{
+  switch (form)
+    {
+    case DW_FORM_flag_present:
+    case DW_FORM_implicit_const:
+      return 0;
+
+    case DW_FORM_flag:
+    case DW_FORM_data1:
+    case DW_FORM_ref1:
+    case DW_FORM_addrx1:
+    case DW_FORM_strx1:
+      return 1;
+
+    case DW_FORM_data2:
+    case DW_FORM_ref2:
+    case DW_FORM_addrx2:
+    case DW_FORM_strx2:
+      return 2;
+
+    case DW_FORM_addrx3:
+    case DW_FORM_strx3:
+      return 3;
+
+    case DW_FORM_data4:
+    case DW_FORM_ref4:
+    case DW_FORM_ref_sup4:
+    case DW_FORM_addrx4:
+    case DW_FORM_strx4:
+      return 4;
+
+    case DW_FORM_ref_sig8:
+    case DW_FORM_data8:
+    case DW_FORM_ref8:
+    case DW_FORM_ref_sup8:
+      return 8;
+
+    case DW_FORM_data16:
+      return 16;
+
+    case DW_FORM_addr:
+      return cu->address_size;
+
+    case DW_FORM_ref_addr:
+      return cu->version == 2 ? cu->address_size : cu->offset_size;
+
+    case DW_FORM_strp:
+    case DW_FORM_strp_sup:
+    case DW_FORM_line_strp:
+    case DW_FORM_sec_offset:
+    case DW_FORM_GNU_ref_alt:
+    case DW_FORM_GNU_strp_alt:
+      return cu->offset_size;
+
+    default:
+      return (size_t) -1;
+    }
+}
+
+
+/* Decode the NATTRS attribute specifications at ATTRP, which were
+   already checked, including the zero pair at the end.  Returns NULL
+   if there are names or forms we cannot store.  */
+static const struct libdw_abbrev_attr *
+decode_attrs (Dwarf *dbg, struct Dwarf_CU *cu, const unsigned char *attrp,
+	      size_t nattrs)
+{
+  struct libdw_abbrev_attr *attrs
+    = libdw_alloc (dbg, struct libdw_abbrev_attr,
+		   sizeof (struct libdw_abbrev_attr), nattrs);
+
+  const unsigned char *const start = attrp;
+  uint32_t offset = 0;
+  for (size_t i = 0; i < nattrs; i++)
+    {
+      unsigned int name;
+      unsigned int form;
+      get_uleb128_unchecked (name, attrp);
+      get_uleb128_unchecked (form, attrp);
+      if (unlikely (name > UINT16_MAX) || unlikely (form > UINT16_MAX))
+	{
+	  libdw_unalloc (dbg, struct libdw_abbrev_attr,
+			 sizeof (struct libdw_abbrev_attr), nattrs);
+	  return NULL;
+	}
+
+      attrs[i].name = name;
+      attrs[i].form = form;
+      if (form == DW_FORM_implicit_const)
+	{
+	  attrs[i].offset = attrp - start;
+	  int64_t value __attribute__ ((unused));
+	  get_sleb128_unchecked (value, attrp);
+	}
+      else
+	{
+	  /* The zero pair at the end gets the size of all attributes,
+	     if they all have a fixed size.  */
+	  attrs[i].offset = offset;
+	  size_t len = form_fixed_len (cu, form);
+	  if (offset != LIBDW_ATTR_OFFSET_UNKNOWN)
+	    offset = (len < LIBDW_ATTR_OFFSET_UNKNOWN - offset
+		      ? offset + len : LIBDW_ATTR_OFFSET_UNKNOWN);
+	}
+    }
+
+  return attrs;
+}
+
+
 Dwarf_Abbrev *
 internal_function
 __libdw_getabbrev (Dwarf *dbg, struct Dwarf_CU *cu, Dwarf_Off offset,
@@ -83,12 +262,13 @@ __libdw_getabbrev (Dwarf *dbg, struct Dwarf_CU *cu, Dwarf_Off offset,
   bool foundit = false;
   Dwarf_Abbrev *abb = NULL;
   if (cu == NULL
-      || (abb = Dwarf_Abbrev_Hash_find (&cu->abbrev_hash, code)) == NULL)
+      || (abb = Dwarf_Abbrev_Hash_find (&cu->abbrevs->hash, code)) == NULL)
     {
       if (result == NULL)
 	abb = libdw_typed_alloc (dbg, Dwarf_Abbrev);
       else
 	abb = result;
+      abb->attrs = NULL;
     }
   else
     {
@@ -126,8 +306,10 @@ __libdw_getabbrev (Dwarf *dbg, struct Dwarf_CU *cu, Dwarf_Off offset,
   /* Skip over all the attributes and check rest of the abbrev is valid.  */
   unsigned int attrname;
   unsigned int attrform;
+  size_t nattrs = 0;
   do
     {
+      ++nattrs;
       if (abbrevp >= end)
 	goto invalid;
       get_uleb128 (attrname, abbrevp, end);
@@ -148,15 +330,23 @@ __libdw_getabbrev (Dwarf *dbg, struct Dwarf_CU *cu, Dwarf_Off offset,
   if (lengthp != NULL)
     *lengthp = abbrevp - start_abbrevp;
 
-  /* Add the entry to the hash table.  */
+  /* Add the entry to the hash table, with its attributes decoded for
+     the units using it.  */
   if (cu != NULL && ! foundit)
-    if (Dwarf_Abbrev_Hash_insert (&cu->abbrev_hash, abb->code, abb) == -1)
-      {
-	/* The entry was already in the table, remove the one we just
-	   created and get the one already inserted.  */
-	libdw_typed_unalloc (dbg, Dwarf_Abbrev);
-	abb = Dwarf_Abbrev_Hash_find (&cu->abbrev_hash, code);
-      }
+    {
+      abb->attrs = decode_attrs (dbg, cu, abb->attrp, nattrs);
+      if (Dwarf_Abbrev_Hash_insert (&cu->abbrevs->hash, abb->code,
+				    abb) == -1)
+	{
+	  /* The entry was already in the table, remove the one we just
+	     created and get the one already inserted.  Only the last
+	     allocation can be given back, the attributes might have
+	     started a new block, so keep both if there are any.  */
+	  if (abb->attrs == NULL)
+	    libdw_typed_unalloc (dbg, Dwarf_Abbrev);
+	  abb = Dwarf_Abbrev_Hash_find (&cu->abbrevs->hash, code);
+	}
+    }
 
  out:
   return abb;
@@ -42,6 +42,91 @@ struct arangelist
   struct arangelist *next;
 };
 
+/* Compare CU DIE offsets, for bsearch.  */
+static int
+compare_offsets (const void *a, const void *b)
+{
+  const Dwarf_Off *o1 = a, *o2 = b;
+  return *o1 < *o2 ? -1 : *o1 > *o2;
+}
+
+/* Add the address ranges of all CUs that have no entries in
+   ARANGELIST, taken from their DW_AT_low_pc/high_pc or DW_AT_ranges.
+   Compilers don't always emit .debug_aranges, or only for some
+   CUs.  */
+static int
+add_missing_cus (Dwarf *dbg, struct arangelist **arangelist,
+		 unsigned int *narangelist)
+{
+  Elf_Data *data = dbg->sectiondata[IDX_debug_info];
+  if (data == NULL)
+    return 0;
+
+  Dwarf_Off *covered = NULL;
+  size_t ncovered = 0;
+  if (*narangelist != 0)
+    {
+      covered = malloc (*narangelist * sizeof covered[0]);
+      if (unlikely (covered == NULL))
+	{
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return -1;
+	}
+      for (struct arangelist *l = *arangelist; l != NULL; l = l->next)
+	covered[ncovered++] = l->arange.offset;
+      qsort (covered, ncovered, sizeof covered[0], compare_offsets);
+    }
+
+  int result = 0;
+  Dwarf_Off off = 0;
+  while (off < data->d_size)
+    {
+      /* Don't fail on units we cannot decode, the caller only asked
+	 for address ranges and those units cannot provide any.  */
+      struct Dwarf_CU *cu = __libdw_findcu (dbg, off, false);
+      if (cu == NULL)
+	break;
+      off = cu->end;
+
+      if (cu->unit_type != DW_UT_compile && cu->unit_type != DW_UT_skeleton)
+	continue;
+
+      Dwarf_Die cudie = CUDIE (cu);
+      Dwarf_Off cudie_off = __libdw_first_die_off_from_cu (cu);
+      if (ncovered != 0
+	  && bsearch (&cudie_off, covered, ncovered, sizeof covered[0],
+		      compare_offsets) != NULL)
+	continue;
+
+      Dwarf_Addr base, start, end;
+      ptrdiff_t offset = 0;
+      while ((offset = INTUSE(dwarf_ranges) (&cudie, offset,
+					     &base, &start, &end)) > 0)
+	{
+	  if (start >= end)
+	    continue;
+
+	  struct arangelist *new_arange = malloc (sizeof *new_arange);
+	  if (unlikely (new_arange == NULL))
+	    {
+	      __libdw_seterrno (DWARF_E_NOMEM);
+	      result = -1;
+	      goto out;
+	    }
+	  new_arange->arange.addr = start;
+	  new_arange->arange.length = end - start;
+	  new_arange->arange.offset = cudie_off;
+	  new_arange->next = *arangelist;
+	  *arangelist = new_arange;
+	  ++*narangelist;
+	}
+    }
+
+ out:
+  free (covered);
+  return result;
+}
+
 /* Compare by Dwarf_Arange.addr, given pointers into an array of pointeers.  */
 static int
 compare_aranges (const void *a, const void *b)
@@ -61,31 +146,34 @@ dwarf_getaranges (Dwarf *dbg, Dwarf_Aranges **aranges, size_t *naranges)
 
   if (dbg->aranges != NULL)
     {
-      *aranges = dbg->aranges;
+      /* An empty result is cached too, but still handed out as NULL.  */
+      *aranges = dbg->aranges->naranges != 0 ? dbg->aranges : NULL;
       if (naranges != NULL)
 	*naranges = dbg->aranges->naranges;
       return 0;
     }
 
-  if (dbg->sectiondata[IDX_debug_aranges] == NULL)
+  /* Prefer the .gdb_index address table when there is one.  GDB
+     generates it from the ranges of all CUs, while .debug_aranges
+     might be missing or only cover some of them.  */
+  if (__libdw_gdb_index_aranges (dbg, aranges, naranges) == 0)
+    return 0;
+
+  /* Without a .debug_aranges section all ranges come from the CUs.  */
+  const unsigned char *readp = NULL;
+  const unsigned char *readendp = NULL;
+  if (dbg->sectiondata[IDX_debug_aranges] != NULL)
     {
-      /* No such section.  */
-      *aranges = NULL;
-      if (naranges != NULL)
-	*naranges = 0;
-      return 0;
-    }
+      if (dbg->sectiondata[IDX_debug_aranges]->d_buf == NULL)
+	return -1;
 
-  if (dbg->sectiondata[IDX_debug_aranges]->d_buf == NULL)
-    return -1;
+      readp = dbg->sectiondata[IDX_debug_aranges]->d_buf;
+      readendp = readp + dbg->sectiondata[IDX_debug_aranges]->d_size;
+    }
 
   struct arangelist *arangelist = NULL;
   unsigned int narangelist = 0;
 
-  const unsigned char *readp = dbg->sectiondata[IDX_debug_aranges]->d_buf;
-  const unsigned char *readendp
-    = readp + dbg->sectiondata[IDX_debug_aranges]->d_size;
-
   while (readp < readendp)
     {
       const unsigned char *hdrstart = readp;
@@ -220,9 +308,19 @@ dwarf_getaranges (Dwarf *dbg, Dwarf_Aranges **aranges, size_t *naranges)
 	}
     }
 
+  if (add_missing_cus (dbg, &arangelist, &narangelist) != 0)
+    goto fail;
+
   if (narangelist == 0)
     {
+      /* Remember that there are none, so the next call doesn't look
+	 at all units again.  */
       assert (arangelist == NULL);
+      Dwarf_Aranges *empty = libdw_alloc (dbg, Dwarf_Aranges,
+					  sizeof (Dwarf_Aranges), 1);
+      empty->dbg = dbg;
+      empty->naranges = 0;
+      dbg->aranges = empty;
       if (naranges != NULL)
 	*naranges = 0;
       *aranges = NULL;
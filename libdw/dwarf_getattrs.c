@@ -117,3 +117,4 @@ dwarf_getattrs (Dwarf_Die *die, int (*callback) (Dwarf_Attribute *, void *),
     }
   /* NOTREACHED */
 }
+INTDEF (dwarf_getattrs)
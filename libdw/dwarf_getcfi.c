@@ -66,7 +66,12 @@ dwarf_getcfi (Dwarf *dbg)
       cfi->default_same_value = false;
 
       cfi->next_offset = 0;
-      cfi->cie_tree = cfi->fde_tree = cfi->expr_tree = NULL;
+      cfi->cie_tree = cfi->fde_tree = NULL;
+      cfi->fde_table = NULL;
+      cfi->fde_table_entries = 0;
+      atomic_store_explicit (&cfi->expr_hash, NULL, memory_order_relaxed);
+      cfi->frame_cache = NULL;
+      cfi->frame_cache_bits = 0;
 
       cfi->ebl = NULL;
 
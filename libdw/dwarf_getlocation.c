@@ -31,7 +31,6 @@
 #endif
 
 #include <dwarf.h>
-#include <search.h>
 #include <stdlib.h>
 #include <assert.h>
 
@@ -105,25 +104,87 @@ struct loclist
 };
 
 
-static int
-loc_compare (const void *p1, const void *p2)
+/* Return the cache in *CACHEP, creating it if it doesn't exist yet.
+   Returns NULL if we run out of memory.  */
+static Dwarf_Loc_Hash *
+loc_hash (_Atomic (Dwarf_Loc_Hash *) *cachep)
 {
-  const struct loc_s *l1 = (const struct loc_s *) p1;
-  const struct loc_s *l2 = (const struct loc_s *) p2;
+  Dwarf_Loc_Hash *htab = atomic_load_explicit (cachep, memory_order_acquire);
+  if (htab != NULL)
+    return htab;
+
+  Dwarf_Loc_Hash *newp = malloc (sizeof (Dwarf_Loc_Hash));
+  if (newp == NULL)
+    return NULL;
+  if (Dwarf_Loc_Hash_init (newp, 31) != 0)
+    {
+      free (newp);
+      return NULL;
+    }
+
+  /* Another thread might have been quicker.  */
+  if (atomic_compare_exchange_strong_explicit (cachep, &htab, newp,
+					       memory_order_acq_rel,
+					       memory_order_acquire))
+    return newp;
 
-  if ((uintptr_t) l1->addr < (uintptr_t) l2->addr)
+  Dwarf_Loc_Hash_free (newp);
+  free (newp);
+  return htab;
+}
+
+/* The addresses of the raw expressions are the keys, which are
+   unique, so we can use them as the hash values directly.  */
+static struct loc_s *
+loc_find (_Atomic (Dwarf_Loc_Hash *) *cachep, const void *addr)
+{
+  Dwarf_Loc_Hash *htab = atomic_load_explicit (cachep, memory_order_acquire);
+  if (htab == NULL)
+    return NULL;
+  return Dwarf_Loc_Hash_find (htab, (uintptr_t) addr);
+}
+
+/* Add LOC to the cache.  Returns zero on success, 1 if another thread
+   added an entry for the same expression first, which is just as good,
+   or -1 if we run out of memory.  */
+static int
+loc_insert (_Atomic (Dwarf_Loc_Hash *) *cachep, struct loc_s *loc)
+{
+  Dwarf_Loc_Hash *htab = loc_hash (cachep);
+  if (htab == NULL)
     return -1;
-  if ((uintptr_t) l1->addr > (uintptr_t) l2->addr)
+  if (Dwarf_Loc_Hash_insert (htab, (uintptr_t) loc->addr, loc) != 0)
     return 1;
-
   return 0;
 }
 
+void
+internal_function
+__libdw_loc_hash_free (Dwarf_Loc_Hash *htab, bool free_entries)
+{
+  if (free_entries)
+    for (size_t i = 1; i <= htab->size; i++)
+      {
+	struct loc_s *loc
+	  = (struct loc_s *) atomic_load_explicit (&htab->table[i].val_ptr,
+						   memory_order_relaxed);
+	if (loc != NULL)
+	  {
+	    free (loc->loc);
+	    free (loc);
+	  }
+      }
+
+  Dwarf_Loc_Hash_free (htab);
+  free (htab);
+}
+
 /* For each DW_OP_implicit_value, we store a special entry in the cache.
    This points us directly to the block data for later fetching.
-   Returns zero on success, -1 on bad DWARF or 1 if tsearch failed.  */
+   Returns zero on success, -1 on bad DWARF or 1 if we ran out of memory.  */
 static int
-store_implicit_value (Dwarf *dbg, void **cache, Dwarf_Op *op)
+store_implicit_value (Dwarf *dbg, _Atomic (Dwarf_Loc_Hash *) *cache,
+		      Dwarf_Op *op)
 {
   if (dbg == NULL)
     return -1;
@@ -135,7 +196,7 @@ store_implicit_value (Dwarf *dbg, void **cache, Dwarf_Op *op)
   block->addr = op;
   block->data = (unsigned char *) data;
   block->length = op->number;
-  if (unlikely (tsearch (block, cache, loc_compare) == NULL))
+  if (unlikely (loc_insert (cache, (struct loc_s *) block) < 0))
     return 1;
   return 0;
 }
@@ -147,16 +208,16 @@ dwarf_getlocation_implicit_value (Dwarf_Attribute *attr, const Dwarf_Op *op,
   if (attr == NULL)
     return -1;
 
-  struct loc_block_s fake = { .addr = (void *) op };
-  struct loc_block_s **found = tfind (&fake, &attr->cu->locs, loc_compare);
+  struct loc_block_s *found
+    = (struct loc_block_s *) loc_find (&attr->cu->locs, op);
   if (unlikely (found == NULL))
     {
       __libdw_seterrno (DWARF_E_NO_BLOCK);
       return -1;
     }
 
-  return_block->length = (*found)->length;
-  return_block->data = (*found)->data;
+  return_block->length = found->length;
+  return_block->data = found->data;
   return 0;
 }
 
@@ -190,8 +251,7 @@ is_constant_offset (Dwarf_Attribute *attr,
     }
 
   /* Check whether we already cached this location.  */
-  struct loc_s fake = { .addr = attr->valp };
-  struct loc_s **found = tfind (&fake, &attr->cu->locs, loc_compare);
+  struct loc_s *found = loc_find (&attr->cu->locs, attr->valp);
 
   if (found == NULL)
     {
@@ -207,7 +267,7 @@ is_constant_offset (Dwarf_Attribute *attr,
       result->number2 = 0;
       result->offset = 0;
 
-      /* Insert a record in the search tree so we can find it again later.  */
+      /* Insert a record in the cache so we can find it again later.  */
       struct loc_s *newp = libdw_alloc (attr->cu->dbg,
 					struct loc_s, sizeof (struct loc_s),
 					1);
@@ -215,14 +275,19 @@ is_constant_offset (Dwarf_Attribute *attr,
       newp->loc = result;
       newp->nloc = 1;
 
-      found = tsearch (newp, &attr->cu->locs, loc_compare);
+      if (unlikely (loc_insert (&attr->cu->locs, newp) < 0))
+	{
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return -1;
+	}
+      found = newp;
     }
 
-  assert ((*found)->nloc == 1);
+  assert (found->nloc == 1);
 
   if (llbuf != NULL)
     {
-      *llbuf = (*found)->loc;
+      *llbuf = found->loc;
       *listlen = 1;
     }
 
@@ -233,7 +298,8 @@ int
 internal_function
 __libdw_intern_expression (Dwarf *dbg, bool other_byte_order,
 			   unsigned int address_size, unsigned int ref_size,
-			   void **cache, const Dwarf_Block *block,
+			   _Atomic (Dwarf_Loc_Hash *) *cache,
+			   const Dwarf_Block *block,
 			   bool cfap, bool valuep,
 			   Dwarf_Op **llbuf, size_t *listlen, int sec_index)
 {
@@ -245,13 +311,12 @@ __libdw_intern_expression (Dwarf *dbg, bool other_byte_order,
     }
 
   /* Check whether we already looked at this list.  */
-  struct loc_s fake = { .addr = block->data };
-  struct loc_s **found = tfind (&fake, cache, loc_compare);
+  struct loc_s *found = loc_find (cache, block->data);
   if (found != NULL)
     {
       /* We already saw it.  */
-      *llbuf = (*found)->loc;
-      *listlen = (*found)->nloc;
+      *llbuf = found->loc;
+      *listlen = found->nloc;
 
       if (valuep)
 	{
@@ -617,7 +682,7 @@ __libdw_intern_expression (Dwarf *dbg, bool other_byte_order,
     }
   while (n > 0);
 
-  /* Insert a record in the search tree so that we can find it again later.  */
+  /* Insert a record in the cache so that we can find it again later.  */
   struct loc_s *newp;
   if (dbg != NULL)
     newp = libdw_alloc (dbg, struct loc_s, sizeof (struct loc_s), 1);
@@ -634,7 +699,20 @@ __libdw_intern_expression (Dwarf *dbg, bool other_byte_order,
   newp->addr = block->data;
   newp->loc = result;
   newp->nloc = *listlen;
-  (void) tsearch (newp, cache, loc_compare);
+  int inserted = loc_insert (cache, newp);
+  if (unlikely (inserted != 0) && dbg == NULL)
+    {
+      /* Nobody else would free ours, use the one in the cache.  */
+      free (result);
+      free (newp);
+      found = inserted > 0 ? loc_find (cache, block->data) : NULL;
+      if (found == NULL)
+	goto nomem;
+      *llbuf = found->loc;
+      *listlen = found->nloc;
+    }
+  else if (unlikely (inserted < 0))
+    goto nomem;
 
   /* We did it.  */
   return 0;
@@ -1011,3 +1089,4 @@ dwarf_getlocations (Dwarf_Attribute *attr, ptrdiff_t offset, Dwarf_Addr *basep,
   return getlocations_addr (attr, offset, basep, startp, endp,
 			    (Dwarf_Word) -1, d, expr, exprlen);
 }
+INTDEF (dwarf_getlocations)
@@ -47,7 +47,14 @@ get_offset_from (Dwarf_Die *die, int name, Dwarf_Word *retp)
     return -1;
 
   /* Offset into the corresponding section.  */
-  return INTUSE(dwarf_formudata) (&attr, retp);
+  if (INTUSE(dwarf_formudata) (&attr, retp) != 0)
+    return -1;
+
+  /* Which is relative to the unit contribution in a .dwp file.  */
+  *retp += __libdw_cu_dwp_offset (die->cu, (name == DW_AT_macro_info
+					    ? IDX_debug_macinfo
+					    : IDX_debug_macro));
+  return 0;
 }
 
 static int
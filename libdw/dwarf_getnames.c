@@ -0,0 +1,608 @@
+/* Look up names in the DWARF 5 .debug_names index.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libdwP.h>
+#include <dwarf.h>
+#include <system.h>
+
+
+static inline Dwarf_Off
+read_offset (Dwarf *dbg, const unsigned char *p, uint8_t offset_size)
+{
+  if (offset_size == 4)
+    return read_4ubyte_unaligned (dbg, p);
+  return read_8ubyte_unaligned (dbg, p);
+}
+
+static int
+compare_abbrevs (const void *a, const void *b)
+{
+  const struct libdw_names_abbrev *a1 = a;
+  const struct libdw_names_abbrev *a2 = b;
+  return a1->code < a2->code ? -1 : a1->code > a2->code;
+}
+
+/* Decode the abbreviation table of INDEX in [READP, ENDP).  */
+static int
+read_abbrevs (struct libdw_names_index *index,
+	      const unsigned char *readp, const unsigned char *endp)
+{
+  size_t allocated = 0;
+  size_t cnt = 0;
+  struct libdw_names_abbrev *abbrevs = NULL;
+
+  while (1)
+    {
+      if (readp >= endp)
+	goto invalid;
+      Dwarf_Word code;
+      get_uleb128 (code, readp, endp);
+      if (code == 0)
+	break;
+
+      if (cnt >= allocated)
+	{
+	  allocated = MAX (16, 2 * allocated);
+	  struct libdw_names_abbrev *newp
+	    = realloc (abbrevs, allocated * sizeof abbrevs[0]);
+	  if (newp == NULL)
+	    {
+	      free (abbrevs);
+	      __libdw_seterrno (DWARF_E_NOMEM);
+	      return -1;
+	    }
+	  abbrevs = newp;
+	}
+
+      if (readp >= endp)
+	goto invalid;
+      Dwarf_Word tag;
+      get_uleb128 (tag, readp, endp);
+      abbrevs[cnt].code = code;
+      abbrevs[cnt].tag = tag;
+      abbrevs[cnt].attrp = readp;
+      ++cnt;
+
+      /* Skip the attribute/form pairs, checking they are terminated
+	 so we can decode them unchecked later.  */
+      Dwarf_Word idx, form;
+      do
+	{
+	  if (readp >= endp)
+	    goto invalid;
+	  get_uleb128 (idx, readp, endp);
+	  if (readp >= endp)
+	    goto invalid;
+	  get_uleb128 (form, readp, endp);
+	}
+      while (idx != 0 || form != 0);
+    }
+
+  qsort (abbrevs, cnt, sizeof abbrevs[0], compare_abbrevs);
+  index->abbrevs = abbrevs;
+  index->nabbrevs = cnt;
+  return 0;
+
+ invalid:
+  free (abbrevs);
+  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+  return -1;
+}
+
+/* Decode the name index header at READP into INDEX.  Returns the end
+   of this name index, or NULL on error.  */
+static const unsigned char *
+read_index (Dwarf *dbg, const unsigned char *readp, const unsigned char *endp,
+	    struct libdw_names_index *index)
+{
+  if (endp - readp < 4)
+    goto invalid;
+  Dwarf_Word len = read_4ubyte_unaligned_inc (dbg, readp);
+  uint8_t offset_size = 4;
+  if (len == DWARF3_LENGTH_64_BIT)
+    {
+      if (endp - readp < 8)
+	goto invalid;
+      len = read_8ubyte_unaligned_inc (dbg, readp);
+      offset_size = 8;
+    }
+  else if (unlikely (len >= DWARF3_LENGTH_MIN_ESCAPE_CODE
+		     && len <= DWARF3_LENGTH_MAX_ESCAPE_CODE))
+    goto invalid;
+
+  if (len > (Dwarf_Word) (endp - readp) || len < 2 + 2 + 7 * 4)
+    goto invalid;
+  const unsigned char *unit_end = readp + len;
+
+  uint16_t version = read_2ubyte_unaligned_inc (dbg, readp);
+  if (unlikely (version != 5))
+    {
+      __libdw_seterrno (DWARF_E_VERSION);
+      return NULL;
+    }
+  readp += 2;			/* Padding.  */
+
+  index->offset_size = offset_size;
+  index->cu_count = read_4ubyte_unaligned_inc (dbg, readp);
+  index->local_tu_count = read_4ubyte_unaligned_inc (dbg, readp);
+  uint32_t foreign_tu_count = read_4ubyte_unaligned_inc (dbg, readp);
+  index->bucket_count = read_4ubyte_unaligned_inc (dbg, readp);
+  index->name_count = read_4ubyte_unaligned_inc (dbg, readp);
+  uint32_t abbrev_table_size = read_4ubyte_unaligned_inc (dbg, readp);
+  uint32_t augmentation_string_size = read_4ubyte_unaligned_inc (dbg, readp);
+
+  /* All counts are 32 bits, so this cannot overflow.  */
+  uint64_t size = ((uint64_t) augmentation_string_size
+		   + ((uint64_t) index->cu_count
+		      + index->local_tu_count) * offset_size
+		   + (uint64_t) foreign_tu_count * 8
+		   + (uint64_t) index->bucket_count * 4
+		   + (index->bucket_count != 0
+		      ? (uint64_t) index->name_count * 4 : 0)
+		   + (uint64_t) index->name_count * 2 * offset_size
+		   + abbrev_table_size);
+  if (size > (uint64_t) (unit_end - readp))
+    goto invalid;
+
+  readp += augmentation_string_size;
+  index->cu_offsets = readp;
+  readp += (size_t) index->cu_count * offset_size;
+  index->local_tu_offsets = readp;
+  readp += (size_t) index->local_tu_count * offset_size;
+  readp += (size_t) foreign_tu_count * 8;
+  index->buckets = readp;
+  readp += (size_t) index->bucket_count * 4;
+  index->hashes = readp;
+  if (index->bucket_count != 0)
+    readp += (size_t) index->name_count * 4;
+  index->str_offsets = readp;
+  readp += (size_t) index->name_count * offset_size;
+  index->entry_offsets = readp;
+  readp += (size_t) index->name_count * offset_size;
+  index->entry_pool = readp + abbrev_table_size;
+  index->end = unit_end;
+
+  if (read_abbrevs (index, readp, index->entry_pool) != 0)
+    return NULL;
+
+  return unit_end;
+
+ invalid:
+  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+  return NULL;
+}
+
+static int
+get_indexes (Dwarf *dbg)
+{
+  size_t allocated = 0;
+  size_t cnt = 0;
+  struct libdw_names_index *mem = NULL;
+  const unsigned char *readp = dbg->sectiondata[IDX_debug_names]->d_buf;
+  const unsigned char *endp = readp + dbg->sectiondata[IDX_debug_names]->d_size;
+
+  while (readp < endp)
+    {
+      if (cnt >= allocated)
+	{
+	  allocated = MAX (4, 2 * allocated);
+	  struct libdw_names_index *newmem
+	    = realloc (mem, allocated * sizeof mem[0]);
+	  if (newmem == NULL)
+	    {
+	      __libdw_seterrno (DWARF_E_NOMEM);
+	      goto err_return;
+	    }
+	  mem = newmem;
+	}
+
+      readp = read_index (dbg, readp, endp, &mem[cnt]);
+      if (readp == NULL)
+	goto err_return;
+      ++cnt;
+    }
+
+  if (cnt == 0)
+    {
+      __libdw_seterrno (DWARF_E_NO_ENTRY);
+      goto err_return;
+    }
+
+  dbg->names_indexes = mem;
+  dbg->names_nindexes = cnt;
+  return 0;
+
+ err_return:
+  for (size_t i = 0; i < cnt; ++i)
+    free (mem[i].abbrevs);
+  free (mem);
+  return -1;
+}
+
+static const struct libdw_names_abbrev *
+find_abbrev (const struct libdw_names_index *index, Dwarf_Word code)
+{
+  size_t l = 0, u = index->nabbrevs;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      if (code < index->abbrevs[idx].code)
+	u = idx;
+      else if (code > index->abbrevs[idx].code)
+	l = idx + 1;
+      else
+	return &index->abbrevs[idx];
+    }
+  return NULL;
+}
+
+/* Read one index attribute value of FORM at *READP.  */
+static int
+read_value (Dwarf *dbg, unsigned int form, const unsigned char **readp,
+	    const unsigned char *endp, Dwarf_Word *value)
+{
+  const unsigned char *p = *readp;
+  size_t len;
+  switch (form)
+    {
+    case DW_FORM_flag_present:
+      *value = 1;
+      return 0;
+
+    case DW_FORM_data1:
+    case DW_FORM_ref1:
+    case DW_FORM_flag:
+      len = 1;
+      break;
+    case DW_FORM_data2:
+    case DW_FORM_ref2:
+      len = 2;
+      break;
+    case DW_FORM_data4:
+    case DW_FORM_ref4:
+      len = 4;
+      break;
+    case DW_FORM_data8:
+    case DW_FORM_ref8:
+    case DW_FORM_ref_sig8:
+      len = 8;
+      break;
+    case DW_FORM_data16:
+      len = 16;
+      break;
+
+    case DW_FORM_udata:
+    case DW_FORM_ref_udata:
+      if (p >= endp)
+	return -1;
+      get_uleb128 (*value, p, endp);
+      *readp = p;
+      return 0;
+    case DW_FORM_sdata:
+      if (p >= endp)
+	return -1;
+      int64_t svalue;
+      get_sleb128 (svalue, p, endp);
+      *value = svalue;
+      *readp = p;
+      return 0;
+
+    default:
+      return -1;
+    }
+
+  if ((size_t) (endp - p) < len)
+    return -1;
+  switch (len)
+    {
+    case 1:
+      *value = *p;
+      break;
+    case 2:
+      *value = read_2ubyte_unaligned (dbg, p);
+      break;
+    case 4:
+      *value = read_4ubyte_unaligned (dbg, p);
+      break;
+    case 8:
+      *value = read_8ubyte_unaligned (dbg, p);
+      break;
+    default:
+      /* Nothing we use, just skip it.  */
+      *value = 0;
+      break;
+    }
+  *readp = p + len;
+  return 0;
+}
+
+/* Return the offset of the unit DIE of the unit at UNIT_OFF in
+   .debug_info, reading just its header.  */
+static Dwarf_Off
+unit_die_offset (Dwarf *dbg, Dwarf_Off unit_off)
+{
+  Elf_Data *data = dbg->sectiondata[IDX_debug_info];
+  if (data == NULL || unit_off > data->d_size || data->d_size - unit_off < 12)
+    return (Dwarf_Off) -1;
+
+  const unsigned char *p = (const unsigned char *) data->d_buf + unit_off;
+  const unsigned char *endp = (const unsigned char *) data->d_buf + data->d_size;
+  uint8_t offset_size = 4;
+  if (read_4ubyte_unaligned_inc (dbg, p) == DWARF3_LENGTH_64_BIT)
+    {
+      offset_size = 8;
+      p += 8;
+    }
+  if (endp - p < 3)
+    return (Dwarf_Off) -1;
+  uint16_t version = read_2ubyte_unaligned_inc (dbg, p);
+  uint8_t unit_type = DW_UT_compile;
+  if (version >= 5)
+    unit_type = *p;
+  if (version < 2 || version > 5
+      || (unit_type != DW_UT_compile && unit_type != DW_UT_partial
+	  && unit_type != DW_UT_skeleton && unit_type != DW_UT_type))
+    return (Dwarf_Off) -1;
+
+  return __libdw_first_die_from_cu_start (unit_off, offset_size,
+					  version, unit_type);
+}
+
+/* Pass all entries of name number NDX (zero based) in INDEX to CALLBACK.
+   NAME is the name string from the name table.  */
+static int
+visit_name (Dwarf *dbg, const struct libdw_names_index *index, uint32_t ndx,
+	    const char *name,
+	    int (*callback) (Dwarf *, Dwarf_Global *, unsigned int, void *),
+	    void *arg)
+{
+  uint8_t offset_size = index->offset_size;
+  Dwarf_Off entry_off = read_offset (dbg, index->entry_offsets
+				     + (size_t) ndx * offset_size,
+				     offset_size);
+  if (entry_off >= (Dwarf_Off) (index->end - index->entry_pool))
+    goto invalid;
+
+  const unsigned char *readp = index->entry_pool + entry_off;
+  while (1)
+    {
+      if (readp >= index->end)
+	goto invalid;
+      Dwarf_Word code;
+      get_uleb128 (code, readp, index->end);
+      if (code == 0)
+	return 0;
+
+      const struct libdw_names_abbrev *abbrev = find_abbrev (index, code);
+      if (unlikely (abbrev == NULL))
+	goto invalid;
+
+      bool has_cu = false, has_tu = false, has_die = false;
+      Dwarf_Word cu = 0, tu = 0, die = 0;
+      const unsigned char *attrp = abbrev->attrp;
+      while (1)
+	{
+	  unsigned int idx, form;
+	  get_uleb128_unchecked (idx, attrp);
+	  get_uleb128_unchecked (form, attrp);
+	  if (idx == 0 && form == 0)
+	    break;
+
+	  Dwarf_Word value;
+	  if (read_value (dbg, form, &readp, index->end, &value) != 0)
+	    goto invalid;
+	  switch (idx)
+	    {
+	    case DW_IDX_compile_unit:
+	      has_cu = true;
+	      cu = value;
+	      break;
+	    case DW_IDX_type_unit:
+	      has_tu = true;
+	      tu = value;
+	      break;
+	    case DW_IDX_die_offset:
+	      has_die = true;
+	      die = value;
+	      break;
+	    default:
+	      break;
+	    }
+	}
+
+      if (! has_die)
+	continue;
+
+      Dwarf_Off unit_off;
+      if (has_tu)
+	{
+	  /* Foreign type units live in some other (split) file.  */
+	  if (tu >= index->local_tu_count)
+	    continue;
+	  unit_off = read_offset (dbg, index->local_tu_offsets
+				  + (size_t) tu * offset_size, offset_size);
+	}
+      else if (has_cu || index->cu_count == 1)
+	{
+	  if (cu >= index->cu_count)
+	    goto invalid;
+	  unit_off = read_offset (dbg, index->cu_offsets
+				  + (size_t) cu * offset_size, offset_size);
+	}
+      else
+	goto invalid;
+
+      Dwarf_Global gl;
+      gl.cu_offset = unit_die_offset (dbg, unit_off);
+      if (gl.cu_offset == (Dwarf_Off) -1)
+	goto invalid;
+      gl.die_offset = unit_off + die;
+      gl.name = name;
+      if (callback (dbg, &gl, abbrev->tag, arg) != DWARF_CB_OK)
+	return 1;
+    }
+
+ invalid:
+  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+  return -1;
+}
+
+/* Return the name string of name number NDX (zero based) in INDEX.  */
+static const char *
+name_string (Dwarf *dbg, const struct libdw_names_index *index, uint32_t ndx)
+{
+  Elf_Data *data = dbg->sectiondata[IDX_debug_str];
+  if (unlikely (data == NULL))
+    {
+      __libdw_seterrno (DWARF_E_NO_DEBUG_STR);
+      return NULL;
+    }
+
+  Dwarf_Off off = read_offset (dbg, index->str_offsets
+			       + (size_t) ndx * index->offset_size,
+			       index->offset_size);
+  if (off >= data->d_size
+      || memchr ((const char *) data->d_buf + off, '\0',
+		 data->d_size - off) == NULL)
+    {
+      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+      return NULL;
+    }
+  return (const char *) data->d_buf + off;
+}
+
+/* The .debug_names hash function is the DJB hash of the case folded
+   name.  We only know how to fold ASCII, ASCII is set to false when
+   NAME contains anything else.  */
+static uint32_t
+names_hash (const char *name, bool *ascii)
+{
+  uint32_t hash = 5381;
+  *ascii = true;
+  for (const unsigned char *p = (const unsigned char *) name; *p != '\0'; ++p)
+    {
+      unsigned char c = *p;
+      if (c >= 0x80)
+	*ascii = false;
+      else if (c >= 'A' && c <= 'Z')
+	c += 'a' - 'A';
+      hash = hash * 33 + c;
+    }
+  return hash;
+}
+
+static int
+lookup_index (Dwarf *dbg, const struct libdw_names_index *index,
+	      const char *name, uint32_t hash, bool use_hash,
+	      int (*callback) (Dwarf *, Dwarf_Global *, unsigned int, void *),
+	      void *arg)
+{
+  uint32_t start = 0;
+  uint32_t end = index->name_count;
+  uint32_t bucket = 0;
+
+  if (use_hash && index->bucket_count != 0)
+    {
+      bucket = hash % index->bucket_count;
+      start = read_4ubyte_unaligned (dbg, index->buckets + 4 * bucket);
+      if (start == 0)
+	return 0;
+      /* Bucket entries are one-based.  */
+      if (unlikely (start > index->name_count))
+	{
+	  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+	  return -1;
+	}
+      --start;
+    }
+  else
+    use_hash = false;
+
+  for (uint32_t ndx = start; ndx < end; ++ndx)
+    {
+      if (use_hash)
+	{
+	  uint32_t h = read_4ubyte_unaligned (dbg, index->hashes + 4 * ndx);
+	  if (h % index->bucket_count != bucket)
+	    break;
+	  if (h != hash)
+	    continue;
+	}
+
+      const char *str = name_string (dbg, index, ndx);
+      if (str == NULL)
+	return -1;
+      if (name != NULL && strcmp (str, name) != 0)
+	continue;
+
+      int res = visit_name (dbg, index, ndx, str, callback, arg);
+      if (res != 0)
+	return res;
+    }
+
+  return 0;
+}
+
+int
+dwarf_getnames (Dwarf *dbg, const char *name,
+		int (*callback) (Dwarf *, Dwarf_Global *, unsigned int, void *),
+		void *arg)
+{
+  if (dbg == NULL)
+    return -1;
+
+  /* Without .debug_names fall back on the symbol table of GDB's
+     .gdb_index, which maps names to CUs.  */
+  if (dbg->sectiondata[IDX_debug_names] == NULL)
+    return __libdw_gdb_index_getnames (dbg, name, callback, arg);
+
+  /* If necessary read the name index headers.  */
+  if (dbg->names_nindexes == 0 && unlikely (get_indexes (dbg) != 0))
+    return -1;
+
+  uint32_t hash = 0;
+  bool use_hash = false;
+  if (name != NULL)
+    hash = names_hash (name, &use_hash);
+
+  for (size_t i = 0; i < dbg->names_nindexes; ++i)
+    {
+      int res = lookup_index (dbg, &dbg->names_indexes[i], name, hash,
+			      use_hash, callback, arg);
+      if (res != 0)
+	return res;
+    }
+
+  return 0;
+}
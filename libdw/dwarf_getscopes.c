@@ -182,12 +182,175 @@ pc_record (unsigned int depth, struct Dwarf_Die_Chain *die, void *arg)
 }
 
 
+static int
+compare_nodes (const void *a, const void *b)
+{
+  size_t n1 = *(const size_t *) a;
+  size_t n2 = *(const size_t *) b;
+  return n1 < n2 ? -1 : n1 > n2;
+}
+
+static int
+compare_origin (const void *key, const void *elem)
+{
+  uintptr_t addr = (uintptr_t) key;
+  uintptr_t origin = (uintptr_t) ((const struct libdw_scope_origin *)
+				  elem)->addr;
+  return addr < origin ? -1 : addr > origin;
+}
+
+/* Find the scopes containing PC with the scope index of the CU, giving
+   the same result as the walk over the DIE tree.  Returns false if the
+   walk is needed after all, otherwise true with the result of
+   dwarf_getscopes in *RESULT.  */
+static bool
+indexed_scopes (const struct libdw_scope_index *index, Dwarf_Die *cudie,
+		Dwarf_Addr pc, Dwarf_Die **scopes, int *result)
+{
+  size_t found_mem[64];
+  size_t *found = found_mem;
+  size_t nfound = __libdw_scope_index_find (index, pc, found_mem, 64);
+  if (nfound > 64)
+    {
+      found = malloc (nfound * sizeof found[0]);
+      if (found == NULL)
+	{
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  *result = -1;
+	  return true;
+	}
+      __libdw_scope_index_find (index, pc, found, nfound);
+    }
+
+  /* The walk only looks at the children of DIEs containing PC.  The
+     first DIE it finds that contains PC and has no such children is
+     the innermost scope.  The nodes are in the order of the walk.  */
+  qsort (found, nfound, sizeof found[0], compare_nodes);
+  const struct libdw_scope_node *nodes = index->nodes;
+  const struct libdw_scope_node *innermost = NULL;
+  for (size_t i = 0; i < nfound; i++)
+    {
+      const struct libdw_scope_node *node = &nodes[found[i]];
+      if (innermost == NULL)
+	{
+	  if (node->depth == 1)
+	    innermost = node;
+	}
+      else if (node->depth <= innermost->depth)
+	/* Past the children of the innermost one.  */
+	break;
+      else if (&nodes[node->parent] == innermost)
+	innermost = node;
+      else
+	{
+	  /* Deeper, but the walk doesn't get there if one of the parents
+	     doesn't contain PC.  Otherwise it is past the children.  */
+	  const struct libdw_scope_node *parent = node;
+	  while (parent->depth > innermost->depth)
+	    parent = &nodes[parent->parent];
+	  if (parent != innermost)
+	    break;
+	}
+    }
+  if (found != found_mem)
+    free (found);
+
+  if (innermost == NULL)
+    {
+      *result = 0;
+      return true;
+    }
+
+  /* The scopes go up to the innermost inlined instance, if any.  */
+  unsigned int inlined = 0;
+  for (const struct libdw_scope_node *node = innermost; node->depth > 0;
+       node = &nodes[node->parent])
+    if (node->inlined)
+      {
+	inlined = node->depth;
+	break;
+      }
+
+  unsigned int nscopes = innermost->depth + 1 - inlined;
+  Dwarf_Die *dies = malloc (nscopes * sizeof dies[0]);
+  if (dies == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      *result = -1;
+      return true;
+    }
+  const struct libdw_scope_node *node = innermost;
+  for (unsigned int i = 0; i < nscopes; i++)
+    {
+      dies[i] = node->depth == 0 ? *cudie : node->die;
+      node = &nodes[node->parent];
+    }
+
+  if (inlined != 0)
+    {
+      /* Continue with the parents of the abstract definition of the
+	 inline function.  */
+      Dwarf_Attribute attr_mem;
+      Dwarf_Attribute *attr = INTUSE(dwarf_attr) (&dies[nscopes - 1],
+						  DW_AT_abstract_origin,
+						  &attr_mem);
+      Dwarf_Die origin;
+      if (INTUSE(dwarf_formref_die) (attr, &origin) == NULL)
+	{
+	  free (dies);
+	  *result = -1;
+	  return true;
+	}
+
+      const struct libdw_scope_origin *o
+	= bsearch (origin.addr, index->origins, index->norigins,
+		   sizeof index->origins[0], compare_origin);
+      if (o == NULL || o->parent == (size_t) -1)
+	{
+	  /* Not a subprogram, or one with more than one place.  */
+	  free (dies);
+	  return false;
+	}
+
+      node = &nodes[o->parent];
+      unsigned int norigin = node->depth + 1;
+      Dwarf_Die *newp = realloc (dies, (nscopes + norigin) * sizeof dies[0]);
+      if (newp == NULL)
+	{
+	  free (dies);
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  *result = -1;
+	  return true;
+	}
+      dies = newp;
+      for (unsigned int i = 0; i < norigin; i++)
+	{
+	  dies[nscopes++] = node->depth == 0 ? *cudie : node->die;
+	  node = &nodes[node->parent];
+	}
+    }
+
+  *scopes = dies;
+  *result = nscopes;
+  return true;
+}
+
+
 int
 dwarf_getscopes (Dwarf_Die *cudie, Dwarf_Addr pc, Dwarf_Die **scopes)
 {
   if (cudie == NULL)
     return -1;
 
+  /* Walking the tree of the CU is only needed once.  */
+  if (is_cudie (cudie))
+    {
+      struct libdw_scope_index *index = __libdw_scope_index (cudie->cu);
+      int result;
+      if (index != NULL && indexed_scopes (index, cudie, pc, scopes, &result))
+	return result;
+    }
+
   struct Dwarf_Die_Chain cu = { .parent = NULL, .die = *cudie };
   struct args a = { .pc = pc };
 
@@ -35,6 +35,54 @@
 #include <assert.h>
 
 
+/* Once this few candidates are left we just count them.  */
+#define LINES_SCAN 16
+
+size_t
+internal_function
+__libdw_lines_upto (Dwarf_Lines *lines, Dwarf_Addr addr)
+{
+  size_t nlines = lines->nlines;
+  size_t start = 0;
+
+  /* Narrow the candidates down without branching on the comparisons,
+     which are unpredictable anyway.  All lines before START are at or
+     below ADDR, all lines from START + NLINES on are above it.  */
+  if (lines->addr_offs != NULL)
+    {
+      if (addr < lines->addr_base)
+	return 0;
+      if (addr - lines->addr_base > UINT32_MAX)
+	return nlines;
+
+      const uint32_t *offs = lines->addr_offs;
+      uint32_t off = addr - lines->addr_base;
+      while (nlines > LINES_SCAN)
+	{
+	  size_t half = nlines / 2;
+	  start = offs[start + half] <= off ? start + half : start;
+	  nlines -= half;
+	}
+
+      size_t count = 0;
+      for (size_t i = 0; i < nlines; ++i)
+	count += offs[start + i] <= off;
+      return start + count;
+    }
+
+  while (nlines > LINES_SCAN)
+    {
+      size_t half = nlines / 2;
+      start = lines->info[start + half].addr <= addr ? start + half : start;
+      nlines -= half;
+    }
+
+  size_t count = 0;
+  for (size_t i = 0; i < nlines; ++i)
+    count += lines->info[start + i].addr <= addr;
+  return start + count;
+}
+
 Dwarf_Line *
 dwarf_getsrc_die (Dwarf_Die *cudie, Dwarf_Addr addr)
 {
@@ -44,29 +92,17 @@ dwarf_getsrc_die (Dwarf_Die *cudie, Dwarf_Addr addr)
   if (INTUSE(dwarf_getsrclines) (cudie, &lines, &nlines) != 0)
     return NULL;
 
-  /* The lines are sorted by address, so we can use binary search.  */
   if (nlines > 0)
     {
-      size_t l = 0, u = nlines - 1;
-      while (l < u)
-	{
-	  size_t idx = u - (u - l) / 2;
-	  Dwarf_Line *line = &lines->info[idx];
-	  if (addr < line->addr)
-	    u = idx - 1;
-	  else
-	    l = idx;
-	}
-
       /* This is guaranteed for us by libdw read_srclines.  */
       assert (lines->info[nlines - 1].end_sequence);
 
       /* The last line which is less than or equal to addr is what we
 	 want, unless it is the end_sequence which is after the
 	 current line sequence.  */
-      Dwarf_Line *line = &lines->info[l];
-      if (! line->end_sequence && line->addr <= addr)
-	return &lines->info[l];
+      size_t n = __libdw_lines_upto (lines, addr);
+      if (n > 0 && ! lines->info[n - 1].end_sequence)
+	return &lines->info[n - 1];
     }
 
   __libdw_seterrno (DWARF_E_ADDR_OUTOFRANGE);
@@ -48,18 +48,17 @@ dwarf_getsrcfiles (Dwarf_Die *cudie, Dwarf_Files **files, size_t *nfiles)
 
   int res = -1;
 
-  /* Get the information if it is not already known.  */
+  /* Get the information if it is not already known.  Like in
+     dwarf_getsrclines other threads may do the same at the same time.  */
   struct Dwarf_CU *const cu = cudie->cu;
-  if (cu->files == NULL)
+  Dwarf_Files *cu_files = __libdw_cu_files (cu);
+  if (cu_files == NULL)
     {
       /* For split units there might be a simple file table (without lines).
 	 If not, use the one from the skeleton.  */
       if (cu->unit_type == DW_UT_split_compile
 	  || cu->unit_type == DW_UT_split_type)
 	{
-	  /* We tried, assume we fail...  */
-	  cu->files = (void *) -1;
-
 	  /* See if there is a .debug_line section, for split CUs
 	     the table is at offset zero.  */
 	  if (cu->dbg->sectiondata[IDX_debug_line] != NULL)
@@ -69,7 +68,7 @@ dwarf_getsrcfiles (Dwarf_Die *cudie, Dwarf_Files **files, size_t *nfiles)
 	      res = __libdw_getsrclines (cu->dbg, 0,
 					 __libdw_getcompdir (cudie),
 					 cu->address_size, NULL,
-					 &cu->files);
+					 &cu_files);
 	    }
 	  else
 	    {
@@ -77,10 +76,14 @@ dwarf_getsrcfiles (Dwarf_Die *cudie, Dwarf_Files **files, size_t *nfiles)
 	      if (skel != NULL)
 		{
 		  Dwarf_Die skeldie = CUDIE (skel);
-		  res = INTUSE(dwarf_getsrcfiles) (&skeldie, files, nfiles);
-		  cu->files = skel->files;
+		  res = INTUSE(dwarf_getsrcfiles) (&skeldie, &cu_files, NULL);
 		}
 	    }
+
+	  /* We tried, if we failed don't try again.  */
+	  if (res != 0)
+	    cu_files = (void *) -1l;
+	  atomic_store_explicit (&cu->files, cu_files, memory_order_release);
 	}
       else
 	{
@@ -90,22 +93,21 @@ dwarf_getsrcfiles (Dwarf_Die *cudie, Dwarf_Files **files, size_t *nfiles)
 	  /* Let the more generic function do the work.  It'll create more
 	     data but that will be needed in an real program anyway.  */
 	  res = INTUSE(dwarf_getsrclines) (cudie, &lines, &nlines);
+	  cu_files = __libdw_cu_files (cu);
 	}
     }
-  else if (cu->files != (void *) -1l)
+  else if (cu_files != (void *) -1l)
     /* We already have the information.  */
     res = 0;
 
   if (likely (res == 0))
     {
-      assert (cu->files != NULL && cu->files != (void *) -1l);
-      *files = cu->files;
+      assert (cu_files != NULL && cu_files != (void *) -1l);
+      *files = cu_files;
       if (nfiles != NULL)
-	*nfiles = cu->files->nfiles;
+	*nfiles = cu_files->nfiles;
     }
 
-  // XXX Eventually: unlocking here.
-
   return res;
 }
 INTDEF (dwarf_getsrcfiles)
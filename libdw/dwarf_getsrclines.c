@@ -45,36 +45,202 @@ struct filelist
   struct filelist *next;
 };
 
-struct linelist
+/* Compare by Dwarf_Line.addr.  */
+static inline int
+compare_lines (const Dwarf_Line *line1, const Dwarf_Line *line2)
 {
-  Dwarf_Line line;
-  struct linelist *next;
-  size_t sequence;
+  if (line1->addr != line2->addr)
+    return (line1->addr < line2->addr) ? -1 : 1;
+
+  /* An end_sequence marker precedes a normal record at the same address.  */
+  return (int) line2->end_sequence - (int) line1->end_sequence;
+}
+
+/* A run of line records that are already sorted, from START up to
+   END in the decoded records.  */
+struct line_run
+{
+  size_t start;
+  size_t end;
 };
 
+/* Whether the next record of run A goes before that of run B.  Runs
+   never overlap in the decoded records, so the one that started first
+   holds the record that was decoded first.  */
+static inline bool
+run_before (const Dwarf_Line *lines, const struct line_run *a,
+	    const struct line_run *b)
+{
+  int res = compare_lines (&lines[a->start], &lines[b->start]);
+  return res < 0 || (res == 0 && a->start < b->start);
+}
+
+/* Restore the heap property of the NRUNS runs in HEAP after the run
+   at I changed.  */
+static void
+sift_down_run (const Dwarf_Line *lines, struct line_run *heap, size_t nruns,
+	       size_t i)
+{
+  struct line_run run = heap[i];
+  while (2 * i + 1 < nruns)
+    {
+      size_t child = 2 * i + 1;
+      if (child + 1 < nruns
+	  && run_before (lines, &heap[child + 1], &heap[child]))
+	child++;
+      if (! run_before (lines, &heap[child], &run))
+	break;
+      heap[i] = heap[child];
+      i = child;
+    }
+  heap[i] = run;
+}
 
-/* Compare by Dwarf_Line.addr, given pointers into an array of pointers.  */
+/* Compare runs by their position in the decoded records.  */
 static int
-compare_lines (const void *a, const void *b)
+compare_run_starts (const void *a, const void *b)
 {
-  struct linelist *const *p1 = a;
-  struct linelist *const *p2 = b;
-  struct linelist *list1 = *p1;
-  struct linelist *list2 = *p2;
-  Dwarf_Line *line1 = &list1->line;
-  Dwarf_Line *line2 = &list2->line;
+  const struct line_run *run1 = a;
+  const struct line_run *run2 = b;
 
-  if (line1->addr != line2->addr)
-    return (line1->addr < line2->addr) ? -1 : 1;
+  return (run1->start < run2->start) ? -1 : run1->start > run2->start;
+}
 
-  /* An end_sequence marker precedes a normal record at the same address.  */
-  if (line1->end_sequence != line2->end_sequence)
-    return line2->end_sequence - line1->end_sequence;
+/* Merge the sorted records SRC[START..MID) and SRC[MID..END) into
+   DST[START..END).  Records that compare equal are kept in order.  */
+static void
+merge_lines (const Dwarf_Line *src, size_t start, size_t mid, size_t end,
+	     Dwarf_Line *dst)
+{
+  size_t i = start;
+  size_t j = mid;
+  size_t k = start;
+
+  while (i < mid && j < end)
+    dst[k++] = (compare_lines (&src[j], &src[i]) < 0) ? src[j++] : src[i++];
+  while (i < mid)
+    dst[k++] = src[i++];
+  while (j < end)
+    dst[k++] = src[j++];
+}
+
+/* Put the NLINES decoded line records of LINES into SORTED in
+   ascending address order.  Records at the same address stay in the
+   order they were decoded.  LINES might be clobbered.
+
+   Within a sequence the addresses only increase, so the records come
+   in runs that are already sorted, which are merged here.  Normally
+   the runs hardly overlap, so we copy as much of the first run as
+   possible before looking at the others again.  But if the runs do
+   overlap a lot, like in relocatable files where all sequences start
+   at zero, we merge neighboring runs instead.  Returns -1 if we are
+   out of memory, zero otherwise.  */
+static int
+sort_lines (Dwarf_Line *lines, size_t nlines, Dwarf_Line *sorted)
+{
+  size_t nruns = nlines > 0;
+  for (size_t i = 1; i < nlines; i++)
+    if (compare_lines (&lines[i - 1], &lines[i]) > 0)
+      nruns++;
+
+  if (nruns <= 1)
+    {
+      memcpy (sorted, lines, nlines * sizeof (Dwarf_Line));
+      return 0;
+    }
+
+  struct line_run *heap = malloc (nruns * sizeof (struct line_run));
+  if (heap == NULL)
+    return -1;
+
+  size_t n = 0;
+  heap[0].start = 0;
+  for (size_t i = 1; i < nlines; i++)
+    if (compare_lines (&lines[i - 1], &lines[i]) > 0)
+      {
+	heap[n].end = i;
+	heap[++n].start = i;
+      }
+  heap[n].end = nlines;
+
+  for (size_t i = nruns / 2; i-- > 0; )
+    sift_down_run (lines, heap, nruns, i);
+
+  Dwarf_Line *dst = sorted;
+  size_t switches = 0;
+  while (nruns > 1)
+    {
+      /* The run with the next record to go before all others is one
+	 of the children of the top.  */
+      struct line_run *top = &heap[0];
+      struct line_run *next = &heap[1];
+      if (nruns > 2 && run_before (lines, &heap[2], next))
+	next = &heap[2];
+
+      do
+	*dst++ = lines[top->start++];
+      while (top->start < top->end && run_before (lines, top, next));
+
+      if (top->start == top->end)
+	heap[0] = heap[--nruns];
+      sift_down_run (lines, heap, nruns, 0);
+
+      /* Going through the heap for only a few records at a time costs
+	 more than merging neighboring runs.  */
+      size_t done = dst - sorted;
+      if (++switches > done / 2 && done >= 1024)
+	break;
+    }
+
+  if (nruns > 1)
+    {
+      /* Everything still in the runs goes after what we have sorted
+	 so far.  Move the rest of the runs there, in the order they
+	 were decoded, and merge neighbors, going back and forth with
+	 LINES, which we don't need anymore, until one run is left.  */
+      qsort (heap, nruns, sizeof (struct line_run), compare_run_starts);
+      size_t left = 0;
+      for (size_t r = 0; r < nruns; r++)
+	{
+	  size_t len = heap[r].end - heap[r].start;
+	  memcpy (&dst[left], &lines[heap[r].start],
+		  len * sizeof (Dwarf_Line));
+	  heap[r].start = left;
+	  heap[r].end = left + len;
+	  left += len;
+	}
+
+      Dwarf_Line *src = dst;
+      Dwarf_Line *tmp = lines;
+      while (nruns > 1)
+	{
+	  size_t nmerged = 0;
+	  for (size_t r = 0; r < nruns; r += 2)
+	    {
+	      size_t start = heap[r].start;
+	      size_t mid = heap[r].end;
+	      size_t end = r + 1 < nruns ? heap[r + 1].end : mid;
+	      merge_lines (src, start, mid, end, tmp);
+	      heap[nmerged].start = start;
+	      heap[nmerged].end = end;
+	      nmerged++;
+	    }
+	  nruns = nmerged;
+
+	  Dwarf_Line *swap = src;
+	  src = tmp;
+	  tmp = swap;
+	}
 
-  /* Otherwise, the linelist sequence maintains a stable sort.  */
-  return (list1->sequence < list2->sequence) ? -1
-    : (list1->sequence > list2->sequence) ? 1
-    : 0;
+      if (src != dst)
+	memcpy (dst, src, left * sizeof (Dwarf_Line));
+    }
+  else
+    memcpy (dst, &lines[heap[0].start],
+	    (heap[0].end - heap[0].start) * sizeof (Dwarf_Line));
+
+  free (heap);
+  return 0;
 }
 
 struct line_state
@@ -90,8 +256,9 @@ struct line_state
   bool epilogue_begin;
   unsigned int isa;
   unsigned int discriminator;
-  struct linelist *linelist;
+  Dwarf_Line *linelist;
   size_t nlinelist;
+  size_t nalloclines;
   unsigned int end_sequence;
 };
 
@@ -104,17 +271,36 @@ run_advance_pc (struct line_state *state, unsigned int op_advance,
   state->op_index = (state->op_index + op_advance) % max_ops_per_instr;
 }
 
+/* Make room for more lines, moving them off the stack STACK_LINES
+   the first time.  Returns true if we are out of memory.  */
+static bool
+grow_lines (struct line_state *state, Dwarf_Line *stack_lines)
+{
+  if (state->nalloclines > SIZE_MAX / 2 / sizeof (Dwarf_Line))
+    return true;
+
+  size_t nalloc = state->nalloclines * 2;
+  Dwarf_Line *newp;
+  if (state->linelist == stack_lines)
+    {
+      newp = malloc (nalloc * sizeof (Dwarf_Line));
+      if (newp != NULL)
+	memcpy (newp, stack_lines, state->nlinelist * sizeof (Dwarf_Line));
+    }
+  else
+    newp = realloc (state->linelist, nalloc * sizeof (Dwarf_Line));
+  if (newp == NULL)
+    return true;
+
+  state->linelist = newp;
+  state->nalloclines = nalloc;
+  return false;
+}
+
 static inline bool
-add_new_line (struct line_state *state, struct linelist *new_line)
+add_new_line (struct line_state *state)
 {
-  /* Set the line information.  For some fields we use bitfields,
-     so we would lose information if the encoded values are too large.
-     Check just for paranoia, and call the data "invalid" if it
-     violates our assumptions on reasonable limits for the values.  */
-  new_line->next = state->linelist;
-  new_line->sequence = state->nlinelist;
-  state->linelist = new_line;
-  ++(state->nlinelist);
+  Dwarf_Line *new_line = &state->linelist[state->nlinelist++];
 
   /* Set the line information.  For some fields we use bitfields,
      so we would lose information if the encoded values are too large.
@@ -122,8 +308,8 @@ add_new_line (struct line_state *state, struct linelist *new_line)
      violates our assumptions on reasonable limits for the values.  */
 #define SET(field)						      \
   do {								      \
-     new_line->line.field = state->field;			      \
-     if (unlikely (new_line->line.field != state->field))	      \
+     new_line->field = state->field;				      \
+     if (unlikely (new_line->field != state->field))		      \
        return true;						      \
    } while (0)
 
@@ -170,6 +356,7 @@ read_srclines (Dwarf *dbg,
     {
       .linelist = NULL,
       .nlinelist = 0,
+      .nalloclines = 0,
       .addr = 0,
       .op_index = 0,
       .file = 1,
@@ -667,18 +854,19 @@ read_srclines (Dwarf *dbg,
 
   /* Process the instructions.  */
 
-  /* Adds a new line to the matrix.  For the first MAX_STACK_LINES
-     entries just return a slot in the preallocated stack array.  */
-  struct linelist llstack[MAX_STACK_LINES];
+  /* Adds a new line to the matrix.  The first MAX_STACK_LINES entries
+     go into the preallocated stack array, after that into a malloced
+     array that doubles in size when full.  */
+  Dwarf_Line llstack[MAX_STACK_LINES];
+  state.linelist = llstack;
+  state.nalloclines = MAX_STACK_LINES;
 #define NEW_LINE(end_seq)						\
   do {								\
-    struct linelist *ll = (state.nlinelist < MAX_STACK_LINES	\
-			   ? &llstack[state.nlinelist]		\
-			   : malloc (sizeof (struct linelist)));	\
-    if (unlikely (ll == NULL))					\
+    if (unlikely (state.nlinelist == state.nalloclines)		\
+	&& unlikely (grow_lines (&state, llstack)))		\
       goto no_mem;						\
     state.end_sequence = end_seq;				\
-    if (unlikely (add_new_line (&state, ll)))			\
+    if (unlikely (add_new_line (&state)))			\
       goto invalid_data;						\
   } while (0)
 
@@ -1014,40 +1202,48 @@ read_srclines (Dwarf *dbg,
   if (filesp != NULL)
     *filesp = files;
 
-  size_t buf_size = (sizeof (Dwarf_Lines)
-		     + (sizeof (Dwarf_Line) * state.nlinelist));
-  void *buf = libdw_alloc (dbg, Dwarf_Lines, buf_size, 1);
-
-  /* First use the buffer for the pointers, and sort the entries.
-     We'll write the pointers in the end of the buffer, and then
-     copy into the buffer from the beginning so the overlap works.  */
-  assert (sizeof (Dwarf_Line) >= sizeof (struct linelist *));
-  struct linelist **sortlines = (buf + buf_size
-				 - sizeof (struct linelist **) * state.nlinelist);
-
-  /* The list is in LIFO order and usually they come in clumps with
-     ascending addresses.  So fill from the back to probably start with
-     runs already in order before we sort.  */
-  struct linelist *lineslist = state.linelist;
-  for (size_t i = state.nlinelist; i-- > 0; )
+  /* The addresses are also put in a column of 32-bit offsets, if
+     they fit.  */
+  bool addr_column = false;
+  if (state.nlinelist > 0)
     {
-      sortlines[i] = lineslist;
-      lineslist = lineslist->next;
+      Dwarf_Addr lowest = (Dwarf_Addr) -1;
+      Dwarf_Addr highest = 0;
+      for (size_t i = 0; i < state.nlinelist; ++i)
+	{
+	  if (state.linelist[i].addr < lowest)
+	    lowest = state.linelist[i].addr;
+	  if (state.linelist[i].addr > highest)
+	    highest = state.linelist[i].addr;
+	}
+      addr_column = highest - lowest <= UINT32_MAX;
     }
-  assert (lineslist == NULL);
 
-  /* Sort by ascending address.  */
-  qsort (sortlines, state.nlinelist, sizeof sortlines[0], &compare_lines);
+  Dwarf_Lines *lines = libdw_alloc (dbg, Dwarf_Lines,
+				    (sizeof (Dwarf_Lines)
+				     + (sizeof (Dwarf_Line)
+					* state.nlinelist)
+				     + (addr_column
+					? sizeof (uint32_t) * state.nlinelist
+					: 0)), 1);
+
+  /* Sort by ascending address into the final array.  */
+  if (sort_lines (state.linelist, state.nlinelist, lines->info) != 0)
+    goto no_mem;
 
-  /* Now that they are sorted, put them in the final array.
-     The buffers overlap, so we've clobbered the early elements
-     of SORTLINES by the time we're reading the later ones.  */
-  Dwarf_Lines *lines = buf;
   lines->nlines = state.nlinelist;
   for (size_t i = 0; i < state.nlinelist; ++i)
+    lines->info[i].files = files;
+
+  lines->addr_offs = NULL;
+  lines->addr_base = 0;
+  if (addr_column)
     {
-      lines->info[i] = sortlines[i]->line;
-      lines->info[i].files = files;
+      uint32_t *addr_offs = (uint32_t *) &lines->info[state.nlinelist];
+      lines->addr_base = lines->info[0].addr;
+      for (size_t i = 0; i < state.nlinelist; ++i)
+	addr_offs[i] = lines->info[i].addr - lines->addr_base;
+      lines->addr_offs = addr_offs;
     }
 
   /* Make sure the highest address for the CU is marked as end_sequence.
@@ -1065,12 +1261,8 @@ read_srclines (Dwarf *dbg,
 
  out:
   /* Free malloced line records, if any.  */
-  for (size_t i = MAX_STACK_LINES; i < state.nlinelist; i++)
-    {
-      struct linelist *ll = state.linelist->next;
-      free (state.linelist);
-      state.linelist = ll;
-    }
+  if (state.nalloclines > MAX_STACK_LINES)
+    free (state.linelist);
   if (dirarray != dirstack)
     free (dirarray);
   for (size_t i = MAX_STACK_FILES; i < nfilelist; i++)
@@ -1104,8 +1296,10 @@ __libdw_getsrclines (Dwarf *dbg, Dwarf_Off debug_line_offset,
 		     Dwarf_Lines **linesp, Dwarf_Files **filesp)
 {
   struct files_lines_s fake = { .debug_line_offset = debug_line_offset };
+  pthread_mutex_lock (&dbg->lines_lock);
   struct files_lines_s **found = tfind (&fake, &dbg->files_lines,
 					files_lines_compare);
+  pthread_mutex_unlock (&dbg->lines_lock);
   if (found == NULL)
     {
       Elf_Data *data = __libdw_checked_get_data (dbg, IDX_debug_line);
@@ -1126,7 +1320,11 @@ __libdw_getsrclines (Dwarf *dbg, Dwarf_Off debug_line_offset,
 
       node->debug_line_offset = debug_line_offset;
 
+      /* The line table is read without holding the lock.  If another
+	 thread added the same table in the meantime we use that one.  */
+      pthread_mutex_lock (&dbg->lines_lock);
       found = tsearch (node, &dbg->files_lines, files_lines_compare);
+      pthread_mutex_unlock (&dbg->lines_lock);
       if (found == NULL)
 	{
 	  __libdw_seterrno (DWARF_E_NOMEM);
@@ -1165,39 +1363,32 @@ dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines, size_t *nlines)
       return -1;
     }
 
-  /* Get the information if it is not already known.  */
+  /* Get the information if it is not already known.  Other threads may
+     do the same at the same time.  They read the same tables, since
+     __libdw_getsrclines keeps them by offset, and publish the same
+     pointers, the files before the lines.  */
   struct Dwarf_CU *const cu = cudie->cu;
-  if (cu->lines == NULL)
+  Dwarf_Lines *cu_lines = __libdw_cu_lines (cu);
+  if (cu_lines == NULL)
     {
       /* For split units always pick the lines from the skeleton.  */
       if (cu->unit_type == DW_UT_split_compile
 	  || cu->unit_type == DW_UT_split_type)
 	{
-	  /* We tries, assume we fail...  */
-	  cu->lines = (void *) -1l;
-
 	  Dwarf_CU *skel = __libdw_find_split_unit (cu);
-	  if (skel != NULL)
+	  if (skel == NULL)
 	    {
-	      Dwarf_Die skeldie = CUDIE (skel);
-	      int res = INTUSE(dwarf_getsrclines) (&skeldie, lines, nlines);
-	      if (res == 0)
-		{
-		  cu->lines = skel->lines;
-		  *lines = cu->lines;
-		  *nlines = cu->lines->nlines;
-		}
-	      return res;
+	      __libdw_seterrno (DWARF_E_NO_DEBUG_LINE);
+	      return -1;
 	    }
 
-	  __libdw_seterrno (DWARF_E_NO_DEBUG_LINE);
-	  return -1;
+	  Dwarf_Die skeldie = CUDIE (skel);
+	  int res = INTUSE(dwarf_getsrclines) (&skeldie, lines, nlines);
+	  if (res == 0)
+	    atomic_store_explicit (&cu->lines, *lines, memory_order_release);
+	  return res;
 	}
 
-      /* Failsafe mode: no data found.  */
-      cu->lines = (void *) -1l;
-      cu->files = (void *) -1l;
-
       /* The die must have a statement list associated.  */
       Dwarf_Attribute stmt_list_mem;
       Dwarf_Attribute *stmt_list = INTUSE(dwarf_attr) (cudie, DW_AT_stmt_list,
@@ -1206,22 +1397,27 @@ dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines, size_t *nlines)
       /* Get the offset into the .debug_line section.  NB: this call
 	 also checks whether the previous dwarf_attr call failed.  */
       Dwarf_Off debug_line_offset;
+      Dwarf_Files *cu_files;
       if (__libdw_formptr (stmt_list, IDX_debug_line, DWARF_E_NO_DEBUG_LINE,
-			   NULL, &debug_line_offset) == NULL)
-	return -1;
+			   NULL, &debug_line_offset) == NULL
+	  || __libdw_getsrclines (cu->dbg, debug_line_offset,
+				  __libdw_getcompdir (cudie),
+				  cu->address_size, &cu_lines, &cu_files) < 0)
+	{
+	  /* Failsafe mode: no data found, don't try again.  */
+	  cu_lines = (void *) -1l;
+	  cu_files = (void *) -1l;
+	}
 
-      if (__libdw_getsrclines (cu->dbg, debug_line_offset,
-			       __libdw_getcompdir (cudie),
-			       cu->address_size, &cu->lines, &cu->files) < 0)
-	return -1;
+      atomic_store_explicit (&cu->files, cu_files, memory_order_release);
+      atomic_store_explicit (&cu->lines, cu_lines, memory_order_release);
     }
-  else if (cu->lines == (void *) -1l)
-    return -1;
 
-  *lines = cu->lines;
-  *nlines = cu->lines->nlines;
+  if (cu_lines == (void *) -1l)
+    return -1;
 
-  // XXX Eventually: unlocking here.
+  *lines = cu_lines;
+  *nlines = cu_lines->nlines;
 
   return 0;
 }
@@ -0,0 +1,158 @@
+/* Call a function for all units of a Dwarf from multiple threads.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libdwP.h"
+
+
+struct unit_work
+{
+  Dwarf_CU **units;
+  size_t nunits;
+
+  /* Index of the next unit to hand out.  */
+  atomic_size_t next;
+  atomic_bool aborted;
+
+  int (*callback) (Dwarf_CU *, Dwarf_Die *, void *);
+  void *arg;
+};
+
+
+static int
+compare_unit_size (const void *a, const void *b)
+{
+  const Dwarf_CU *cu1 = *(const Dwarf_CU **) a;
+  const Dwarf_CU *cu2 = *(const Dwarf_CU **) b;
+  Dwarf_Off size1 = cu1->end - cu1->start;
+  Dwarf_Off size2 = cu2->end - cu2->start;
+
+  /* Largest first.  */
+  return size1 > size2 ? -1 : size1 < size2;
+}
+
+
+static void *
+unit_worker (void *arg)
+{
+  struct unit_work *work = arg;
+
+  while (! atomic_load_explicit (&work->aborted, memory_order_relaxed))
+    {
+      size_t n = atomic_fetch_add_explicit (&work->next, 1,
+					    memory_order_relaxed);
+      if (n >= work->nunits)
+	break;
+
+      Dwarf_CU *cu = work->units[n];
+      Dwarf_Die cudie;
+      if (cu->version >= 2 && cu->version <= 5
+	  && cu->unit_type >= DW_UT_compile
+	  && cu->unit_type <= DW_UT_split_type)
+	cudie = CUDIE (cu);
+      else
+	memset (&cudie, '\0', sizeof (Dwarf_Die));
+
+      if (work->callback (cu, &cudie, work->arg) != DWARF_CB_OK)
+	atomic_store_explicit (&work->aborted, true, memory_order_relaxed);
+    }
+
+  return NULL;
+}
+
+
+int
+dwarf_parallel_units (Dwarf *dwarf, unsigned int nthreads,
+		      int (*callback) (Dwarf_CU *, Dwarf_Die *, void *),
+		      void *arg)
+{
+  if (dwarf == NULL)
+    return -1;
+
+  Dwarf_CU *const *units;
+  size_t nunits;
+  if (INTUSE(dwarf_get_unit_list) (dwarf, &units, &nunits) != 0)
+    return -1;
+
+  /* Hand out the largest units first, so a big unit at the end
+     doesn't keep one thread busy while the others are idle.  */
+  struct unit_work work;
+  work.units = malloc (nunits * sizeof (Dwarf_CU *));
+  if (work.units == NULL && nunits > 0)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return -1;
+    }
+  if (nunits > 0)
+    memcpy (work.units, units, nunits * sizeof (Dwarf_CU *));
+  qsort (work.units, nunits, sizeof (Dwarf_CU *), compare_unit_size);
+  work.nunits = nunits;
+  atomic_init (&work.next, 0);
+  atomic_init (&work.aborted, false);
+  work.callback = callback;
+  work.arg = arg;
+
+  if (nthreads == 0)
+    {
+      long int nprocs = sysconf (_SC_NPROCESSORS_ONLN);
+      nthreads = nprocs > 0 ? (unsigned int) nprocs : 1;
+    }
+  if (nthreads > nunits)
+    nthreads = nunits;
+
+  /* The calling thread does its share of the work too.  If we cannot
+     create as many threads as requested, we just use fewer.  */
+  pthread_t *threads = NULL;
+  size_t nstarted = 0;
+  if (nthreads > 1)
+    {
+      threads = malloc ((nthreads - 1) * sizeof (pthread_t));
+      if (threads != NULL)
+	while (nstarted < nthreads - 1
+	       && pthread_create (&threads[nstarted], NULL,
+				  unit_worker, &work) == 0)
+	  nstarted++;
+    }
+
+  unit_worker (&work);
+
+  for (size_t i = 0; i < nstarted; i++)
+    pthread_join (threads[i], NULL);
+
+  free (threads);
+  free (work.units);
+
+  return atomic_load_explicit (&work.aborted, memory_order_relaxed) ? 1 : 0;
+}
@@ -45,34 +45,47 @@ __libdw_findabbrev (struct Dwarf_CU *cu, unsigned int code)
     return DWARF_END_ABBREV;
 
   /* See whether the entry is already in the hash table.  */
-  abb = Dwarf_Abbrev_Hash_find (&cu->abbrev_hash, code);
+  abb = Dwarf_Abbrev_Hash_find (&cu->abbrevs->hash, code);
   if (abb == NULL)
-    while (cu->last_abbrev_offset != (size_t) -1l)
-      {
-	size_t length;
-
-	/* Find the next entry.  It gets automatically added to the
-	   hash table.  */
-	abb = __libdw_getabbrev (cu->dbg, cu, cu->last_abbrev_offset, &length,
-				 NULL);
-	if (abb == NULL || abb == DWARF_END_ABBREV)
+    {
+      /* Only one thread reads more abbreviations, another might have
+	 added the one we are looking for in the meantime.  */
+      pthread_mutex_lock (&cu->dbg->abbrev_lock);
+      abb = Dwarf_Abbrev_Hash_find (&cu->abbrevs->hash, code);
+      if (abb == NULL)
+	while (cu->abbrevs->last_offset != (size_t) -1l)
 	  {
-	    /* Make sure we do not try to search for it again.  */
-	    cu->last_abbrev_offset = (size_t) -1l;
-	    return DWARF_END_ABBREV;
+	    size_t length;
+
+	    /* Find the next entry.  It gets automatically added to the
+	       hash table.  */
+	    abb = __libdw_getabbrev (cu->dbg, cu, cu->abbrevs->last_offset,
+				     &length, NULL);
+	    if (abb == NULL || abb == DWARF_END_ABBREV)
+	      {
+		/* Make sure we do not try to search for it again.  */
+		cu->abbrevs->last_offset = (size_t) -1l;
+		abb = NULL;
+		break;
+	      }
+
+	    cu->abbrevs->last_offset += length;
+
+	    /* Is this the code we are looking for?  */
+	    if (abb->code == code)
+	      break;
 	  }
-
-	cu->last_abbrev_offset += length;
-
-	/* Is this the code we are looking for?  */
-	if (abb->code == code)
-	  break;
-      }
+      pthread_mutex_unlock (&cu->dbg->abbrev_lock);
+    }
 
   /* This is our second (or third, etc.) call to __libdw_findabbrev
      and the code is invalid.  */
   if (unlikely (abb == NULL))
     abb = DWARF_END_ABBREV;
+  else if (code < LIBDW_SMALL_ABBREV_CODES)
+    /* Next time __libdw_dieabbrev finds it without hashing.  */
+    atomic_store_explicit (&cu->abbrevs->small[code], abb,
+			   memory_order_release);
 
   return abb;
 }
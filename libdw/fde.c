@@ -242,6 +242,131 @@ binary_search_fde (Dwarf_CFI *cache, Dwarf_Addr address)
   return (Dwarf_Off) -1l;
 }
 
+static int
+compare_fde_range (const void *a, const void *b)
+{
+  const struct dwarf_fde_range *r1 = a;
+  const struct dwarf_fde_range *r2 = b;
+  if (r1->start != r2->start)
+    return r1->start < r2->start ? -1 : 1;
+  return r1->offset < r2->offset ? -1 : r1->offset > r2->offset;
+}
+
+/* Read the ranges of all FDEs in one pass over the section, like the
+   .eh_frame_hdr table that we don't have.  FDEs that overlap, like those
+   left at zero from discarded sections, are merged into one entry without
+   an FDE offset, where lookups have to read the FDEs one by one.  Returns
+   false if there are none or if we run out of memory.  */
+static bool
+read_fde_table (Dwarf_CFI *cache)
+{
+  struct dwarf_fde_range *table = NULL;
+  size_t n = 0;
+  size_t nalloc = 0;
+
+  Dwarf_Off offset = 0;
+  while (1)
+    {
+      Dwarf_CFI_Entry entry;
+      Dwarf_Off next_offset = offset;
+      int result = INTUSE(dwarf_next_cfi) (cache->e_ident,
+					   &cache->data->d, CFI_IS_EH (cache),
+					   offset, &next_offset, &entry);
+      if (result > 0)
+	break;
+      if (result < 0)
+	{
+	  if (next_offset == offset)
+	    /* We couldn't progress past the bogus FDE.  */
+	    break;
+	  /* Skip the loser and look at the next entry.  */
+	  offset = next_offset;
+	  continue;
+	}
+
+      if (dwarf_cfi_cie_p (&entry))
+	__libdw_intern_cie (cache, offset, &entry.cie);
+      else
+	{
+	  /* Just the range, the FDE itself is only interned when it is
+	     used.  Bad FDEs are left out, as when we read them one by
+	     one.  */
+	  struct dwarf_cie *cie = __libdw_find_cie (cache,
+						    entry.fde.CIE_pointer);
+	  const uint8_t *p = entry.fde.start;
+	  Dwarf_Addr start, len;
+	  if (cie != NULL
+	      && ! read_encoded_value (cache, cie->fde_encoding, &p, &start)
+	      && ! read_encoded_value (cache, cie->fde_encoding & 0x0f,
+				       &p, &len)
+	      && start + len > start)
+	    {
+	      if (n == nalloc)
+		{
+		  nalloc = nalloc == 0 ? 64 : 2 * nalloc;
+		  struct dwarf_fde_range *bigger
+		    = realloc (table, nalloc * sizeof table[0]);
+		  if (unlikely (bigger == NULL))
+		    {
+		      free (table);
+		      return false;
+		    }
+		  table = bigger;
+		}
+	      table[n].start = start;
+	      table[n].end = start + len;
+	      table[n].offset = offset;
+	      n++;
+	    }
+	}
+
+      offset = next_offset;
+    }
+
+  if (n == 0)
+    return false;
+
+  qsort (table, n, sizeof table[0], compare_fde_range);
+  size_t kept = 1;
+  for (size_t i = 1; i < n; i++)
+    if (table[i].start >= table[kept - 1].end)
+      table[kept++] = table[i];
+    else
+      {
+	/* Which FDE covers the overlap depends on their order in the
+	   section.  */
+	if (table[i].end > table[kept - 1].end)
+	  table[kept - 1].end = table[i].end;
+	table[kept - 1].offset = (Dwarf_Off) -1l;
+      }
+  n = kept;
+
+  cache->fde_table = table;
+  cache->fde_table_entries = n;
+  return true;
+}
+
+/* Use the table made by read_fde_table, yield an FDE offset, or -1 if
+   the table cannot tell.  */
+static Dwarf_Off
+search_fde_table (Dwarf_CFI *cache, Dwarf_Addr address)
+{
+  const struct dwarf_fde_range *table = cache->fde_table;
+  size_t l = 0, u = cache->fde_table_entries;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      if (address < table[idx].start)
+	u = idx;
+      else if (address >= table[idx].end)
+	l = idx + 1;
+      else
+	return table[idx].offset;
+    }
+
+  return (Dwarf_Off) -1l;
+}
+
 struct dwarf_fde *
 internal_function
 __libdw_find_fde (Dwarf_CFI *cache, Dwarf_Addr address)
@@ -275,7 +400,18 @@ __libdw_find_fde (Dwarf_CFI *cache, Dwarf_Addr address)
       return fde;
     }
 
-  /* It's not there.  Read more CFI entries until we find it.  */
+  /* Otherwise make our own table, unless we already tried.  */
+  if (cache->fde_table == NULL && ! read_fde_table (cache))
+    cache->fde_table = (void *) -1l;
+  if (cache->fde_table != (void *) -1l)
+    {
+      Dwarf_Off offset = search_fde_table (cache, address);
+      if (offset != (Dwarf_Off) -1l)
+	return __libdw_fde_by_offset (cache, offset);
+    }
+
+  /* It's not there, or it is where FDEs overlap.  Read more CFI entries
+     until we find it.  */
   while (1)
     {
       Dwarf_Off last_offset = cache->next_offset;
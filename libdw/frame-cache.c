@@ -47,15 +47,6 @@ free_cie (void *arg)
 
 #define free_fde	free
 
-static void
-free_expr (void *arg)
-{
-  struct loc_s *loc = arg;
-
-  free (loc->loc);
-  free (loc);
-}
-
 void
 internal_function
 __libdw_destroy_frame_cache (Dwarf_CFI *cache)
@@ -63,7 +54,21 @@ __libdw_destroy_frame_cache (Dwarf_CFI *cache)
   /* Most of the data is in our two search trees.  */
   tdestroy (cache->fde_tree, free_fde);
   tdestroy (cache->cie_tree, free_cie);
-  tdestroy (cache->expr_tree, free_expr);
+
+  if (cache->fde_table != (void *) -1l)
+    free (cache->fde_table);
+
+  Dwarf_Loc_Hash *expr_hash = atomic_load_explicit (&cache->expr_hash,
+						    memory_order_relaxed);
+  if (expr_hash != NULL)
+    __libdw_loc_hash_free (expr_hash, true);
+
+  if (cache->frame_cache != NULL)
+    {
+      for (size_t i = 0; i < (size_t) 1 << cache->frame_cache_bits; i++)
+	free (cache->frame_cache[i]);
+      free (cache->frame_cache);
+    }
 
   if (cache->ebl != NULL && cache->ebl != (void *) -1l)
     ebl_closebackend (cache->ebl);
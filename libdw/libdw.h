@@ -221,6 +221,16 @@ typedef struct Dwarf_Frame_s Dwarf_Frame;
 /* Opaque type representing a CFI section found in a DWARF or ELF file.  */
 typedef struct Dwarf_CFI_s Dwarf_CFI;
 
+/* Opaque type representing a walk over a DIE tree.  */
+typedef struct Dwarf_Die_Cursor_s Dwarf_Die_Cursor;
+
+/* The order in which dwarf_die_cursor_next returns a DIE.  */
+enum
+{
+  DWARF_DIE_CURSOR_PRE = 0,	/* Before its children.  */
+  DWARF_DIE_CURSOR_POST		/* After its children.  */
+};
+
 
 /* Handle for debug sessions.  */
 typedef struct Dwarf Dwarf;
@@ -313,6 +323,35 @@ extern int dwarf_cu_info (Dwarf_CU *cu,
 			  uint64_t *unit_id,
 			  uint8_t *address_size, uint8_t *offset_size);
 
+/* Return in *UNITS an array of all units of DWARF, in the order
+   dwarf_get_units returns them, and their number in *NUNITS.  The
+   array belongs to DWARF and stays valid until dwarf_end.  The units
+   are independent work items that can be handed to different threads
+   of a caller supplied thread pool, using dwarf_cu_info to get their
+   DIEs.  Returns -1 on error, zero on success.  */
+extern int dwarf_get_unit_list (Dwarf *dwarf, Dwarf_CU *const **units,
+				size_t *nunits)
+     __nonnull_attribute__ (2, 3);
+
+/* Call CALLBACK for every unit of DWARF, with the CU DIE filled in
+   like dwarf_get_units does, from NTHREADS threads at once, including
+   the calling thread.  If NTHREADS is zero one thread per online
+   processor is used.  Every unit is passed to CALLBACK exactly once,
+   larger units first, but otherwise in no particular order.  The
+   state libdw sets up lazily and shares between units (unit lookup,
+   abbreviations, string offset and other bases, split units and line
+   tables) can be used concurrently from all callbacks.  CALLBACK
+   should return DWARF_CB_OK to continue or DWARF_CB_ABORT to stop
+   handing out more units.  Returns 0 after all units have been passed
+   to CALLBACK, 1 if CALLBACK returned DWARF_CB_ABORT, and -1 on
+   error.  */
+extern int dwarf_parallel_units (Dwarf *dwarf, unsigned int nthreads,
+				 int (*callback) (Dwarf_CU *cu,
+						  Dwarf_Die *cudie,
+						  void *arg),
+				 void *arg)
+     __nonnull_attribute__ (3);
+
 /* Decode one DWARF CFI entry (CIE or FDE) from the raw section data.
    The E_IDENT from the originating ELF file indicates the address
    size and byte order used in the CFI section contained in DATA;
@@ -420,6 +459,50 @@ extern int dwarf_child (Dwarf_Die *die, Dwarf_Die *result)
 extern int dwarf_siblingof (Dwarf_Die *die, Dwarf_Die *result)
      __nonnull_attribute__ (2);
 
+/* Start a walk over DIE and all DIEs below it, without recursion.
+   Each call to dwarf_die_cursor_next returns the next DIE, first DIE
+   itself, then its children and their children in DIE order.  If
+   POSTORDER is true every DIE is returned a second time after all
+   DIEs below it.  The cursor only allocates memory when the tree is
+   deeper than seen before.  Returns NULL on error.  */
+extern Dwarf_Die_Cursor *dwarf_die_cursor_begin (Dwarf_Die *die,
+						 bool postorder);
+
+/* Get the next DIE of the walk in RESULT, its depth below the DIE the
+   walk started at in *DEPTHP and DWARF_DIE_CURSOR_PRE or
+   DWARF_DIE_CURSOR_POST in *ORDERP, if not NULL.  Returns 0 if a DIE
+   was found, 1 at the end of the walk and -1 on error.  */
+extern int dwarf_die_cursor_next (Dwarf_Die_Cursor *cursor,
+				  Dwarf_Die *result, unsigned int *depthp,
+				  int *orderp)
+     __nonnull_attribute__ (2);
+
+/* Don't walk over the DIEs below the DIE just returned by
+   dwarf_die_cursor_next in DWARF_DIE_CURSOR_PRE order.  With
+   POSTORDER the DIE is still returned a second time right away.
+   Returns 0 on success, -1 if there is no such DIE.  */
+extern int dwarf_die_cursor_skip (Dwarf_Die_Cursor *cursor);
+
+/* Store the offsets of the DIE just returned by dwarf_die_cursor_next
+   and of its parents in OFFSETS, starting with the DIE the walk
+   started at, as far as NOFFSETS allows.  Returns the number of
+   offsets of the whole position, which is the depth of the DIE plus
+   one, or zero on error.  */
+extern size_t dwarf_die_cursor_position (Dwarf_Die_Cursor *cursor,
+					 Dwarf_Off *offsets, size_t noffsets);
+
+/* Continue the walk of CURSOR after the NOFFSETS DIEs in OFFSETS, as
+   stored by dwarf_die_cursor_position for a walk that started at the
+   same DIE, as if the last one was just returned in ORDER.  The walk
+   can be resumed by another cursor, even after the Dwarf was opened
+   again.  Returns 0 on success, -1 on error.  */
+extern int dwarf_die_cursor_resume (Dwarf_Die_Cursor *cursor,
+				    const Dwarf_Off *offsets,
+				    size_t noffsets, int order);
+
+/* Release the memory of CURSOR.  */
+extern void dwarf_die_cursor_end (Dwarf_Die_Cursor *cursor);
+
 /* For type aliases and qualifier type DIEs, which don't modify or
    change the structural layout of the underlying type, follow the
    DW_AT_type attribute (recursively) and return the underlying type
@@ -630,6 +713,25 @@ extern ptrdiff_t dwarf_getpubnames (Dwarf *dbg,
      __nonnull_attribute__ (2);
 
 
+/* Call CALLBACK for each entry of the DWARF 5 .debug_names index of
+   DBG with the given NAME, or for all entries if NAME is NULL.  The
+   Dwarf_Global is filled in like for dwarf_getpubnames, and the DIE
+   tag recorded in the index is passed along, without reading any of
+   the DIEs.  Entries for type units in other (split DWARF) files are
+   skipped.  When there is no .debug_names section the names are
+   looked up in the .gdb_index symbol table instead, searching the
+   scopes of the CUs it lists for definitions of NAME; that doesn't
+   cover type units.  Returns 0 after all entries have been passed to
+   CALLBACK, 1 if CALLBACK returned DWARF_CB_ABORT, and -1 on error,
+   including when there is neither a .debug_names nor a .gdb_index
+   section.  */
+extern int dwarf_getnames (Dwarf *dbg, const char *name,
+			   int (*callback) (Dwarf *, Dwarf_Global *,
+					    unsigned int, void *),
+			   void *arg)
+     __nonnull_attribute__ (3);
+
+
 /* Get source file information for CU.  */
 extern int dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines,
 			      size_t *nlines) __nonnull_attribute__ (2, 3);
@@ -771,6 +873,14 @@ extern ptrdiff_t dwarf_getlocations (Dwarf_Attribute *attr,
 				     Dwarf_Addr *startp, Dwarf_Addr *endp,
 				     Dwarf_Op **expr, size_t *exprlen);
 
+/* Decode the location expressions and location lists of all DIEs in
+   CU, and of its split unit if CU is a skeleton unit, so later calls of
+   the functions above for them only look up the result.  Attributes
+   that cannot be decoded are skipped.  Different threads can do this
+   for different CUs, or the same CU, at once.  Returns zero on
+   success, -1 if the DIEs cannot be read.  */
+extern int dwarf_cu_load_locations (Dwarf_CU *cu);
+
 /* Return the block associated with a DW_OP_implicit_value operation.
    The OP pointer must point into an expression that dwarf_getlocation
    or dwarf_getlocation_addr has returned given the same ATTR.  */
@@ -860,7 +970,9 @@ extern int dwarf_getscopevar (Dwarf_Die *scopes, int nscopes,
 
 
 
-/* Return list address ranges.  */
+/* Return list address ranges, sorted by address.  The list comes from
+   the .gdb_index address table or .debug_aranges, completed with the
+   ranges of the CUs that have no .debug_aranges entries.  */
 extern int dwarf_getaranges (Dwarf *dbg, Dwarf_Aranges **aranges,
 			     size_t *naranges)
      __nonnull_attribute__ (2);
@@ -1024,6 +1136,16 @@ extern int dwarf_cfi_addrframe (Dwarf_CFI *cache,
 				Dwarf_Addr address, Dwarf_Frame **frame)
   __nonnull_attribute__ (3);
 
+/* Like dwarf_cfi_addrframe, but the frame state is kept in CACHE, so
+   asking again for an address in the same range neither executes the
+   CFI program nor allocates memory.  *FRAME belongs to CACHE and must
+   not be freed.  It stays valid until the next call of this function
+   for CACHE, or dwarf_cfi_end.  */
+extern int dwarf_cfi_addrframe_cached (Dwarf_CFI *cache,
+				       Dwarf_Addr address,
+				       Dwarf_Frame **frame)
+  __nonnull_attribute__ (3);
+
 /* Return the DWARF register number used in FRAME to denote
    the return address in FRAME's caller frame.  The remaining
    arguments can be non-null to fill in more information.
@@ -82,9 +82,13 @@ enum
     IDX_debug_str_offsets,
     IDX_debug_macinfo,
     IDX_debug_macro,
+    IDX_debug_names,
     IDX_debug_ranges,
     IDX_debug_rnglists,
     IDX_gnu_debugaltlink,
+    IDX_gdb_index,
+    IDX_debug_cu_index,
+    IDX_debug_tu_index,
     IDX_last
   };
 
@@ -140,10 +144,54 @@ enum
   DWARF_E_NOT_CUDIE,
   DWARF_E_UNKNOWN_LANGUAGE,
   DWARF_E_NO_DEBUG_ADDR,
+  DWARF_E_NO_DEBUG_NAMES,
 };
 
 
 #include "dwarf_sig8_hash.h"
+#include "dwarf_loc_hash.h"
+
+/* The units read from .debug_info or .debug_types.  Units are read
+   in section order, so the array is sorted by offset and only ever
+   appended to.  That way readers can binary search it without taking
+   a lock, see __libdw_findcu.  Only the first NUNITS entries of the
+   current array are valid.  An array which is replaced by a larger
+   one is kept, because readers might still be looking at it.  */
+struct libdw_unit_array
+{
+  struct libdw_unit_array *prev;
+  size_t nalloc;
+  struct Dwarf_CU *units[];
+};
+
+struct libdw_unit_table
+{
+  _Atomic (struct libdw_unit_array *) array;
+  atomic_size_t nunits;
+
+  /* Offset of the next unit to read.  Only accessed with the
+     units_lock held.  */
+  Dwarf_Off next_offset;
+};
+
+/* The list of all units returned by dwarf_get_unit_list.  */
+struct libdw_unit_list
+{
+  size_t nunits;
+  struct Dwarf_CU *units[];
+};
+
+/* A block of memory handed out by libdw_alloc.  */
+struct libdw_memblock
+{
+  size_t size;
+  size_t remaining;
+  struct libdw_memblock *prev;
+  char mem[0];
+};
+
+/* Number of chunks of per thread memory block tails.  */
+#define LIBDW_MEM_CHUNKS 24
 
 /* This is the structure representing the debugging state.  */
 struct Dwarf
@@ -155,6 +203,10 @@ struct Dwarf
      alt and dwo files.  */
   char *debugdir;
 
+  /* The (absolute) path to the ELF file itself, if known.  To help
+     locating the DWARF package (.dwp) file.  */
+  char *elfpath;
+
   /* dwz alternate DWARF file.  */
   Dwarf *alt_dwarf;
 
@@ -171,6 +223,16 @@ struct Dwarf
      close this file descriptor.  */
   int alt_fd;
 
+  /* DWARF package file holding the split units of the skeleton units
+     in this debug.  (Dwarf *) -1 if not yet searched, NULL if there is
+     none.  If found we allocated it ourselves and must end it.  */
+  Dwarf *dwp_dwarf;
+
+  /* The decoded .debug_cu_index and .debug_tu_index sections if this
+     is a DWARF package file, NULL otherwise.  */
+  struct Dwarf_Package_Index *cu_index;
+  struct Dwarf_Package_Index *tu_index;
+
   /* Information for traversing the .debug_pubnames section.  This is
      an array and separately allocated with malloc.  */
   struct pubnames_s
@@ -182,23 +244,49 @@ struct Dwarf
   } *pubnames_sets;
   size_t pubnames_nsets;
 
-  /* Search tree for the CUs.  */
-  void *cu_tree;
-  Dwarf_Off next_cu_offset;
+  /* The name indexes in the .debug_names section, decoded on first use
+     by dwarf_getnames.  This is an array and separately allocated with
+     malloc.  */
+  struct libdw_names_index *names_indexes;
+  size_t names_nindexes;
 
-  /* Search tree and sig8 hash table for .debug_types type units.  */
-  void *tu_tree;
-  Dwarf_Off next_tu_offset;
+  /* The CUs read so far.  */
+  struct libdw_unit_table cu_table;
+
+  /* The .debug_types type units read so far and sig8 hash table for
+     all type units.  */
+  struct libdw_unit_table tu_table;
   Dwarf_Sig8_Hash sig8_hash;
 
+  /* Serializes reading new units into cu_table and tu_table.  */
+  pthread_mutex_t units_lock;
+
+  /* All units of cu_table and tu_table in dwarf_get_units order, set
+     up on first use by dwarf_get_unit_list.  Separately allocated with
+     malloc.  */
+  _Atomic (struct libdw_unit_list *) unit_list;
+
+  /* Serializes decoding more abbreviations of a unit, protects
+     abbrev_tables.  */
+  pthread_mutex_t abbrev_lock;
+
+  /* Search tree of struct libdw_abbrev_table, shared by the units.  */
+  void *abbrev_tables;
+
+  /* Serializes searching for split units, protects split_tree and
+     dwp_dwarf.  */
+  pthread_mutex_t split_lock;
+
   /* Search tree for split Dwarf associated with CUs in this debug.  */
   void *split_tree;
 
   /* Search tree for .debug_macro operator tables.  */
   void *macro_ops;
 
-  /* Search tree for decoded .debug_line units.  */
+  /* Search tree for decoded .debug_line units, protected by
+     lines_lock.  */
   void *files_lines;
+  pthread_mutex_t lines_lock;
 
   /* Address ranges.  */
   Dwarf_Aranges *aranges;
@@ -216,22 +304,13 @@ struct Dwarf
   /* Similar for addrx/constx, which will come from .debug_addr section.  */
   struct Dwarf_CU *fake_addr_cu;
 
-  /* Supporting lock for internal memory handling.  Ensures threads that have
-     an entry in the mem_tails array are not disturbed by new threads doing
-     allocations for this Dwarf.  */
-  pthread_rwlock_t mem_rwl;
-
   /* Internal memory handling.  This is basically a simplified thread-local
      reimplementation of obstacks.  Unfortunately the standard obstack
-     implementation is not usable in libraries.  */
-  size_t mem_stacks;
-  struct libdw_memblock
-  {
-    size_t size;
-    size_t remaining;
-    struct libdw_memblock *prev;
-    char mem[0];
-  } **mem_tails;
+     implementation is not usable in libraries.  Each thread allocates
+     from its own stack of blocks, found without locking through its
+     (reused) thread id.  Chunk K holds the tails for 64 << K thread ids,
+     chunks are allocated on first use and never move.  */
+  _Atomic (struct libdw_memblock **) mem_tails[LIBDW_MEM_CHUNKS];
 
   /* Default size of allocated memory blocks.  */
   size_t mem_default_size;
@@ -246,13 +325,87 @@ struct Dwarf_Abbrev
 {
   Dwarf_Off offset;	  /* Offset to start of abbrev into .debug_abbrev.  */
   unsigned char *attrp;   /* Pointer to start of attribute name/form pairs. */
+  /* The attribute name/form pairs decoded, up to and including the
+     zero pair at the end.  NULL if not decoded.  */
+  const struct libdw_abbrev_attr *attrs;
   bool has_children : 1;  /* Whether or not the DIE has children. */
   unsigned int code : 31; /* The (unique) abbrev code.  */
   unsigned int tag;	  /* The tag of the DIE. */
 } attribute_packed;
 
+/* One decoded attribute specification of an abbreviation.  */
+struct libdw_abbrev_attr
+{
+  uint16_t name;
+  uint16_t form;
+  /* For DW_FORM_implicit_const the offset of the value from attrp of
+     the abbreviation.  Otherwise the offset of the value from the
+     first attribute value of the DIE, when all attributes before it
+     have a fixed size in the unit, else LIBDW_ATTR_OFFSET_UNKNOWN.  */
+  uint32_t offset;
+};
+#define LIBDW_ATTR_OFFSET_UNKNOWN ((uint32_t) -1)
+
 #include "dwarf_abbrev_hash.h"
 
+/* Number of abbreviation codes looked up without hashing.  */
+#define LIBDW_SMALL_ABBREV_CODES 128
+
+/* The abbreviations at one offset of .debug_abbrev, shared by all
+   units that use them and decode them the same.  The sizes of forms
+   depend on the version, address and offset size of the unit.  */
+struct libdw_abbrev_table
+{
+  Dwarf_Off offset;		/* Of the first abbreviation.  */
+  uint16_t version;
+  uint8_t address_size;
+  uint8_t offset_size;
+
+  /* Hash table for the abbreviations.  */
+  Dwarf_Abbrev_Hash hash;
+
+  /* Offset past last read abbreviation.  Only accessed with the
+     abbrev_lock of the Dwarf held.  */
+  size_t last_offset;
+
+  /* The abbreviations with small codes that were found in the hash
+     table, NULL if not looked up yet.  Producers number them from 1,
+     so this usually covers all of them without hashing.  */
+  _Atomic (Dwarf_Abbrev *) small[LIBDW_SMALL_ABBREV_CODES];
+};
+
+
+/* One abbreviation of a .debug_names name index.  */
+struct libdw_names_abbrev
+{
+  Dwarf_Word code;
+  unsigned int tag;
+  const unsigned char *attrp;	/* Index attribute/form pairs.  */
+};
+
+/* One name index (header) of the .debug_names section.  */
+struct libdw_names_index
+{
+  uint8_t offset_size;
+  uint32_t cu_count;
+  uint32_t local_tu_count;
+  uint32_t bucket_count;
+  uint32_t name_count;
+
+  const unsigned char *cu_offsets;
+  const unsigned char *local_tu_offsets;
+  const unsigned char *buckets;
+  const unsigned char *hashes;
+  const unsigned char *str_offsets;
+  const unsigned char *entry_offsets;
+  const unsigned char *entry_pool;
+  const unsigned char *end;
+
+  /* Sorted by code.  */
+  size_t nabbrevs;
+  struct libdw_names_abbrev *abbrevs;
+};
+
 
 /* Files in line information records.  */
 struct Dwarf_Files_s
@@ -296,9 +449,40 @@ struct Dwarf_Line_s
 struct Dwarf_Lines_s
 {
   size_t nlines;
+
+  /* The addresses of all lines relative to ADDR_BASE, in a column of
+     their own, so searching for an address doesn't have to go through
+     the whole records.  NULL if the addresses are too far apart.  */
+  const uint32_t *addr_offs;
+  Dwarf_Addr addr_base;
+
   struct Dwarf_Line_s info[0];
 };
 
+/* A walk over a DIE tree.  */
+struct Dwarf_Die_Cursor_s
+{
+  /* The DIE just returned and its parents up to the DIE the walk
+     started at, which is stack[0].  */
+  Dwarf_Die *stack;
+  size_t depth;
+  size_t stack_size;
+
+  /* Whether DIEs are also returned after their children.  */
+  bool postorder;
+  /* Whether the children of stack[depth] should not be walked.  */
+  bool skip;
+
+  /* What was last returned.  */
+  enum
+    {
+      die_cursor_start,
+      die_cursor_pre,
+      die_cursor_post,
+      die_cursor_done
+    } state;
+};
+
 /* Representation of address ranges.  */
 struct Dwarf_Aranges_s
 {
@@ -314,6 +498,31 @@ struct Dwarf_Aranges_s
 };
 
 
+/* A decoded .debug_cu_index or .debug_tu_index section of a DWARF
+   package file.  Both the GNU version 2 and the DWARF5 version 5
+   formats are supported.  Version 2 section identifiers are mapped
+   onto the DW_SECT values of version 5.  */
+struct Dwarf_Package_Index
+{
+  Dwarf *dbg;
+  uint32_t section_count;
+  uint32_t unit_count;
+  uint32_t slot_count;
+
+  /* Column of each DW_SECT section in the offset and size tables,
+     or -1 if the package has no contributions for that section.  */
+  int sections[DW_SECT_RNGLISTS + 1];
+
+  const unsigned char *hash_table;
+  const unsigned char *indices;
+  const unsigned char *section_offsets;
+  const unsigned char *section_sizes;
+
+  /* Zero based rows sorted by their DW_SECT_INFO offset, so the row
+     of a unit can be found from its offset.  Allocated with malloc.  */
+  uint32_t *info_rows;
+};
+
 /* CU representation.  */
 struct Dwarf_CU
 {
@@ -340,44 +549,58 @@ struct Dwarf_CU
      Or the other way around if this is a split compile unit.  Set to -1
      if not yet searched.  Always use __libdw_find_split_unit to access
      this field.  */
-  struct Dwarf_CU *split;
+  _Atomic (struct Dwarf_CU *) split;
 
-  /* Hash table for the abbreviations.  */
-  Dwarf_Abbrev_Hash abbrev_hash;
+  /* The abbreviations, shared with other units that use the same.  */
+  struct libdw_abbrev_table *abbrevs;
   /* Offset of the first abbreviation.  */
   size_t orig_abbrev_offset;
-  /* Offset past last read abbreviation.  */
-  size_t last_abbrev_offset;
 
-  /* The srcline information.  */
-  Dwarf_Lines *lines;
+  /* The srcline information, NULL if not read yet or (void *) -1 if
+     it couldn't be read.  Published after files, read it with
+     __libdw_cu_lines.  */
+  _Atomic (Dwarf_Lines *) lines;
 
-  /* The source file information.  */
-  Dwarf_Files *files;
+  /* The source file information, likewise.  Read it with
+     __libdw_cu_files.  */
+  _Atomic (Dwarf_Files *) files;
 
-  /* Known location lists.  */
-  void *locs;
+  /* Known location expressions, allocated on first use.  */
+  _Atomic (Dwarf_Loc_Hash *) locs;
+
+  /* Index of the address ranges of the scopes, built by the first
+     dwarf_getscopes call.  (void *) -1 if it cannot be built.  */
+  _Atomic (struct libdw_scope_index *) scope_index;
 
   /* Base address for use with ranges and locs.
      Don't access directly, call __libdw_cu_base_address.  */
   Dwarf_Addr base_address;
 
+  /* The bases below are computed lazily and only depend on the unit
+     itself, so threads racing to compute one store the same value and
+     can use relaxed atomics.  */
+
   /* The offset into the .debug_addr section where index zero begins.
      Don't access directly, call __libdw_cu_addr_base.  */
-  Dwarf_Off addr_base;
+  _Atomic (Dwarf_Off) addr_base;
 
   /* The offset into the .debug_str_offsets section where index zero begins.
      Don't access directly, call __libdw_cu_str_off_base.  */
-  Dwarf_Off str_off_base;
+  _Atomic (Dwarf_Off) str_off_base;
 
   /* The offset into the .debug_ranges section to use for GNU
      DebugFission split units.  Don't access directly, call
      __libdw_cu_ranges_base.  */
-  Dwarf_Off ranges_base;
+  _Atomic (Dwarf_Off) ranges_base;
 
   /* The start of the offset table in .debug_loclists.
      Don't access directly, call __libdw_cu_locs_base.  */
-  Dwarf_Off locs_base;
+  _Atomic (Dwarf_Off) locs_base;
+
+  /* The package index and zero based row in it, if this unit comes
+     from a DWARF package file.  Otherwise dwp_index is NULL.  */
+  struct Dwarf_Package_Index *dwp_index;
+  uint32_t dwp_row;
 
   /* Memory boundaries of this CU.  */
   void *startp;
@@ -639,6 +862,22 @@ extern struct Dwarf_CU *__libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
 extern struct Dwarf_CU *__libdw_findcu (Dwarf *dbg, Dwarf_Off offset, bool tu)
      __nonnull_attribute__ (1) internal_function;
 
+/* Fill in DBG->aranges from the .gdb_index address table.  Returns
+   -1 if there is no usable table.  */
+extern int __libdw_gdb_index_aranges (Dwarf *dbg, Dwarf_Aranges **aranges,
+				      size_t *naranges)
+     __nonnull_attribute__ (1, 2) internal_function;
+
+/* Look up NAME, or all names if NULL, in the .gdb_index symbol table
+   like dwarf_getnames.  */
+extern int __libdw_gdb_index_getnames (Dwarf *dbg, const char *name,
+				       int (*callback) (Dwarf *,
+							Dwarf_Global *,
+							unsigned int,
+							void *),
+				       void *arg)
+     __nonnull_attribute__ (1, 3) internal_function;
+
 /* Find CU for given DIE address.  */
 extern struct Dwarf_CU *__libdw_findcu_addr (Dwarf *dbg, void *addr)
      __nonnull_attribute__ (1) internal_function;
@@ -656,6 +895,15 @@ extern Dwarf_Abbrev *__libdw_findabbrev (struct Dwarf_CU *cu,
 					 unsigned int code)
      __nonnull_attribute__ (1) internal_function;
 
+/* Get the abbreviation table at OFFSET for a unit with the given
+   version, address and offset size, creating it if needed.  */
+extern struct libdw_abbrev_table *__libdw_abbrev_table (Dwarf *dbg,
+							Dwarf_Off offset,
+							uint16_t version,
+							uint8_t address_size,
+							uint8_t offset_size)
+     __nonnull_attribute__ (1) internal_function;
+
 /* Get abbreviation at given offset.  */
 extern Dwarf_Abbrev *__libdw_getabbrev (Dwarf *dbg, struct Dwarf_CU *cu,
 					Dwarf_Off offset, size_t *lengthp,
@@ -683,7 +931,15 @@ __libdw_dieabbrev (Dwarf_Die *die, const unsigned char **readp)
 
       /* Find the abbreviation.  */
       if (die->abbrev == NULL)
-	die->abbrev = __libdw_findabbrev (die->cu, code);
+	{
+	  Dwarf_Abbrev *abbrev = NULL;
+	  if (code < LIBDW_SMALL_ABBREV_CODES)
+	    abbrev = atomic_load_explicit (&die->cu->abbrevs->small[code],
+					   memory_order_acquire);
+	  if (abbrev == NULL)
+	    abbrev = __libdw_findabbrev (die->cu, code);
+	  die->abbrev = abbrev;
+	}
     }
   return die->abbrev;
 }
@@ -701,12 +957,18 @@ __libdw_form_val_len (struct Dwarf_CU *cu, unsigned int form,
 		      const unsigned char *valp)
 {
   /* Small lookup table of forms with fixed lengths.  Absent indexes are
-     initialized 0, so any truly desired 0 is set to 0x80 and masked.  */
+     initialized 0, so any truly desired 0 is set to 0x80 and masked.
+     Forms that are just an unsigned LEB128 number are 0x40.  */
   static const uint8_t form_lengths[] =
     {
       [DW_FORM_flag_present] = 0x80,
       [DW_FORM_implicit_const] = 0x80, /* Value is in abbrev, not in info.  */
 
+      [DW_FORM_udata] = 0x40, [DW_FORM_sdata] = 0x40,
+      [DW_FORM_ref_udata] = 0x40, [DW_FORM_strx] = 0x40,
+      [DW_FORM_addrx] = 0x40, [DW_FORM_loclistx] = 0x40,
+      [DW_FORM_rnglistx] = 0x40,
+
       [DW_FORM_flag] = 1,
       [DW_FORM_data1] = 1, [DW_FORM_ref1] = 1,
       [DW_FORM_addrx1] = 1, [DW_FORM_strx1] = 1,
@@ -729,6 +991,17 @@ __libdw_form_val_len (struct Dwarf_CU *cu, unsigned int form,
   if (form < sizeof form_lengths / sizeof form_lengths[0])
     {
       uint8_t len = form_lengths[form];
+      if (len == 0x40)
+	{
+	  const unsigned char *endp = cu->endp;
+	  size_t ulen = __libdw_skip_uleb128 (valp, endp);
+	  if (unlikely (ulen > (size_t) (endp - valp)))
+	    {
+	      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+	      return -1;
+	    }
+	  return ulen;
+	}
       if (len != 0)
 	{
 	  const unsigned char *endp = cu->endp;
@@ -781,18 +1054,84 @@ extern int __libdw_visit_scopes (unsigned int depth,
 				 void *arg)
   __nonnull_attribute__ (2, 4) internal_function;
 
+/* A DIE in the scope index of a CU that either has addresses or is the
+   parent of one that has them.  */
+struct libdw_scope_node
+{
+  Dwarf_Die die;
+  size_t parent;		/* Index of the parent node.  */
+  unsigned int depth;		/* As __libdw_visit_scopes passes it.  */
+  bool inlined;			/* Whether it is a DW_TAG_inlined_subroutine.  */
+};
+
+/* An address range of a node.  The ranges are sorted by start and
+   form an implicit interval tree, where MAX_END is the largest end of
+   the subtree under the range.  */
+struct libdw_scope_range
+{
+  Dwarf_Addr start;
+  Dwarf_Addr end;
+  Dwarf_Addr max_end;
+  size_t node;
+};
+
+/* A DW_TAG_subprogram that can be the abstract origin of an inlined
+   instance, with the node of its parent.  */
+struct libdw_scope_origin
+{
+  const void *addr;
+  size_t parent;		/* (size_t) -1 if seen more than once.  */
+};
+
+/* The DIEs __libdw_visit_scopes visits from a CU DIE that have
+   addresses, so dwarf_getscopes doesn't have to walk the tree.  Node
+   zero is the CU DIE, the nodes are in the order they are visited.  */
+struct libdw_scope_index
+{
+  struct libdw_scope_node *nodes;
+  size_t nnodes;
+  struct libdw_scope_range *ranges;
+  size_t nranges;
+  int max_level;		/* Of the root of the interval tree.  */
+  struct libdw_scope_origin *origins;
+  size_t norigins;		/* Sorted by addr.  */
+};
+
+/* Get the scope index of CU, building it if needed.  Returns NULL if
+   the CU cannot be indexed.  */
+extern struct libdw_scope_index *__libdw_scope_index (Dwarf_CU *cu)
+  __nonnull_attribute__ (1) internal_function;
+
+/* Store the indexes of the nodes that have a range containing PC in
+   NODES, as far as there is room for NNODES of them.  Returns the
+   number of ranges containing PC.  */
+extern size_t __libdw_scope_index_find (const struct libdw_scope_index *index,
+					Dwarf_Addr pc, size_t *nodes,
+					size_t nnodes)
+  __nonnull_attribute__ (1) internal_function;
+
+/* Free the scope index of a CU.  */
+extern void __libdw_scope_index_free (struct libdw_scope_index *index)
+  internal_function;
+
 /* Parse a DWARF Dwarf_Block into an array of Dwarf_Op's,
-   and cache the result (via tsearch).  */
+   and cache the result in CACHE.  */
 extern int __libdw_intern_expression (Dwarf *dbg,
 				      bool other_byte_order,
 				      unsigned int address_size,
 				      unsigned int ref_size,
-				      void **cache, const Dwarf_Block *block,
+				      _Atomic (Dwarf_Loc_Hash *) *cache,
+				      const Dwarf_Block *block,
 				      bool cfap, bool valuep,
 				      Dwarf_Op **llbuf, size_t *listlen,
 				      int sec_index)
   __nonnull_attribute__ (5, 6, 9, 10) internal_function;
 
+/* Free a cache of location expressions.  The entries themselves are
+   only freed if FREE_ENTRIES, they are not allocated from a Dwarf.  */
+extern void __libdw_loc_hash_free (Dwarf_Loc_Hash *htab, bool free_entries)
+  internal_function;
+
 extern Dwarf_Die *__libdw_offdie (Dwarf *dbg, Dwarf_Off offset,
 				  Dwarf_Die *result, bool debug_types)
   internal_function;
@@ -983,6 +1322,25 @@ int __libdw_getsrclines (Dwarf *dbg, Dwarf_Off debug_line_offset,
   internal_function
   __nonnull_attribute__ (1);
 
+/* The line table of CU as dwarf_getsrclines published it, NULL if it
+   wasn't asked for yet or (void *) -1 if it couldn't be read.  */
+static inline Dwarf_Lines *
+__libdw_cu_lines (Dwarf_CU *cu)
+{
+  return atomic_load_explicit (&cu->lines, memory_order_acquire);
+}
+
+/* Likewise for the file table of CU.  */
+static inline Dwarf_Files *
+__libdw_cu_files (Dwarf_CU *cu)
+{
+  return atomic_load_explicit (&cu->files, memory_order_acquire);
+}
+
+/* Return the number of lines in LINES whose address is ADDR or lower.  */
+size_t __libdw_lines_upto (Dwarf_Lines *lines, Dwarf_Addr addr)
+  internal_function __nonnull_attribute__ (1);
+
 /* Load and return value of DW_AT_comp_dir from CUDIE.  */
 const char *__libdw_getcompdir (Dwarf_Die *cudie);
 
@@ -994,11 +1352,13 @@ Dwarf_Addr __libdw_cu_base_address (Dwarf_CU *cu);
 static inline Dwarf_Off
 __libdw_cu_addr_base (Dwarf_CU *cu)
 {
-  if (cu->addr_base == (Dwarf_Off) -1)
+  Dwarf_Off offset = atomic_load_explicit (&cu->addr_base,
+					   memory_order_relaxed);
+  if (offset == (Dwarf_Off) -1)
     {
       Dwarf_Die cu_die = CUDIE(cu);
       Dwarf_Attribute attr;
-      Dwarf_Off offset = 0;
+      offset = 0;
       if (dwarf_attr (&cu_die, DW_AT_GNU_addr_base, &attr) != NULL
 	  || dwarf_attr (&cu_die, DW_AT_addr_base, &attr) != NULL)
 	{
@@ -1006,10 +1366,60 @@ __libdw_cu_addr_base (Dwarf_CU *cu)
 	  if (dwarf_formudata (&attr, &off) == 0)
 	    offset = off;
 	}
-      cu->addr_base = offset;
+      atomic_store_explicit (&cu->addr_base, offset, memory_order_relaxed);
     }
 
-  return cu->addr_base;
+  return offset;
+}
+
+/* Returns the offset of the contribution of CU to the section SEC_IDX
+   in a DWARF package file.  Zero if CU doesn't come from a package or
+   the package has no contributions for that section.  */
+static inline Dwarf_Off
+__libdw_cu_dwp_offset (Dwarf_CU *cu, size_t sec_idx)
+{
+  struct Dwarf_Package_Index *index = cu->dwp_index;
+  if (index == NULL)
+    return 0;
+
+  int sect;
+  switch (sec_idx)
+    {
+    case IDX_debug_info:
+    case IDX_debug_types:
+      sect = DW_SECT_INFO;
+      break;
+    case IDX_debug_abbrev:
+      sect = DW_SECT_ABBREV;
+      break;
+    case IDX_debug_line:
+      sect = DW_SECT_LINE;
+      break;
+    case IDX_debug_loc:
+    case IDX_debug_loclists:
+      sect = DW_SECT_LOCLISTS;
+      break;
+    case IDX_debug_str_offsets:
+      sect = DW_SECT_STR_OFFSETS;
+      break;
+    case IDX_debug_macinfo:
+    case IDX_debug_macro:
+      sect = DW_SECT_MACRO;
+      break;
+    case IDX_debug_rnglists:
+      sect = DW_SECT_RNGLISTS;
+      break;
+    default:
+      return 0;
+    }
+
+  int col = index->sections[sect];
+  if (col < 0)
+    return 0;
+
+  size_t entry = (size_t) cu->dwp_row * index->section_count + col;
+  return read_4ubyte_unaligned (index->dbg,
+				index->section_offsets + entry * 4);
 }
 
 /* Gets the .debug_str_offsets base offset to use.  static inline to
@@ -1018,10 +1428,11 @@ static inline Dwarf_Off
 str_offsets_base_off (Dwarf *dbg, Dwarf_CU *cu)
 {
   /* If we don't have a CU, then find and use the first one in the
-     debug file (when we support .dwp files, we must actually find the
-     one matching our "caller" - aka macro or line).  If we (now) have
-     a cu and str_offsets_base attribute, just use that.  Otherwise
-     use the first offset.  But we might have to parse the header
+     debug file (for .dwp files, we must actually find the one
+     matching our "caller" - aka macro or line).  If we (now) have a
+     cu and str_offsets_base attribute, just use that.  Otherwise use
+     the first offset, or the start of the contribution of the cu if
+     it comes from a .dwp file.  But we might have to parse the header
      first, but only if this is version 5.  Assume if all else fails,
      this is version 4, without header.  */
 
@@ -1035,7 +1446,9 @@ str_offsets_base_off (Dwarf *dbg, Dwarf_CU *cu)
 
   if (cu != NULL)
     {
-      if (cu->str_off_base == (Dwarf_Off) -1)
+      Dwarf_Off base = atomic_load_explicit (&cu->str_off_base,
+					     memory_order_relaxed);
+      if (base == (Dwarf_Off) -1)
 	{
 	  Dwarf_Die cu_die = CUDIE(cu);
 	  Dwarf_Attribute attr;
@@ -1044,38 +1457,43 @@ str_offsets_base_off (Dwarf *dbg, Dwarf_CU *cu)
 	      Dwarf_Word off;
 	      if (dwarf_formudata (&attr, &off) == 0)
 		{
-		  cu->str_off_base = off;
-		  return cu->str_off_base;
+		  atomic_store_explicit (&cu->str_off_base, off,
+					 memory_order_relaxed);
+		  return off;
 		}
 	    }
 	  /* For older DWARF simply assume zero (no header).  */
 	  if (cu->version < 5)
 	    {
-	      cu->str_off_base = 0;
-	      return cu->str_off_base;
+	      base = __libdw_cu_dwp_offset (cu, IDX_debug_str_offsets);
+	      atomic_store_explicit (&cu->str_off_base, base,
+				     memory_order_relaxed);
+	      return base;
 	    }
 
 	  if (dbg == NULL)
 	    dbg = cu->dbg;
 	}
       else
-	return cu->str_off_base;
+	return base;
     }
 
   /* No str_offsets_base attribute, we have to assume "zero".
      But there could be a header first.  */
-  Dwarf_Off off = 0;
+  Dwarf_Off off = (cu != NULL
+		   ? __libdw_cu_dwp_offset (cu, IDX_debug_str_offsets) : 0);
   if (dbg == NULL)
     goto no_header;
 
   Elf_Data *data =  dbg->sectiondata[IDX_debug_str_offsets];
-  if (data == NULL)
+  if (data == NULL || data->d_size < 4 || off > data->d_size - 4)
     goto no_header;
 
   const unsigned char *start;
   const unsigned char *readp;
   const unsigned char *readendp;
-  start = readp = (const unsigned char *) data->d_buf;
+  start = (const unsigned char *) data->d_buf;
+  readp = start + off;
   readendp = (const unsigned char *) data->d_buf + data->d_size;
 
   uint64_t unit_length;
@@ -1110,7 +1528,7 @@ str_offsets_base_off (Dwarf *dbg, Dwarf_CU *cu)
 
  no_header:
   if (cu != NULL)
-    cu->str_off_base = off;
+    atomic_store_explicit (&cu->str_off_base, off, memory_order_relaxed);
 
   return off;
 }
@@ -1128,9 +1546,11 @@ static inline Dwarf_Off __libdw_cu_str_off_base (Dwarf_CU *cu)
 static inline Dwarf_Off
 __libdw_cu_ranges_base (Dwarf_CU *cu)
 {
-  if (cu->ranges_base == (Dwarf_Off) -1)
+  Dwarf_Off offset = atomic_load_explicit (&cu->ranges_base,
+					   memory_order_relaxed);
+  if (offset == (Dwarf_Off) -1)
     {
-      Dwarf_Off offset = 0;
+      offset = 0;
       Dwarf_Die cu_die = CUDIE(cu);
       Dwarf_Attribute attr;
       if (cu->version < 5)
@@ -1153,12 +1573,15 @@ __libdw_cu_ranges_base (Dwarf_CU *cu)
 
 	  /* There wasn't an rnglists_base, if the Dwarf does have a
 	     .debug_rnglists section, then it might be we need the
-	     base after the first header. */
+	     base after the first header (or the header of the
+	     contribution of this unit in a .dwp file).  */
 	  Elf_Data *data = cu->dbg->sectiondata[IDX_debug_rnglists];
-	  if (offset == 0 && data != NULL)
+	  Dwarf_Off start = __libdw_cu_dwp_offset (cu, IDX_debug_rnglists);
+	  if (offset == 0 && data != NULL && start < data->d_size)
 	    {
 	      Dwarf *dbg = cu->dbg;
-	      const unsigned char *readp = data->d_buf;
+	      const unsigned char *readp
+		= (unsigned char *) data->d_buf + start;
 	      const unsigned char *const dataend
 		= (unsigned char *) data->d_buf + data->d_size;
 
@@ -1206,10 +1629,10 @@ __libdw_cu_ranges_base (Dwarf_CU *cu)
 	    }
 	}
     no_header:
-      cu->ranges_base = offset;
+      atomic_store_explicit (&cu->ranges_base, offset, memory_order_relaxed);
     }
 
-  return cu->ranges_base;
+  return offset;
 }
 
 
@@ -1217,9 +1640,11 @@ __libdw_cu_ranges_base (Dwarf_CU *cu)
 static inline Dwarf_Off
 __libdw_cu_locs_base (Dwarf_CU *cu)
 {
-  if (cu->locs_base == (Dwarf_Off) -1)
+  Dwarf_Off offset = atomic_load_explicit (&cu->locs_base,
+					   memory_order_relaxed);
+  if (offset == (Dwarf_Off) -1)
     {
-      Dwarf_Off offset = 0;
+      offset = 0;
       Dwarf_Die cu_die = CUDIE(cu);
       Dwarf_Attribute attr;
       if (dwarf_attr (&cu_die, DW_AT_loclists_base, &attr) != NULL)
@@ -1231,12 +1656,14 @@ __libdw_cu_locs_base (Dwarf_CU *cu)
 
       /* There wasn't an loclists_base, if the Dwarf does have a
 	 .debug_loclists section, then it might be we need the
-	 base after the first header. */
+	 base after the first header (or the header of the
+	 contribution of this unit in a .dwp file).  */
       Elf_Data *data = cu->dbg->sectiondata[IDX_debug_loclists];
-      if (offset == 0 && data != NULL)
+      Dwarf_Off start = __libdw_cu_dwp_offset (cu, IDX_debug_loclists);
+      if (offset == 0 && data != NULL && start < data->d_size)
 	{
 	  Dwarf *dbg = cu->dbg;
-	  const unsigned char *readp = data->d_buf;
+	  const unsigned char *readp = (unsigned char *) data->d_buf + start;
 	  const unsigned char *const dataend
 	    = (unsigned char *) data->d_buf + data->d_size;
 
@@ -1284,21 +1711,21 @@ __libdw_cu_locs_base (Dwarf_CU *cu)
 	}
 
     no_header:
-      cu->locs_base = offset;
+      atomic_store_explicit (&cu->locs_base, offset, memory_order_relaxed);
     }
 
-  return cu->locs_base;
+  return offset;
 }
 
 /* Helper function for tsearch/tfind split_tree Dwarf.  */
 int __libdw_finddbg_cb (const void *arg1, const void *arg2);
 
-/* Link skeleton and split compile units.  */
+/* Link skeleton and split compile units.  Must be called with the
+   split_lock of the skeleton Dwarf held.  */
 static inline void
 __libdw_link_skel_split (Dwarf_CU *skel, Dwarf_CU *split)
 {
-  skel->split = split;
-  split->split = skel;
+  atomic_store_explicit (&split->split, skel, memory_order_relaxed);
 
   /* Get .debug_addr and addr_base greedy.
      We also need it for the fake addr cu.
@@ -1310,17 +1737,57 @@ __libdw_link_skel_split (Dwarf_CU *skel, Dwarf_CU *split)
     {
       sdbg->sectiondata[IDX_debug_addr]
 	= dbg->sectiondata[IDX_debug_addr];
-      split->addr_base = __libdw_cu_addr_base (skel);
       sdbg->fake_addr_cu = dbg->fake_addr_cu;
     }
+
+  /* A .dwp file is shared by all skeletons, so each split unit needs
+     the addr_base of its own skeleton.  */
+  if (sdbg->sectiondata[IDX_debug_addr] == dbg->sectiondata[IDX_debug_addr]
+      && dbg->sectiondata[IDX_debug_addr] != NULL)
+    atomic_store_explicit (&split->addr_base, __libdw_cu_addr_base (skel),
+			   memory_order_relaxed);
+
+  /* Publish the split unit only after it is completely set up, other
+     threads use it without taking the split_lock.  */
+  atomic_store_explicit (&skel->split, split, memory_order_release);
 }
 
 
+/* Decode the DWARF package index in section SEC_IDX, which is either
+   IDX_debug_cu_index or IDX_debug_tu_index.  Returns NULL if DBG
+   doesn't have the section or the index cannot be used.  */
+struct Dwarf_Package_Index *__libdw_dwp_index (Dwarf *dbg, size_t sec_idx)
+  internal_function;
+
+/* Free an index returned by __libdw_dwp_index.  */
+void __libdw_dwp_index_free (struct Dwarf_Package_Index *index)
+  internal_function;
+
+/* Find the row of INDEX for the unit starting at OFF in the
+   .debug_info (or .debug_types) section.  Returns true and sets
+   *ROWP if found.  */
+bool __libdw_dwp_find_row (struct Dwarf_Package_Index *index, Dwarf_Off off,
+			   uint32_t *rowp)
+  internal_function;
+
+/* Find the DWARF package file for DBG, opening it the first time.
+   Returns NULL if there is none.  */
+Dwarf *__libdw_find_dwp (Dwarf *dbg) internal_function;
+
+/* Find the split compile unit with DWO id ID8 in the package DWP.
+   Returns NULL if not found.  */
+Dwarf_CU *__libdw_dwp_findcu_id (Dwarf *dwp, uint64_t id8)
+  internal_function;
+
 /* Given an address index for a CU return the address.
    Returns -1 and sets libdw_errno if an error occurs.  */
 int __libdw_addrx (Dwarf_CU *cu, Dwarf_Word idx, Dwarf_Addr *addr);
 
 
+/* The absolute path of the file open as FD, malloc'd, or NULL if it
+   isn't known.  */
+char * __libdw_fdpath (int fd);
+
 /* Helper function to set debugdir field in Dwarf, used from dwarf_begin_elf
    and libdwfl process_file.  */
 char * __libdw_debugdir (int fd);
@@ -1363,12 +1830,15 @@ INTDECL (dwarf_formref_die)
 INTDECL (dwarf_formsdata)
 INTDECL (dwarf_formstring)
 INTDECL (dwarf_formudata)
+INTDECL (dwarf_get_unit_list)
 INTDECL (dwarf_getabbrevattr_data)
 INTDECL (dwarf_getalt)
 INTDECL (dwarf_getarange_addr)
 INTDECL (dwarf_getarangeinfo)
 INTDECL (dwarf_getaranges)
+INTDECL (dwarf_getattrs)
 INTDECL (dwarf_getlocation_die)
+INTDECL (dwarf_getlocations)
 INTDECL (dwarf_getsrcfiles)
 INTDECL (dwarf_getsrclines)
 INTDECL (dwarf_hasattr)
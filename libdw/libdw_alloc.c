@@ -32,6 +32,7 @@
 #endif
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include "libdwP.h"
 #include "system.h"
@@ -43,62 +44,150 @@
 #define ANNOTATE_HAPPENS_AFTER(X)
 #endif
 
+
+/* Thread ids are small numbers, reused after a thread exits, so the
+   per Dwarf tables indexed by them stay as small as the largest number
+   of threads alive at the same time.  The tails of an exited thread
+   are simply continued by the next thread getting its id.  */
 #define THREAD_ID_UNSET ((size_t) -1)
 static __thread size_t thread_id = THREAD_ID_UNSET;
-static atomic_size_t next_id = ATOMIC_VAR_INIT(0);
 
-struct libdw_memblock *
-__libdw_alloc_tail (Dwarf *dbg)
+static pthread_once_t thread_id_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_id_key;
+static bool thread_id_key_valid;
+
+/* Ids released by exited threads, and the next never used id.  Only
+   touched when a thread starts or stops using libdw.  */
+static pthread_mutex_t thread_id_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t *free_ids;
+static size_t nfree_ids;
+static size_t free_ids_alloc;
+static size_t next_id;
+
+static void
+release_thread_id (void *arg)
+{
+  size_t id = (uintptr_t) arg - 1;
+
+  /* This runs in the exiting thread.  Other destructors may still use
+     libdw after this, which must then not use the id given away here,
+     but get a new one that is released again.  */
+  thread_id = THREAD_ID_UNSET;
+
+  pthread_mutex_lock (&thread_id_lock);
+  if (nfree_ids == free_ids_alloc)
+    {
+      size_t n = free_ids_alloc == 0 ? 16 : 2 * free_ids_alloc;
+      size_t *ids = realloc (free_ids, n * sizeof (size_t));
+      if (ids == NULL)
+	{
+	  /* Just don't reuse this id then.  */
+	  pthread_mutex_unlock (&thread_id_lock);
+	  return;
+	}
+      free_ids = ids;
+      free_ids_alloc = n;
+    }
+  free_ids[nfree_ids++] = id;
+  pthread_mutex_unlock (&thread_id_lock);
+}
+
+static void
+init_thread_id_key (void)
+{
+  thread_id_key_valid = pthread_key_create (&thread_id_key,
+					    release_thread_id) == 0;
+}
+
+static void __attribute__ ((destructor))
+free_thread_ids (void)
+{
+  /* Make sure no destructor runs after libdw is unloaded.  */
+  if (thread_id_key_valid)
+    pthread_key_delete (thread_id_key);
+  free (free_ids);
+}
+
+static size_t
+get_thread_id (void)
 {
-  if (thread_id == THREAD_ID_UNSET)
-    thread_id = atomic_fetch_add (&next_id, 1);
+  if (likely (thread_id != THREAD_ID_UNSET))
+    return thread_id;
 
-  pthread_rwlock_rdlock (&dbg->mem_rwl);
-  if (thread_id >= dbg->mem_stacks)
+  pthread_once (&thread_id_once, init_thread_id_key);
+
+  size_t id;
+  pthread_mutex_lock (&thread_id_lock);
+  if (nfree_ids > 0)
+    id = free_ids[--nfree_ids];
+  else
+    id = next_id++;
+  pthread_mutex_unlock (&thread_id_lock);
+
+  /* Without a key the id is never released, which only costs memory.  */
+  if (thread_id_key_valid)
+    pthread_setspecific (thread_id_key, (void *) (uintptr_t) (id + 1));
+
+  thread_id = id;
+  return id;
+}
+
+/* Return the slot holding the memory block tail of thread ID in DBG.
+   Calls the oom_handler if it cannot be allocated.  */
+static struct libdw_memblock **
+thread_tail_slot (Dwarf *dbg, size_t id)
+{
+  /* Chunk K holds the ids 64 * (2^K - 1) up to 64 * (2^(K+1) - 1).  */
+  size_t n = id / 64 + 1;
+  size_t chunk = sizeof (unsigned long) * 8 - 1 - __builtin_clzl (n);
+  if (unlikely (chunk >= LIBDW_MEM_CHUNKS))
+    dbg->oom_handler ();
+  size_t idx = id - 64 * (((size_t) 1 << chunk) - 1);
+
+  struct libdw_memblock **tails
+    = atomic_load_explicit (&dbg->mem_tails[chunk], memory_order_acquire);
+  if (unlikely (tails == NULL))
     {
-      pthread_rwlock_unlock (&dbg->mem_rwl);
-      pthread_rwlock_wrlock (&dbg->mem_rwl);
-
-      /* Another thread may have already reallocated. In theory using an
-         atomic would be faster, but given that this only happens once per
-         thread per Dwarf, some minor slowdown should be fine.  */
-      if (thread_id >= dbg->mem_stacks)
-        {
-          dbg->mem_tails = realloc (dbg->mem_tails, (thread_id+1)
-                                    * sizeof (struct libdw_memblock *));
-          if (dbg->mem_tails == NULL)
-            {
-              pthread_rwlock_unlock (&dbg->mem_rwl);
-              dbg->oom_handler();
-            }
-          for (size_t i = dbg->mem_stacks; i <= thread_id; i++)
-            dbg->mem_tails[i] = NULL;
-          dbg->mem_stacks = thread_id + 1;
-          ANNOTATE_HAPPENS_BEFORE (&dbg->mem_tails);
-        }
-
-      pthread_rwlock_unlock (&dbg->mem_rwl);
-      pthread_rwlock_rdlock (&dbg->mem_rwl);
+      tails = calloc ((size_t) 64 << chunk, sizeof (struct libdw_memblock *));
+      if (tails == NULL)
+	dbg->oom_handler ();
+
+      /* Another thread might have installed the chunk first.  */
+      struct libdw_memblock **expected = NULL;
+      if (atomic_compare_exchange_strong_explicit (&dbg->mem_tails[chunk],
+						   &expected, tails,
+						   memory_order_acq_rel,
+						   memory_order_acquire))
+	{
+	  ANNOTATE_HAPPENS_BEFORE (&dbg->mem_tails[chunk]);
+	}
+      else
+	{
+	  free (tails);
+	  tails = expected;
+	}
     }
 
-  /* At this point, we have an entry in the tail array.  */
-  ANNOTATE_HAPPENS_AFTER (&dbg->mem_tails);
-  struct libdw_memblock *result = dbg->mem_tails[thread_id];
+  ANNOTATE_HAPPENS_AFTER (&dbg->mem_tails[chunk]);
+  return &tails[idx];
+}
+
+struct libdw_memblock *
+__libdw_alloc_tail (Dwarf *dbg)
+{
+  struct libdw_memblock **slot = thread_tail_slot (dbg, get_thread_id ());
+  struct libdw_memblock *result = *slot;
   if (result == NULL)
     {
       result = malloc (dbg->mem_default_size);
       if (result == NULL)
-	{
-	  pthread_rwlock_unlock (&dbg->mem_rwl);
-	  dbg->oom_handler();
-	}
+	dbg->oom_handler();
       result->size = dbg->mem_default_size
                      - offsetof (struct libdw_memblock, mem);
       result->remaining = result->size;
       result->prev = NULL;
-      dbg->mem_tails[thread_id] = result;
+      *slot = result;
     }
-  pthread_rwlock_unlock (&dbg->mem_rwl);
   return result;
 }
 
@@ -107,11 +196,7 @@ __libdw_alloc_tail (Dwarf *dbg)
 struct libdw_memblock *
 __libdw_thread_tail (Dwarf *dbg)
 {
-  struct libdw_memblock *result;
-  pthread_rwlock_rdlock (&dbg->mem_rwl);
-  result = dbg->mem_tails[thread_id];
-  pthread_rwlock_unlock (&dbg->mem_rwl);
-  return result;
+  return *thread_tail_slot (dbg, thread_id);
 }
 
 void *
@@ -129,10 +214,9 @@ __libdw_allocate (Dwarf *dbg, size_t minsize, size_t align)
   newp->size = size - offsetof (struct libdw_memblock, mem);
   newp->remaining = (uintptr_t) newp + size - (result + minsize);
 
-  pthread_rwlock_rdlock (&dbg->mem_rwl);
-  newp->prev = dbg->mem_tails[thread_id];
-  dbg->mem_tails[thread_id] = newp;
-  pthread_rwlock_unlock (&dbg->mem_rwl);
+  struct libdw_memblock **slot = thread_tail_slot (dbg, thread_id);
+  newp->prev = *slot;
+  *slot = newp;
 
   return (void *) result;
 }
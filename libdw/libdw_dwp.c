@@ -0,0 +1,350 @@
+/* Find units in DWARF package (.dwp) files through their index.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libdwP.h"
+#include <dwarf.h>
+
+
+/* The GNU version 2 index uses its own section identifiers.  */
+enum
+  {
+    DW_SECT_V2_INFO = 1,
+    DW_SECT_V2_TYPES = 2,
+    DW_SECT_V2_ABBREV = 3,
+    DW_SECT_V2_LINE = 4,
+    DW_SECT_V2_LOC = 5,
+    DW_SECT_V2_STR_OFFSETS = 6,
+    DW_SECT_V2_MACINFO = 7,
+    DW_SECT_V2_MACRO = 8,
+  };
+
+static int
+map_v2_section (uint32_t id)
+{
+  switch (id)
+    {
+    case DW_SECT_V2_INFO:
+    case DW_SECT_V2_TYPES:
+      return DW_SECT_INFO;
+    case DW_SECT_V2_ABBREV:
+      return DW_SECT_ABBREV;
+    case DW_SECT_V2_LINE:
+      return DW_SECT_LINE;
+    case DW_SECT_V2_LOC:
+      return DW_SECT_LOCLISTS;
+    case DW_SECT_V2_STR_OFFSETS:
+      return DW_SECT_STR_OFFSETS;
+    case DW_SECT_V2_MACINFO:
+    case DW_SECT_V2_MACRO:
+      return DW_SECT_MACRO;
+    default:
+      return -1;
+    }
+}
+
+static uint32_t
+section_offset (struct Dwarf_Package_Index *index, uint32_t row, int sect)
+{
+  size_t entry = (size_t) row * index->section_count + index->sections[sect];
+  return read_4ubyte_unaligned (index->dbg,
+				index->section_offsets + entry * 4);
+}
+
+static uint32_t
+section_size (struct Dwarf_Package_Index *index, uint32_t row, int sect)
+{
+  size_t entry = (size_t) row * index->section_count + index->sections[sect];
+  return read_4ubyte_unaligned (index->dbg, index->section_sizes + entry * 4);
+}
+
+static int
+compare_uint64 (const void *a, const void *b)
+{
+  uint64_t v1 = *(const uint64_t *) a;
+  uint64_t v2 = *(const uint64_t *) b;
+  return v1 < v2 ? -1 : v1 > v2;
+}
+
+struct Dwarf_Package_Index *
+internal_function
+__libdw_dwp_index (Dwarf *dbg, size_t sec_idx)
+{
+  Elf_Data *data = dbg->sectiondata[sec_idx];
+  if (data == NULL || data->d_size < 16)
+    return NULL;
+
+  const unsigned char *readp = data->d_buf;
+  const unsigned char *const dataend = readp + data->d_size;
+
+  /* The GNU extension has a 4 byte version 2, DWARF5 a 2 byte version
+     5 followed by 2 bytes padding.  */
+  uint32_t version = read_4ubyte_unaligned (dbg, readp);
+  if (version != 2)
+    {
+      version = read_2ubyte_unaligned (dbg, readp);
+      if (version != 5)
+	return NULL;
+    }
+  readp += 4;
+
+  uint32_t section_count = read_4ubyte_unaligned_inc (dbg, readp);
+  uint32_t unit_count = read_4ubyte_unaligned_inc (dbg, readp);
+  uint32_t slot_count = read_4ubyte_unaligned_inc (dbg, readp);
+
+  /* The number of slots must be a power of two larger than the number
+     of units.  There are only a handful of different sections.  */
+  if ((slot_count & (slot_count - 1)) != 0
+      || unit_count > slot_count
+      || (unit_count > 0 && section_count == 0)
+      || section_count > 255)
+    return NULL;
+
+  uint64_t needed = ((uint64_t) slot_count * 12 + (uint64_t) section_count * 4
+		     + (uint64_t) unit_count * section_count * 8);
+  if ((uint64_t) (dataend - readp) < needed)
+    return NULL;
+
+  struct Dwarf_Package_Index *index = calloc (1, sizeof *index);
+  if (index == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return NULL;
+    }
+
+  index->dbg = dbg;
+  index->section_count = section_count;
+  index->unit_count = unit_count;
+  index->slot_count = slot_count;
+  index->hash_table = readp;
+  index->indices = readp + (size_t) slot_count * 8;
+  const unsigned char *ids = index->indices + (size_t) slot_count * 4;
+  index->section_offsets = ids + (size_t) section_count * 4;
+  index->section_sizes = (index->section_offsets
+			  + (size_t) unit_count * section_count * 4);
+
+  for (size_t i = 0; i <= DW_SECT_RNGLISTS; i++)
+    index->sections[i] = -1;
+  for (uint32_t i = 0; i < section_count; i++)
+    {
+      uint32_t id = read_4ubyte_unaligned (dbg, ids + i * 4);
+      int sect;
+      if (version == 2)
+	{
+	  sect = map_v2_section (id);
+	  /* Prefer .debug_macro over .debug_macinfo, GCC only emits
+	     the first for split DWARF.  */
+	  if (sect == DW_SECT_MACRO && id == DW_SECT_V2_MACINFO
+	      && index->sections[sect] != -1)
+	    continue;
+	}
+      else
+	sect = (id == 2 || id > DW_SECT_RNGLISTS) ? -1 : (int) id;
+      if (sect > 0)
+	index->sections[sect] = i;
+    }
+
+  /* Without the units themselves the index is useless.  */
+  if (unit_count > 0 && index->sections[DW_SECT_INFO] == -1)
+    {
+      free (index);
+      return NULL;
+    }
+
+  /* Sort the rows by unit offset, so we can find the row for a unit
+     when reading the units sequentially.  Offsets are 32 bits, so
+     sort them together with the row number.  */
+  if (unit_count > 0)
+    {
+      uint64_t *sorted = malloc (unit_count * sizeof (uint64_t));
+      index->info_rows = malloc (unit_count * sizeof (uint32_t));
+      if (sorted == NULL || index->info_rows == NULL)
+	{
+	  free (sorted);
+	  __libdw_dwp_index_free (index);
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return NULL;
+	}
+
+      for (uint32_t row = 0; row < unit_count; row++)
+	sorted[row] = ((uint64_t) section_offset (index, row, DW_SECT_INFO)
+		       << 32) | row;
+      qsort (sorted, unit_count, sizeof (uint64_t), compare_uint64);
+      for (uint32_t i = 0; i < unit_count; i++)
+	index->info_rows[i] = (uint32_t) sorted[i];
+      free (sorted);
+    }
+
+  return index;
+}
+
+void
+internal_function
+__libdw_dwp_index_free (struct Dwarf_Package_Index *index)
+{
+  if (index != NULL)
+    {
+      free (index->info_rows);
+      free (index);
+    }
+}
+
+bool
+internal_function
+__libdw_dwp_find_row (struct Dwarf_Package_Index *index, Dwarf_Off off,
+		      uint32_t *rowp)
+{
+  /* Find the last contribution starting at or before OFF.  */
+  size_t l = 0;
+  size_t u = index->unit_count;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      if (section_offset (index, index->info_rows[idx], DW_SECT_INFO) <= off)
+	l = idx + 1;
+      else
+	u = idx;
+    }
+  if (l == 0)
+    return false;
+
+  uint32_t row = index->info_rows[l - 1];
+  if (off - section_offset (index, row, DW_SECT_INFO)
+      >= section_size (index, row, DW_SECT_INFO))
+    return false;
+
+  *rowp = row;
+  return true;
+}
+
+static Dwarf *
+try_dwp_file (const char *dwp_path)
+{
+  Dwarf *dwp = NULL;
+  int fd = open (dwp_path, O_RDONLY);
+  if (fd != -1)
+    {
+      dwp = INTUSE(dwarf_begin) (fd, DWARF_C_READ);
+      if (dwp != NULL)
+	{
+	  if (dwp->cu_index != NULL)
+	    /* We have everything we need from this ELF file.  And we
+	       are going to close the fd to not run out of file
+	       descriptors.  */
+	    elf_cntl (dwp->elf, ELF_C_FDDONE);
+	  else
+	    {
+	      INTUSE(dwarf_end) (dwp);
+	      dwp = NULL;
+	    }
+	}
+      close (fd);
+    }
+  return dwp;
+}
+
+Dwarf *
+internal_function
+__libdw_find_dwp (Dwarf *dbg)
+{
+  /* Only try once.  */
+  if (dbg->dwp_dwarf != (Dwarf *) -1)
+    return dbg->dwp_dwarf;
+
+  dbg->dwp_dwarf = NULL;
+  if (dbg->elfpath == NULL)
+    return NULL;
+
+  /* The package is normally installed next to the executable as
+     <executable>.dwp.  If we are looking at a separate .debug file,
+     also try the name without the .debug suffix.  */
+  size_t len = strlen (dbg->elfpath);
+  char *dwp_path = malloc (len + sizeof ".dwp");
+  if (dwp_path == NULL)
+    return NULL;
+
+  strcpy (stpcpy (dwp_path, dbg->elfpath), ".dwp");
+  dbg->dwp_dwarf = try_dwp_file (dwp_path);
+  if (dbg->dwp_dwarf == NULL && len > strlen (".debug")
+      && strcmp (dbg->elfpath + len - strlen (".debug"), ".debug") == 0)
+    {
+      strcpy (dwp_path + len - strlen (".debug"), ".dwp");
+      dbg->dwp_dwarf = try_dwp_file (dwp_path);
+    }
+
+  free (dwp_path);
+  return dbg->dwp_dwarf;
+}
+
+Dwarf_CU *
+internal_function
+__libdw_dwp_findcu_id (Dwarf *dwp, uint64_t id8)
+{
+  struct Dwarf_Package_Index *index = dwp->cu_index;
+  if (index == NULL || index->slot_count == 0)
+    return NULL;
+
+  /* Open addressing with a secondary hash, as described in the
+     DWARF5 specification, section 7.3.5.3.  */
+  uint32_t mask = index->slot_count - 1;
+  uint32_t slot = id8 & mask;
+  uint32_t step = ((id8 >> 32) & mask) | 1;
+  for (uint32_t n = 0; n < index->slot_count; n++)
+    {
+      uint32_t row = read_4ubyte_unaligned (dwp, (index->indices
+						  + (size_t) slot * 4));
+      if (row == 0)
+	return NULL;
+
+      uint64_t sig = read_8ubyte_unaligned (dwp, (index->hash_table
+						  + (size_t) slot * 8));
+      if (sig == id8)
+	{
+	  if (row > index->unit_count)
+	    return NULL;
+
+	  Dwarf_Off off = section_offset (index, row - 1, DW_SECT_INFO);
+	  Dwarf_CU *cu = __libdw_findcu (dwp, off, false);
+	  if (cu != NULL && cu->unit_type == DW_UT_split_compile
+	      && cu->unit_id8 == id8)
+	    return cu;
+	  return NULL;
+	}
+
+      slot = (slot + step) & mask;
+    }
+
+  return NULL;
+}
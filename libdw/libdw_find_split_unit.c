@@ -76,7 +76,8 @@ try_split_file (Dwarf_CU *cu, const char *dwo_path)
 		  break;
 		}
 	    }
-	  if (cu->split == (Dwarf_CU *) -1)
+	  if (atomic_load_explicit (&cu->split, memory_order_relaxed)
+	      == (Dwarf_CU *) -1)
 	    dwarf_end (split_dwarf);
 	}
       /* Always close, because we don't want to run out of file
@@ -86,18 +87,59 @@ try_split_file (Dwarf_CU *cu, const char *dwo_path)
     }
 }
 
+static void
+try_dwp_file (Dwarf_CU *cu)
+{
+  Dwarf *dwp = __libdw_find_dwp (cu->dbg);
+  if (dwp == NULL)
+    return;
+
+  Dwarf_CU *split = __libdw_dwp_findcu_id (dwp, cu->unit_id8);
+  if (split != NULL)
+    {
+      if (tsearch (split->dbg, &cu->dbg->split_tree,
+		   __libdw_finddbg_cb) == NULL)
+	{
+	  /* Something went wrong.  Don't link.  */
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return;
+	}
+
+      /* Link skeleton and split compile units.  */
+      __libdw_link_skel_split (cu, split);
+    }
+}
+
 Dwarf_CU *
 internal_function
 __libdw_find_split_unit (Dwarf_CU *cu)
 {
   /* Only try once.  */
-  if (cu->split != (Dwarf_CU *) -1)
-    return cu->split;
+  Dwarf_CU *split = atomic_load_explicit (&cu->split, memory_order_acquire);
+  if (split != (Dwarf_CU *) -1)
+    return split;
+
+  /* Searching opens files and updates the split_tree, so only one
+     thread searches at a time.  Another might have found it while
+     we waited.  */
+  pthread_mutex_lock (&cu->dbg->split_lock);
+  split = atomic_load_explicit (&cu->split, memory_order_relaxed);
+  if (split != (Dwarf_CU *) -1)
+    {
+      pthread_mutex_unlock (&cu->dbg->split_lock);
+      return split;
+    }
 
   /* We need a skeleton unit with a comp_dir and [GNU_]dwo_name attributes.
      The split unit will be the first in the dwo file and should have the
-     same id as the skeleton.  */
+     same id as the skeleton.  But first try the DWARF package file, which
+     holds the split units of all skeletons, if there is one.  */
   if (cu->unit_type == DW_UT_skeleton)
+    try_dwp_file (cu);
+
+  if (cu->unit_type == DW_UT_skeleton
+      && (atomic_load_explicit (&cu->split, memory_order_relaxed)
+	  == (Dwarf_CU *) -1))
     {
       Dwarf_Die cudie = CUDIE (cu);
       Dwarf_Attribute dwo_name;
@@ -117,7 +159,8 @@ __libdw_find_split_unit (Dwarf_CU *cu)
 	      free (dwo_path);
 	    }
 
-	  if (cu->split == (Dwarf_CU *) -1)
+	  if (atomic_load_explicit (&cu->split, memory_order_relaxed)
+	      == (Dwarf_CU *) -1)
 	    {
 	      /* Try compdir plus dwo_name.  */
 	      Dwarf_Attribute compdir;
@@ -140,8 +183,13 @@ __libdw_find_split_unit (Dwarf_CU *cu)
     }
 
   /* If we found nothing, make sure we don't try again.  */
-  if (cu->split == (Dwarf_CU *) -1)
-    cu->split = NULL;
+  split = atomic_load_explicit (&cu->split, memory_order_relaxed);
+  if (split == (Dwarf_CU *) -1)
+    {
+      split = NULL;
+      atomic_store_explicit (&cu->split, split, memory_order_release);
+    }
+  pthread_mutex_unlock (&cu->dbg->split_lock);
 
-  return cu->split;
+  return split;
 }
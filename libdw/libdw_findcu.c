@@ -33,32 +33,66 @@
 
 #include <assert.h>
 #include <search.h>
+#include <stdlib.h>
+#include <string.h>
 #include "libdwP.h"
 
-static int
-findcu_cb (const void *arg1, const void *arg2)
+/* Find the unit containing offset START in TABLE.  Only looks at the
+   units already read, doesn't need the units_lock.  */
+static struct Dwarf_CU *
+find_unit (struct libdw_unit_table *table, Dwarf_Off start)
 {
-  struct Dwarf_CU *cu1 = (struct Dwarf_CU *) arg1;
-  struct Dwarf_CU *cu2 = (struct Dwarf_CU *) arg2;
+  /* The units are published by storing the array before the count
+     that covers it, so load them in the opposite order.  */
+  size_t n = atomic_load_explicit (&table->nunits, memory_order_acquire);
+  struct libdw_unit_array *array
+    = atomic_load_explicit (&table->array, memory_order_acquire);
+  if (n == 0)
+    return NULL;
 
-  /* Find out which of the two arguments is the search value.  It has
-     end offset 0.  */
-  if (cu1->end == 0)
+  size_t l = 0;
+  size_t u = n;
+  while (l < u)
     {
-      if (cu1->start < cu2->start)
-	return -1;
-      if (cu1->start >= cu2->end)
-	return 1;
+      size_t idx = (l + u) / 2;
+      struct Dwarf_CU *cu = array->units[idx];
+      if (start < cu->start)
+	u = idx;
+      else if (start >= cu->end)
+	l = idx + 1;
+      else
+	return cu;
     }
-  else
+
+  return NULL;
+}
+
+/* Append CU to TABLE.  Must be called with the units_lock held.  */
+static bool
+add_unit (struct libdw_unit_table *table, struct Dwarf_CU *cu)
+{
+  size_t n = atomic_load_explicit (&table->nunits, memory_order_relaxed);
+  struct libdw_unit_array *array
+    = atomic_load_explicit (&table->array, memory_order_relaxed);
+  if (array == NULL || n == array->nalloc)
     {
-      if (cu2->start < cu1->start)
-	return 1;
-      if (cu2->start >= cu1->end)
-	return -1;
+      size_t nalloc = array == NULL ? 16 : 2 * array->nalloc;
+      struct libdw_unit_array *newp
+	= malloc (sizeof (*newp) + nalloc * sizeof (struct Dwarf_CU *));
+      if (newp == NULL)
+	return false;
+
+      newp->prev = array;
+      newp->nalloc = nalloc;
+      if (n > 0)
+	memcpy (newp->units, array->units, n * sizeof (struct Dwarf_CU *));
+      atomic_store_explicit (&table->array, newp, memory_order_release);
+      array = newp;
     }
 
-  return 0;
+  array->units[n] = cu;
+  atomic_store_explicit (&table->nunits, n + 1, memory_order_release);
+  return true;
 }
 
 int
@@ -95,13 +129,13 @@ __libdw_finddbg_cb (const void *arg1, const void *arg2)
   return 0;
 }
 
-struct Dwarf_CU *
-internal_function
-__libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
+/* Read the next unit.  Must be called with the units_lock held.  */
+static struct Dwarf_CU *
+intern_next_unit (Dwarf *dbg, bool debug_types)
 {
-  Dwarf_Off *const offsetp
-    = debug_types ? &dbg->next_tu_offset : &dbg->next_cu_offset;
-  void **tree = debug_types ? &dbg->tu_tree : &dbg->cu_tree;
+  struct libdw_unit_table *table
+    = debug_types ? &dbg->tu_table : &dbg->cu_table;
+  Dwarf_Off *const offsetp = &table->next_offset;
 
   Dwarf_Off oldoff = *offsetp;
   uint16_t version;
@@ -155,17 +189,45 @@ __libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
   newp->version = version;
   newp->unit_id8 = unit_id8;
   newp->subdie_offset = subdie_offset;
-  Dwarf_Abbrev_Hash_init (&newp->abbrev_hash, 41);
-  newp->orig_abbrev_offset = newp->last_abbrev_offset = abbrev_offset;
-  newp->files = NULL;
-  newp->lines = NULL;
-  newp->locs = NULL;
-  newp->split = (Dwarf_CU *) -1;
+
+  /* In a DWARF package file all offsets in the unit header and DIEs
+     are relative to the contributions of the unit to each section.  */
+  newp->dwp_index = NULL;
+  newp->dwp_row = 0;
+  struct Dwarf_Package_Index *index
+    = ((debug_types || (version >= 5 && (unit_type == DW_UT_type
+					 || unit_type == DW_UT_split_type)))
+       ? dbg->tu_index : dbg->cu_index);
+  if (index != NULL && __libdw_dwp_find_row (index, oldoff, &newp->dwp_row))
+    {
+      newp->dwp_index = index;
+      abbrev_offset += __libdw_cu_dwp_offset (newp, IDX_debug_abbrev);
+    }
+
+  /* Units using the same abbreviations share their decoded table.  */
+  newp->abbrevs = __libdw_abbrev_table (dbg, abbrev_offset, version,
+					address_size, offset_size);
+  if (unlikely (newp->abbrevs == NULL))
+    {
+      libdw_typed_unalloc (dbg, struct Dwarf_CU);
+      return NULL;
+    }
+  newp->orig_abbrev_offset = abbrev_offset;
+  atomic_store_explicit (&newp->files, NULL, memory_order_relaxed);
+  atomic_store_explicit (&newp->lines, NULL, memory_order_relaxed);
+  atomic_store_explicit (&newp->locs, NULL, memory_order_relaxed);
+  atomic_store_explicit (&newp->scope_index, NULL, memory_order_relaxed);
+  atomic_store_explicit (&newp->split, (Dwarf_CU *) -1,
+			 memory_order_relaxed);
   newp->base_address = (Dwarf_Addr) -1;
-  newp->addr_base = (Dwarf_Off) -1;
-  newp->str_off_base = (Dwarf_Off) -1;
-  newp->ranges_base = (Dwarf_Off) -1;
-  newp->locs_base = (Dwarf_Off) -1;
+  atomic_store_explicit (&newp->addr_base, (Dwarf_Off) -1,
+			 memory_order_relaxed);
+  atomic_store_explicit (&newp->str_off_base, (Dwarf_Off) -1,
+			 memory_order_relaxed);
+  atomic_store_explicit (&newp->ranges_base, (Dwarf_Off) -1,
+			 memory_order_relaxed);
+  atomic_store_explicit (&newp->locs_base, (Dwarf_Off) -1,
+			 memory_order_relaxed);
 
   newp->startp = data->d_buf + newp->start;
   newp->endp = data->d_buf + newp->end;
@@ -212,8 +274,8 @@ __libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
   if (unit_type == DW_UT_type || unit_type == DW_UT_split_type)
     Dwarf_Sig8_Hash_insert (&dbg->sig8_hash, unit_id8, newp);
 
-  /* Add the new entry to the search tree.  */
-  if (tsearch (newp, tree, findcu_cb) == NULL)
+  /* Add the new entry to the unit table.  */
+  if (! add_unit (table, newp))
     {
       /* Something went wrong.  Undo the operation.  */
       *offsetp = oldoff;
@@ -224,36 +286,53 @@ __libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
   return newp;
 }
 
+struct Dwarf_CU *
+internal_function
+__libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
+{
+  pthread_mutex_lock (&dbg->units_lock);
+  struct Dwarf_CU *newp = intern_next_unit (dbg, debug_types);
+  pthread_mutex_unlock (&dbg->units_lock);
+  return newp;
+}
+
 struct Dwarf_CU *
 internal_function
 __libdw_findcu (Dwarf *dbg, Dwarf_Off start, bool v4_debug_types)
 {
-  void **tree = v4_debug_types ? &dbg->tu_tree : &dbg->cu_tree;
-  Dwarf_Off *next_offset
-    = v4_debug_types ? &dbg->next_tu_offset : &dbg->next_cu_offset;
+  struct libdw_unit_table *table
+    = v4_debug_types ? &dbg->tu_table : &dbg->cu_table;
 
-  /* Maybe we already know that CU.  */
-  struct Dwarf_CU fake = { .start = start, .end = 0 };
-  struct Dwarf_CU **found = tfind (&fake, tree, findcu_cb);
+  /* Maybe we already know that CU.  This is the common case and
+     doesn't need the lock.  */
+  struct Dwarf_CU *found = find_unit (table, start);
   if (found != NULL)
-    return *found;
+    return found;
 
-  if (start < *next_offset)
+  pthread_mutex_lock (&dbg->units_lock);
+
+  /* Another thread might have read it in the meantime.  */
+  if (start < table->next_offset)
     {
-      __libdw_seterrno (DWARF_E_INVALID_DWARF);
-      return NULL;
+      found = find_unit (table, start);
+      if (found == NULL)
+	__libdw_seterrno (DWARF_E_INVALID_DWARF);
+      pthread_mutex_unlock (&dbg->units_lock);
+      return found;
     }
 
   /* No.  Then read more CUs.  */
   while (1)
     {
-      struct Dwarf_CU *newp = __libdw_intern_next_unit (dbg, v4_debug_types);
-      if (newp == NULL)
-	return NULL;
+      struct Dwarf_CU *newp = intern_next_unit (dbg, v4_debug_types);
 
       /* Is this the one we are looking for?  */
-      if (start < *next_offset || start == newp->start)
-	return newp;
+      if (newp == NULL
+	  || start < table->next_offset || start == newp->start)
+	{
+	  pthread_mutex_unlock (&dbg->units_lock);
+	  return newp;
+	}
     }
   /* NOTREACHED */
 }
@@ -262,13 +341,13 @@ struct Dwarf_CU *
 internal_function
 __libdw_findcu_addr (Dwarf *dbg, void *addr)
 {
-  void **tree;
+  struct libdw_unit_table *table;
   Dwarf_Off start;
   if (addr >= dbg->sectiondata[IDX_debug_info]->d_buf
       && addr < (dbg->sectiondata[IDX_debug_info]->d_buf
 		 + dbg->sectiondata[IDX_debug_info]->d_size))
     {
-      tree = &dbg->cu_tree;
+      table = &dbg->cu_table;
       start = addr - dbg->sectiondata[IDX_debug_info]->d_buf;
     }
   else if (dbg->sectiondata[IDX_debug_types] != NULL
@@ -276,19 +355,13 @@ __libdw_findcu_addr (Dwarf *dbg, void *addr)
 	   && addr < (dbg->sectiondata[IDX_debug_types]->d_buf
 		      + dbg->sectiondata[IDX_debug_types]->d_size))
     {
-      tree = &dbg->tu_tree;
+      table = &dbg->tu_table;
       start = addr - dbg->sectiondata[IDX_debug_types]->d_buf;
     }
   else
     return NULL;
 
-  struct Dwarf_CU fake = { .start = start, .end = 0 };
-  struct Dwarf_CU **found = tfind (&fake, tree, findcu_cb);
-
-  if (found != NULL)
-    return *found;
-
-  return NULL;
+  return find_unit (table, start);
 }
 
 Dwarf *
@@ -111,8 +111,7 @@ __libdw_form_val_compute_len (struct Dwarf_CU *cu, unsigned int form,
     case DW_FORM_strx:
     case DW_FORM_GNU_addr_index:
     case DW_FORM_GNU_str_index:
-      get_uleb128 (u128, valp, endp);
-      result = valp - startp;
+      result = __libdw_skip_uleb128 (valp, endp);
       break;
 
     case DW_FORM_indirect:
@@ -0,0 +1,430 @@
+/* Use the GDB .gdb_index section as address and name accelerator.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libdwP.h"
+#include <dwarf.h>
+#include <system.h>
+
+
+/* The .gdb_index is always little endian, whatever the ELF file is.  */
+#define read_le32(p) LE32 (read_4ubyte_unaligned_noncvt (p))
+#define read_le64(p) LE64 (read_8ubyte_unaligned_noncvt (p))
+
+struct gdb_index
+{
+  uint32_t version;
+  const unsigned char *cu_list;
+  size_t cu_count;
+  const unsigned char *addr_list;
+  size_t addr_count;
+  const unsigned char *symtab;
+  size_t symtab_slots;
+  const unsigned char *constant_pool;
+  const unsigned char *end;
+};
+
+/* Decode the .gdb_index header.  Returns 1 if DBG has no (usable)
+   index, -1 if it is corrupt.  */
+static int
+read_header (Dwarf *dbg, struct gdb_index *index)
+{
+  Elf_Data *data = dbg->sectiondata[IDX_gdb_index];
+  if (data == NULL)
+    return 1;
+
+  const unsigned char *buf = data->d_buf;
+  if (data->d_size < 6 * 4)
+    goto invalid;
+
+  /* Versions before 4 had known bugs, versions 4 till 8 only differ in
+     the name hash and in which symbols are included.  */
+  index->version = read_le32 (buf);
+  if (index->version < 4 || index->version > 8)
+    return 1;
+
+  uint32_t cu_off = read_le32 (buf + 4);
+  uint32_t tu_off = read_le32 (buf + 8);
+  uint32_t addr_off = read_le32 (buf + 12);
+  uint32_t sym_off = read_le32 (buf + 16);
+  uint32_t const_off = read_le32 (buf + 20);
+  if (cu_off < 6 * 4 || cu_off > tu_off || tu_off > addr_off
+      || addr_off > sym_off || sym_off > const_off
+      || const_off > data->d_size)
+    goto invalid;
+
+  index->cu_list = buf + cu_off;
+  index->cu_count = (tu_off - cu_off) / 16;
+  index->addr_list = buf + addr_off;
+  index->addr_count = (sym_off - addr_off) / 20;
+  index->symtab = buf + sym_off;
+  index->symtab_slots = (const_off - sym_off) / 8;
+  index->constant_pool = buf + const_off;
+  index->end = buf + data->d_size;
+
+  /* The symbol table is a hash table with a power of two size.  */
+  if ((index->symtab_slots & (index->symtab_slots - 1)) != 0)
+    goto invalid;
+
+  return 0;
+
+ invalid:
+  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+  return -1;
+}
+
+/* Return the DIE offset of CU number CU_NDX, or -1 on error.  */
+static Dwarf_Off
+cu_die_offset (Dwarf *dbg, const struct gdb_index *index, uint32_t cu_ndx)
+{
+  if (cu_ndx >= index->cu_count)
+    {
+      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+      return (Dwarf_Off) -1;
+    }
+
+  Dwarf_Off off = read_le64 (index->cu_list + (size_t) cu_ndx * 16);
+  struct Dwarf_CU *cu = __libdw_findcu (dbg, off, false);
+  if (cu == NULL)
+    return (Dwarf_Off) -1;
+  return __libdw_first_die_off_from_cu (cu);
+}
+
+static int
+compare_aranges (const void *a, const void *b)
+{
+  const Dwarf_Arange *a1 = a, *a2 = b;
+  if (a1->addr != a2->addr)
+    return a1->addr < a2->addr ? -1 : 1;
+  return 0;
+}
+
+int
+internal_function
+__libdw_gdb_index_aranges (Dwarf *dbg, Dwarf_Aranges **aranges,
+			   size_t *naranges)
+{
+  struct gdb_index index;
+  if (read_header (dbg, &index) != 0 || index.addr_count == 0)
+    return -1;
+
+  Dwarf_Off *cu_offs = malloc (index.cu_count * sizeof cu_offs[0]);
+  if (unlikely (cu_offs == NULL && index.cu_count != 0))
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return -1;
+    }
+  for (size_t i = 0; i < index.cu_count; ++i)
+    cu_offs[i] = (Dwarf_Off) -1;
+
+  /* Check all entries and count the ranges first, memory from the
+     Dwarf pool cannot be given back when we fail.  */
+  size_t n = 0;
+  for (size_t i = 0; i < index.addr_count; ++i)
+    {
+      const unsigned char *readp = index.addr_list + i * 20;
+      Dwarf_Addr low = read_le64 (readp);
+      Dwarf_Addr high = read_le64 (readp + 8);
+      uint32_t cu_ndx = read_le32 (readp + 16);
+
+      /* The high address is one past the end of the range.  */
+      if (high <= low)
+	continue;
+
+      if (cu_ndx >= index.cu_count)
+	{
+	  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+	  goto fail;
+	}
+      if (cu_offs[cu_ndx] == (Dwarf_Off) -1)
+	{
+	  cu_offs[cu_ndx] = cu_die_offset (dbg, &index, cu_ndx);
+	  if (cu_offs[cu_ndx] == (Dwarf_Off) -1)
+	    goto fail;
+	}
+      ++n;
+    }
+
+  if (n == 0)
+    goto fail;
+
+  Dwarf_Aranges *buf = libdw_alloc (dbg, Dwarf_Aranges,
+				    sizeof (Dwarf_Aranges)
+				    + n * sizeof (Dwarf_Arange), 1);
+  n = 0;
+  bool sorted = true;
+  for (size_t i = 0; i < index.addr_count; ++i)
+    {
+      const unsigned char *readp = index.addr_list + i * 20;
+      Dwarf_Addr low = read_le64 (readp);
+      Dwarf_Addr high = read_le64 (readp + 8);
+      uint32_t cu_ndx = read_le32 (readp + 16);
+      if (high <= low)
+	continue;
+
+      buf->info[n].addr = low;
+      buf->info[n].length = high - low;
+      buf->info[n].offset = cu_offs[cu_ndx];
+      if (n > 0 && buf->info[n - 1].addr > low)
+	sorted = false;
+      ++n;
+    }
+  free (cu_offs);
+
+  /* GDB writes the table sorted, but it isn't a requirement.  */
+  if (! sorted)
+    qsort (buf->info, n, sizeof buf->info[0], compare_aranges);
+
+  buf->dbg = dbg;
+  buf->naranges = n;
+  dbg->aranges = buf;
+  *aranges = buf;
+  if (naranges != NULL)
+    *naranges = n;
+  return 0;
+
+ fail:
+  free (cu_offs);
+  return -1;
+}
+
+/* The hash function used for the symbol table, see
+   mapped_index_string_hash in GDB.  Version 4 didn't fold case.  */
+static uint32_t
+symbol_hash (uint32_t version, const char *name)
+{
+  uint32_t r = 0;
+  for (const unsigned char *p = (const unsigned char *) name; *p != '\0'; ++p)
+    {
+      unsigned char c = *p;
+      if (version >= 5 && c >= 'A' && c <= 'Z')
+	c += 'a' - 'A';
+      r = r * 67 + c - 113;
+    }
+  return r;
+}
+
+struct visit_arg
+{
+  const char *name;
+  Dwarf_Off cu_offset;
+  int (*callback) (Dwarf *, Dwarf_Global *, unsigned int, void *);
+  void *arg;
+};
+
+/* Pass all definitions called NAME in SCOPE to the callback.  Qualified
+   C++ names like ns::foo are looked up by descending into the matching
+   namespaces and types.  Enumerators live in the scope enclosing their
+   enumeration type.  */
+static int
+visit_scope (Dwarf_Die *scope, const char *name, struct visit_arg *va)
+{
+  Dwarf_Die child;
+  int res = INTUSE(dwarf_child) (scope, &child);
+  while (res == 0)
+    {
+      int tag = INTUSE(dwarf_tag) (&child);
+      const char *diename = INTUSE(dwarf_diename) (&child);
+      if (diename != NULL && strcmp (diename, name) == 0)
+	{
+	  if (! INTUSE(dwarf_hasattr) (&child, DW_AT_declaration))
+	    {
+	      Dwarf_Global gl;
+	      gl.cu_offset = va->cu_offset;
+	      gl.die_offset = INTUSE(dwarf_dieoffset) (&child);
+	      gl.name = va->name;
+	      if (va->callback (child.cu->dbg, &gl, tag, va->arg)
+		  != DWARF_CB_OK)
+		return 1;
+	    }
+	}
+      else if (diename != NULL
+	       && (tag == DW_TAG_namespace || tag == DW_TAG_class_type
+		   || tag == DW_TAG_structure_type
+		   || tag == DW_TAG_union_type))
+	{
+	  size_t len = strlen (diename);
+	  if (strncmp (name, diename, len) == 0
+	      && name[len] == ':' && name[len + 1] == ':')
+	    {
+	      int r = visit_scope (&child, name + len + 2, va);
+	      if (r != 0)
+		return r;
+	    }
+	}
+      else if (tag == DW_TAG_enumeration_type)
+	{
+	  int r = visit_scope (&child, name, va);
+	  if (r != 0)
+	    return r;
+	}
+
+      res = INTUSE(dwarf_siblingof) (&child, &child);
+    }
+
+  return res < 0 ? -1 : 0;
+}
+
+/* Visit the CUs of the symbol in SLOT of the symbol table.  */
+static int
+visit_symbol (Dwarf *dbg, const struct gdb_index *index, size_t slot,
+	      struct visit_arg *va)
+{
+  const unsigned char *readp = index->symtab + slot * 8;
+  uint32_t vec_off = read_le32 (readp + 4);
+  size_t pool_size = index->end - index->constant_pool;
+  if (vec_off > pool_size || pool_size - vec_off < 4)
+    goto invalid;
+
+  const unsigned char *vec = index->constant_pool + vec_off;
+  uint32_t count = read_le32 (vec);
+  if ((pool_size - vec_off - 4) / 4 < count)
+    goto invalid;
+
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      /* The low 24 bits are the CU index, the rest are symbol kind
+	 attributes we don't need.  CU indexes past the CU list are
+	 type units, we only look in the real CUs.  */
+      uint32_t cu_ndx = read_le32 (vec + 4 + 4 * i) & 0xffffff;
+      if (cu_ndx >= index->cu_count)
+	continue;
+
+      /* The same CU is listed once for each kind of symbol.  */
+      uint32_t j;
+      for (j = 0; j < i; ++j)
+	if ((read_le32 (vec + 4 + 4 * j) & 0xffffff) == cu_ndx)
+	  break;
+      if (j < i)
+	continue;
+
+      va->cu_offset = cu_die_offset (dbg, index, cu_ndx);
+      if (va->cu_offset == (Dwarf_Off) -1)
+	return -1;
+
+      Dwarf_Die cudie;
+      if (INTUSE(dwarf_offdie) (dbg, va->cu_offset, &cudie) == NULL)
+	return -1;
+      int res = visit_scope (&cudie, va->name, va);
+      if (res != 0)
+	return res;
+    }
+
+  return 0;
+
+ invalid:
+  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+  return -1;
+}
+
+/* Return the name of the symbol in SLOT, or NULL if the slot is empty
+   or invalid.  */
+static const char *
+symbol_name (const struct gdb_index *index, size_t slot, bool *invalid)
+{
+  const unsigned char *readp = index->symtab + slot * 8;
+  uint32_t name_off = read_le32 (readp);
+  uint32_t vec_off = read_le32 (readp + 4);
+  *invalid = false;
+  if (name_off == 0 && vec_off == 0)
+    return NULL;
+
+  const char *name = (const char *) index->constant_pool + name_off;
+  size_t pool_size = index->end - index->constant_pool;
+  if (name_off >= pool_size
+      || memchr (name, '\0', pool_size - name_off) == NULL)
+    {
+      *invalid = true;
+      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+      return NULL;
+    }
+  return name;
+}
+
+int
+internal_function
+__libdw_gdb_index_getnames (Dwarf *dbg, const char *name,
+			    int (*callback) (Dwarf *, Dwarf_Global *,
+					     unsigned int, void *),
+			    void *arg)
+{
+  struct gdb_index index;
+  int res = read_header (dbg, &index);
+  if (res != 0)
+    {
+      if (res > 0)
+	__libdw_seterrno (DWARF_E_NO_DEBUG_NAMES);
+      return -1;
+    }
+  if (index.symtab_slots == 0)
+    return 0;
+
+  struct visit_arg va = { .callback = callback, .arg = arg };
+  bool invalid;
+
+  if (name == NULL)
+    {
+      for (size_t slot = 0; slot < index.symtab_slots; ++slot)
+	{
+	  va.name = symbol_name (&index, slot, &invalid);
+	  if (va.name == NULL)
+	    {
+	      if (invalid)
+		return -1;
+	      continue;
+	    }
+	  res = visit_symbol (dbg, &index, slot, &va);
+	  if (res != 0)
+	    return res;
+	}
+      return 0;
+    }
+
+  /* Open addressing with a hash dependent step.  An empty slot ends
+     the search.  */
+  uint32_t hash = symbol_hash (index.version, name);
+  size_t mask = index.symtab_slots - 1;
+  size_t slot = hash & mask;
+  size_t step = ((hash * 17) & mask) | 1;
+  for (size_t n = 0; n < index.symtab_slots; ++n)
+    {
+      va.name = symbol_name (&index, slot, &invalid);
+      if (va.name == NULL)
+	return invalid ? -1 : 0;
+      if (strcmp (va.name, name) == 0)
+	return visit_symbol (dbg, &index, slot, &va);
+      slot = (slot + step) & mask;
+    }
+
+  return 0;
+}
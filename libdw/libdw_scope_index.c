@@ -0,0 +1,413 @@
+/* Index of the address ranges of the scopes of a CU.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <dwarf.h>
+#include "libdwP.h"
+
+#define NO_NODE ((size_t) -1)
+
+/* A DIE on the path __libdw_visit_scopes is at, and its node once it
+   needs one.  */
+struct path_die
+{
+  Dwarf_Die die;
+  size_t node;
+  bool inlined;
+};
+
+struct build_state
+{
+  struct libdw_scope_index *index;
+  size_t nodes_size;
+  size_t ranges_size;
+  size_t origins_size;
+
+  struct path_die *path;
+  size_t path_size;
+};
+
+
+/* Grow the array at *ARRAYP of *SIZEP elements of SIZE bytes, so it
+   has room for one more after N.  */
+static bool
+make_room (void *arrayp, size_t *sizep, size_t n, size_t size)
+{
+  if (n < *sizep)
+    return true;
+
+  size_t new_size = *sizep == 0 ? 64 : 2 * *sizep;
+  void *array = realloc (*(void **) arrayp, new_size * size);
+  if (array == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return false;
+    }
+  *(void **) arrayp = array;
+  *sizep = new_size;
+  return true;
+}
+
+/* Return the node of the DIE at DEPTH on the path, adding it and its
+   parents to the nodes if they weren't yet.  */
+static size_t
+path_node (struct build_state *state, unsigned int depth)
+{
+  struct path_die *p = &state->path[depth];
+  if (p->node != NO_NODE)
+    return p->node;
+
+  /* The CU DIE at depth zero is always node zero.  */
+  size_t parent = path_node (state, depth - 1);
+  if (parent == NO_NODE)
+    return NO_NODE;
+
+  struct libdw_scope_index *index = state->index;
+  if (! make_room (&index->nodes, &state->nodes_size, index->nnodes,
+		   sizeof index->nodes[0]))
+    return NO_NODE;
+
+  index->nodes[index->nnodes] = (struct libdw_scope_node)
+    {
+      .die = p->die,
+      .parent = parent,
+      .depth = depth,
+      .inlined = p->inlined
+    };
+  p->node = index->nnodes++;
+  return p->node;
+}
+
+/* Previsit callback for __libdw_visit_scopes, which records the
+   ranges of every DIE like dwarf_getscopes checks them with
+   dwarf_haspc.  Nothing is pruned, so all DIEs the abstract origin of
+   an inlined instance can be found at are seen as well.  */
+static int
+record_die (unsigned int depth, struct Dwarf_Die_Chain *chain, void *arg)
+{
+  struct build_state *state = arg;
+  struct libdw_scope_index *index = state->index;
+
+  if (! make_room (&state->path, &state->path_size, depth,
+		   sizeof state->path[0]))
+    return -1;
+
+  int tag = INTUSE(dwarf_tag) (&chain->die);
+  state->path[depth] = (struct path_die)
+    {
+      .die = chain->die,
+      .node = NO_NODE,
+      .inlined = tag == DW_TAG_inlined_subroutine
+    };
+
+  if (tag == DW_TAG_subprogram)
+    {
+      size_t parent = path_node (state, depth - 1);
+      if (parent == NO_NODE
+	  || ! make_room (&index->origins, &state->origins_size,
+			  index->norigins, sizeof index->origins[0]))
+	return -1;
+      index->origins[index->norigins++] = (struct libdw_scope_origin)
+	{
+	  .addr = chain->die.addr,
+	  .parent = parent
+	};
+    }
+
+  Dwarf_Addr base, start, end;
+  ptrdiff_t offset = 0;
+  while ((offset = INTUSE(dwarf_ranges) (&chain->die, offset, &base,
+					 &start, &end)) > 0)
+    {
+      if (start >= end)
+	continue;
+
+      size_t node = path_node (state, depth);
+      if (node == NO_NODE
+	  || ! make_room (&index->ranges, &state->ranges_size,
+			  index->nranges, sizeof index->ranges[0]))
+	return -1;
+      index->ranges[index->nranges++] = (struct libdw_scope_range)
+	{
+	  .start = start,
+	  .end = end,
+	  .node = node
+	};
+    }
+
+  /* dwarf_getscopes treats DIEs that don't have the attributes for
+     ranges as not containing any address, but fails on other errors
+     when it looks at the DIE.  Don't index the CU then, so it still
+     does exactly that.  */
+  if (offset < 0)
+    {
+      int error = INTUSE(dwarf_errno) ();
+      if (error != DWARF_E_NOERROR
+	  && error != DWARF_E_NO_DEBUG_RANGES
+	  && error != DWARF_E_NO_DEBUG_RNGLISTS)
+	{
+	  __libdw_seterrno (error);
+	  return -1;
+	}
+    }
+
+  return 0;
+}
+
+static int
+compare_ranges (const void *a, const void *b)
+{
+  const struct libdw_scope_range *r1 = a;
+  const struct libdw_scope_range *r2 = b;
+
+  if (r1->start != r2->start)
+    return r1->start < r2->start ? -1 : 1;
+  /* Keep the order of the nodes, for a stable result.  */
+  if (r1->node != r2->node)
+    return r1->node < r2->node ? -1 : 1;
+  return 0;
+}
+
+static int
+compare_origins (const void *a, const void *b)
+{
+  const struct libdw_scope_origin *o1 = a;
+  const struct libdw_scope_origin *o2 = b;
+
+  if (o1->addr != o2->addr)
+    return (uintptr_t) o1->addr < (uintptr_t) o2->addr ? -1 : 1;
+  return 0;
+}
+
+/* A node of the interval tree at index X and level K, and whether its
+   left subtree was already looked at.  */
+struct tree_pos
+{
+  size_t x;
+  int k;
+  bool left_done;
+};
+
+/* Turn the sorted ranges into an implicit interval tree.  Leaves are
+   the even indexes, the nodes of level K are at the indexes with the
+   K lowest bits set, the root is at index 2^MAX_LEVEL - 1, which
+   might be past the end.  Returns the MAX_LEVEL.  */
+static int
+index_ranges (struct libdw_scope_range *ranges, size_t n)
+{
+  size_t last_i = 0;
+  Dwarf_Addr last = 0;
+  for (size_t i = 0; i < n; i += 2)
+    {
+      last_i = i;
+      last = ranges[i].max_end = ranges[i].end;
+    }
+
+  int k;
+  for (k = 1; ((size_t) 1 << k) <= n; ++k)
+    {
+      size_t x = (size_t) 1 << (k - 1);
+      for (size_t i = (x << 1) - 1; i < n; i += x << 2)
+	{
+	  Dwarf_Addr max_end = ranges[i].end;
+	  Dwarf_Addr left = ranges[i - x].max_end;
+	  Dwarf_Addr right = i + x < n ? ranges[i + x].max_end : last;
+	  if (left > max_end)
+	    max_end = left;
+	  if (right > max_end)
+	    max_end = right;
+	  ranges[i].max_end = max_end;
+	}
+
+      /* The parent of the last node at the level, which might be
+	 past the end and then gets the largest end of its subtree
+	 through LAST.  */
+      last_i = (last_i >> k & 1) ? last_i - x : last_i + x;
+      if (last_i < n && ranges[last_i].max_end > last)
+	last = ranges[last_i].max_end;
+    }
+
+  return k - 1;
+}
+
+
+void
+internal_function
+__libdw_scope_index_free (struct libdw_scope_index *index)
+{
+  free (index->nodes);
+  free (index->ranges);
+  free (index->origins);
+  free (index);
+}
+
+
+static struct libdw_scope_index *
+build_index (Dwarf_CU *cu)
+{
+  struct libdw_scope_index *index = calloc (1, sizeof *index);
+  if (index == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return NULL;
+    }
+
+  struct build_state state =
+    {
+      .index = index,
+      .nodes_size = 1,
+      .path_size = 1
+    };
+  index->nodes = malloc (sizeof index->nodes[0]);
+  state.path = malloc (sizeof state.path[0]);
+  if (index->nodes == NULL || state.path == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      goto fail;
+    }
+
+  struct Dwarf_Die_Chain root = { .parent = NULL, .die = CUDIE (cu) };
+  index->nodes[0] = (struct libdw_scope_node) { .die = root.die,
+						.parent = NO_NODE };
+  index->nnodes = 1;
+  state.path[0] = (struct path_die) { .die = root.die, .node = 0 };
+
+  if (__libdw_visit_scopes (0, &root, NULL, &record_die, NULL, &state) != 0)
+    goto fail;
+
+  qsort (index->ranges, index->nranges, sizeof index->ranges[0],
+	 compare_ranges);
+  index->max_level = index_ranges (index->ranges, index->nranges);
+
+  /* A subprogram that is visited more than once, through imported
+     units, has more than one chain of parents.  */
+  qsort (index->origins, index->norigins, sizeof index->origins[0],
+	 compare_origins);
+  for (size_t i = 1; i < index->norigins; i++)
+    if (index->origins[i].addr == index->origins[i - 1].addr)
+      index->origins[i].parent = index->origins[i - 1].parent = NO_NODE;
+
+  free (state.path);
+  return index;
+
+ fail:
+  free (state.path);
+  __libdw_scope_index_free (index);
+  return NULL;
+}
+
+
+struct libdw_scope_index *
+internal_function
+__libdw_scope_index (Dwarf_CU *cu)
+{
+  struct libdw_scope_index *index
+    = atomic_load_explicit (&cu->scope_index, memory_order_acquire);
+  if (index == NULL)
+    {
+      struct libdw_scope_index *newp = build_index (cu);
+      if (newp == NULL)
+	newp = (void *) -1;
+
+      /* Another thread might have been quicker.  */
+      if (atomic_compare_exchange_strong_explicit (&cu->scope_index,
+						   &index, newp,
+						   memory_order_acq_rel,
+						   memory_order_acquire))
+	index = newp;
+      else if (newp != (void *) -1)
+	__libdw_scope_index_free (newp);
+    }
+
+  return index == (void *) -1 ? NULL : index;
+}
+
+
+size_t
+internal_function
+__libdw_scope_index_find (const struct libdw_scope_index *index,
+			  Dwarf_Addr pc, size_t *nodes, size_t nnodes)
+{
+  const struct libdw_scope_range *ranges = index->ranges;
+  const size_t n = index->nranges;
+  if (n == 0)
+    return 0;
+
+  /* Walk the interval tree, only going left when the subtree there
+     has a range that ends after PC, and only going right when the
+     node itself starts at or before PC.  Small subtrees are just
+     scanned.  */
+  struct tree_pos stack[2 * (8 * sizeof (size_t) + 1)];
+  int t = 0;
+  stack[t++] = (struct tree_pos) { ((size_t) 1 << index->max_level) - 1,
+				   index->max_level, false };
+
+  size_t found = 0;
+  while (t > 0)
+    {
+      struct tree_pos z = stack[--t];
+      if (z.k <= 3)
+	{
+	  size_t i0 = z.x >> z.k << z.k;
+	  size_t i1 = i0 + ((size_t) 1 << (z.k + 1)) - 1;
+	  if (i1 > n)
+	    i1 = n;
+	  for (size_t i = i0; i < i1 && ranges[i].start <= pc; ++i)
+	    if (pc < ranges[i].end)
+	      {
+		if (found < nnodes)
+		  nodes[found] = ranges[i].node;
+		found++;
+	      }
+	}
+      else if (! z.left_done)
+	{
+	  size_t y = z.x - ((size_t) 1 << (z.k - 1));
+	  stack[t++] = (struct tree_pos) { z.x, z.k, true };
+	  if (y >= n || ranges[y].max_end > pc)
+	    stack[t++] = (struct tree_pos) { y, z.k - 1, false };
+	}
+      else if (z.x < n && ranges[z.x].start <= pc)
+	{
+	  if (pc < ranges[z.x].end)
+	    {
+	      if (found < nnodes)
+		nodes[found] = ranges[z.x].node;
+	      found++;
+	    }
+	  stack[t++] = (struct tree_pos) { z.x + ((size_t) 1 << (z.k - 1)),
+					   z.k - 1, false };
+	}
+    }
+
+  return found;
+}
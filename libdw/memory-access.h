@@ -33,6 +33,7 @@
 #include <endian.h>
 #include <limits.h>
 #include <stdint.h>
+#include <string.h>
 
 
 /* Number decoding macros.  See 7.6 Variable Length Data.  */
@@ -108,6 +109,39 @@ __libdw_get_uleb128_unchecked (const unsigned char **addrp)
 #define get_uleb128(var, addr, end) ((var) = __libdw_get_uleb128 (&(addr), end))
 #define get_uleb128_unchecked(var, addr) ((var) = __libdw_get_uleb128_unchecked (&(addr)))
 
+/* Return the number of bytes __libdw_get_uleb128 would read at ADDR,
+   without decoding the number.  When there are enough bytes, eight of
+   them are checked for the end of the number at once.  Doesn't read
+   anything when ADDR isn't smaller than END, but still returns 1.  */
+static inline size_t
+__libdw_skip_uleb128 (const unsigned char *addr, const unsigned char *end)
+{
+  if (unlikely (addr >= end))
+    return 1;
+  if (likely ((*addr & 0x80) == 0))
+    return 1;
+
+  const size_t max = __libdw_max_len_uleb128 (addr, end);
+  if (max >= sizeof (uint64_t))
+    {
+      uint64_t word;
+      memcpy (&word, addr, sizeof word);
+      /* The high bit is clear in the last byte of the number.  */
+      uint64_t last = ~word & 0x8080808080808080ULL;
+      if (last != 0)
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+	return __builtin_ctzll (last) / 8 + 1;
+#else
+	return __builtin_clzll (last) / 8 + 1;
+#endif
+    }
+
+  size_t len = 1;
+  while (len < max && (addr[len - 1] & 0x80) != 0)
+    ++len;
+  return len;
+}
+
 /* The signed case is similar, but we sign-extend the result.  */
 
 #define get_sleb128_step(var, addr, nth)				      \
@@ -315,3 +315,28 @@ __libdwfl_addrcu (Dwfl_Module *mod, Dwarf_Addr addr, struct dwfl_cu **cu)
   struct dwfl_arange *arange;
   return addrarange (mod, addr, &arange) ?: arangecu (mod, arange, cu);
 }
+
+Dwfl_Error
+internal_function
+__libdwfl_addrcu_end (Dwfl_Module *mod, Dwarf_Addr addr, struct dwfl_cu **cu,
+		      Dwarf_Addr *end)
+{
+  struct dwfl_arange *arange;
+  Dwfl_Error error = addrarange (mod, addr, &arange);
+  if (error == DWFL_E_NOERROR)
+    error = arangecu (mod, arange, cu);
+  if (error != DWFL_E_NOERROR)
+    return error;
+
+  /* The run of ranges for this CU lasts until the next one starts.  */
+  size_t idx = arange - mod->aranges;
+  if (idx + 1 < mod->naranges)
+    *end = dwfl_adjusted_dwarf_addr (mod, dwar (mod, idx + 1)->addr);
+  else
+    {
+      const Dwarf_Arange *last
+	= &mod->dw->aranges->info[mod->dw->aranges->naranges - 1];
+      *end = dwfl_adjusted_dwarf_addr (mod, last->addr + last->length + 1);
+    }
+  return DWFL_E_NOERROR;
+}
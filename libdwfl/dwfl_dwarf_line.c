@@ -40,7 +40,7 @@ dwfl_dwarf_line (Dwfl_Line *line, Dwarf_Addr *bias)
     return NULL;
 
   struct dwfl_cu *cu = dwfl_linecu (line);
-  const Dwarf_Line *info = &cu->die.cu->lines->info[line->idx];
+  const Dwarf_Line *info = &__libdw_cu_lines (cu->die.cu)->info[line->idx];
 
   *bias = dwfl_adjusted_dwarf_addr (cu->mod, 0);
   return (Dwarf_Line *) info;
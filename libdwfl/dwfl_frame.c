@@ -68,38 +68,58 @@ state_fetch_pc (Dwfl_Frame *state)
   abort ();
 }
 
-/* Do not call it on your own, to be used by thread_* functions only.  */
+Dwfl_Frame *
+internal_function
+__libdwfl_frame_alloc (Dwfl_Thread *thread)
+{
+  Dwfl_Process *process = thread->process;
+  Dwfl_Frame *state = process->free_frames;
+  if (state != NULL)
+    process->free_frames = state->unwound;
+  else
+    {
+      size_t nregs = ebl_frame_nregs (process->ebl);
+      assert (nregs > 0);
+      assert (nregs < sizeof (((Dwfl_Frame *) NULL)->regs_set) * 8);
+      state = malloc (sizeof (*state) + sizeof (*state->regs) * nregs);
+      if (state == NULL)
+	return NULL;
+    }
+  state->thread = thread;
+  state->unwound = NULL;
+  state->signal_frame = false;
+  state->initial_frame = false;
+  state->ebl_unwound = false;
+  state->pc_state = DWFL_FRAME_STATE_ERROR;
+  memset (state->regs_set, 0, sizeof (state->regs_set));
+  return state;
+}
 
-static void
-free_states (Dwfl_Frame *state)
+void
+internal_function
+__libdwfl_frame_free (Dwfl_Frame *state)
 {
   while (state)
     {
+      Dwfl_Process *process = state->thread->process;
       Dwfl_Frame *next = state->unwound;
-      free(state);
+      state->unwound = process->free_frames;
+      process->free_frames = state;
       state = next;
     }
 }
 
+/* Do not call it on your own, to be used by thread_* functions only.  */
+
 static Dwfl_Frame *
 state_alloc (Dwfl_Thread *thread)
 {
   assert (thread->unwound == NULL);
-  Ebl *ebl = thread->process->ebl;
-  size_t nregs = ebl_frame_nregs (ebl);
-  if (nregs == 0)
-    return NULL;
-  assert (nregs < sizeof (((Dwfl_Frame *) NULL)->regs_set) * 8);
-  Dwfl_Frame *state = malloc (sizeof (*state) + sizeof (*state->regs) * nregs);
+  Dwfl_Frame *state = __libdwfl_frame_alloc (thread);
   if (state == NULL)
     return NULL;
-  state->thread = thread;
-  state->signal_frame = false;
   state->initial_frame = true;
-  state->pc_state = DWFL_FRAME_STATE_ERROR;
-  memset (state->regs_set, 0, sizeof (state->regs_set));
   thread->unwound = state;
-  state->unwound = NULL;
   return state;
 }
 
@@ -114,6 +134,12 @@ __libdwfl_process_free (Dwfl_Process *process)
   dwfl->process = NULL;
   if (process->ebl_close)
     ebl_closebackend (process->ebl);
+  while (process->free_frames != NULL)
+    {
+      Dwfl_Frame *next = process->free_frames->unwound;
+      free (process->free_frames);
+      process->free_frames = next;
+    }
   free (process);
   dwfl->attacherr = DWFL_E_NOERROR;
 }
@@ -204,10 +230,42 @@ dwfl_attach_state (Dwfl *dwfl, Elf *elf, pid_t pid,
   process->pid = pid;
   process->callbacks = thread_callbacks;
   process->callbacks_arg = arg;
+  process->memory_read_range = NULL;
+  process->frame_pointer_unwind = false;
+  process->free_frames = NULL;
   return true;
 }
 INTDEF(dwfl_attach_state)
 
+bool
+dwfl_set_memory_read_range (Dwfl *dwfl,
+			    bool (*memory_read_range) (Dwfl *dwfl,
+						       Dwarf_Addr addr,
+						       void *buf, size_t size,
+						       void *dwfl_arg))
+{
+  if (dwfl->process == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_NO_ATTACH_STATE);
+      return false;
+    }
+  dwfl->process->memory_read_range = memory_read_range;
+  return true;
+}
+INTDEF(dwfl_set_memory_read_range)
+
+bool
+dwfl_set_frame_pointer_unwind (Dwfl *dwfl, bool enable)
+{
+  if (dwfl->process == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_NO_ATTACH_STATE);
+      return false;
+    }
+  dwfl->process->frame_pointer_unwind = enable;
+  return true;
+}
+
 pid_t
 dwfl_pid (Dwfl *dwfl)
 {
@@ -406,10 +464,12 @@ dwfl_thread_getframes (Dwfl_Thread *thread,
       return -1;
     }
   Dwfl_Process *process = thread->process;
+  /* Memory might have changed since the last time.  */
+  thread->mem_len = 0;
   if (! process->callbacks->set_initial_registers (thread,
 						   thread->callbacks_arg))
     {
-      free_states (thread->unwound);
+      __libdwfl_frame_free (thread->unwound);
       thread->unwound = NULL;
       return -1;
     }
@@ -419,7 +479,7 @@ dwfl_thread_getframes (Dwfl_Thread *thread,
     {
       if (process->callbacks->thread_detach)
 	process->callbacks->thread_detach (thread, thread->callbacks_arg);
-      free_states (state);
+      __libdwfl_frame_free (state);
       return -1;
     }
   do
@@ -429,13 +489,14 @@ dwfl_thread_getframes (Dwfl_Thread *thread,
 	{
 	  if (process->callbacks->thread_detach)
 	    process->callbacks->thread_detach (thread, thread->callbacks_arg);
-	  free_states (state);
+	  __libdwfl_frame_free (state);
 	  return err;
 	}
       __libdwfl_frame_unwind (state);
       Dwfl_Frame *next = state->unwound;
-      /* The old frame is no longer needed.  */
-      free (state);
+      /* The old frame is no longer needed, the next one can reuse it.  */
+      state->unwound = NULL;
+      __libdwfl_frame_free (state);
       state = next;
     }
   while (state && state->pc_state == DWFL_FRAME_STATE_PC_SET);
@@ -445,12 +506,12 @@ dwfl_thread_getframes (Dwfl_Thread *thread,
     process->callbacks->thread_detach (thread, thread->callbacks_arg);
   if (state == NULL || state->pc_state == DWFL_FRAME_STATE_ERROR)
     {
-      free_states (state);
+      __libdwfl_frame_free (state);
       __libdwfl_seterrno (err);
       return -1;
     }
   assert (state->pc_state == DWFL_FRAME_STATE_PC_UNDEFINED);
-  free_states (state);
+  __libdwfl_frame_free (state);
   return 0;
 }
 INTDEF(dwfl_thread_getframes)
@@ -47,6 +47,6 @@ dwfl_getsrclines (Dwarf_Die *cudie, size_t *nlines)
 	}
     }
 
-  *nlines = cu->die.cu->lines->nlines;
+  *nlines = __libdw_cu_lines (cu->die.cu)->nlines;
   return 0;
 }
@@ -68,6 +68,9 @@ __libdwfl_module_free (Dwfl_Module *mod)
   if (mod->aranges != NULL)
     free (mod->aranges);
 
+  if (mod->line_index != (void *) -1l)
+    free (mod->line_index);
+
   if (mod->cu != NULL)
     {
       for (size_t i = 0; i < mod->ncu; ++i)
@@ -119,6 +122,9 @@ __libdwfl_module_free (Dwfl_Module *mod)
   if (mod->reloc_info != NULL)
     free (mod->reloc_info);
 
+  free (mod->addrsym_index[0]);
+  free (mod->addrsym_index[1]);
+
   free (mod->name);
   free (mod->elfdir);
   free (mod);
@@ -0,0 +1,150 @@
+/* Find symbols and source lines for many addresses in a module.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+#include "../libdw/libdwP.h"
+
+struct batch_addr
+{
+  GElf_Addr addr;
+  size_t idx;
+};
+
+static int
+compare_batch_addr (const void *a, const void *b)
+{
+  const struct batch_addr *p1 = a;
+  const struct batch_addr *p2 = b;
+
+  if (p1->addr != p2->addr)
+    return p1->addr < p2->addr ? -1 : 1;
+  return p1->idx < p2->idx ? -1 : p1->idx > p2->idx;
+}
+
+/* Like dwfl_module_getsrc, but reuse the CU found for the previous
+   (lower) address in *CUP as long as ADDR is below *CU_END.  */
+static Dwfl_Line *
+batch_getsrc (Dwfl_Module *mod, Dwarf_Addr bias, Dwarf_Addr addr,
+	      struct dwfl_cu **cup, Dwarf_Addr *cu_end)
+{
+  if (*cup == NULL || addr >= *cu_end)
+    {
+      if (__libdwfl_addrcu_end (mod, addr, cup, cu_end) != DWFL_E_NOERROR
+	  || __libdwfl_cu_getsrclines (*cup) != DWFL_E_NOERROR)
+	{
+	  *cup = NULL;
+	  return NULL;
+	}
+    }
+
+  struct dwfl_cu *cu = *cup;
+  Dwarf_Lines *lines = __libdw_cu_lines (cu->die.cu);
+  size_t nlines = lines->nlines;
+  if (nlines == 0)
+    return NULL;
+
+  /* This is guaranteed for us by libdw read_srclines.  */
+  assert (lines->info[nlines - 1].end_sequence);
+
+  addr -= bias;
+
+  size_t l = __libdw_lines_upto (lines, addr);
+  if (l > 0 && ! lines->info[l - 1].end_sequence)
+    return &cu->lines->idx[l - 1];
+  return NULL;
+}
+
+ptrdiff_t
+dwfl_module_addrinfo_batch (Dwfl_Module *mod, size_t n,
+			    const GElf_Addr *addrs, const char **names,
+			    GElf_Off *offsets, Dwfl_Line **lines)
+{
+  if (mod == NULL)
+    return -1;
+
+  if (n == 0)
+    return 0;
+
+  /* Walk the addresses in ascending order, so lookups of the same
+     address are done once and CUs are found once per run.  */
+  struct batch_addr *order = malloc (n * sizeof *order);
+  if (unlikely (order == NULL))
+    {
+      __libdwfl_seterrno (DWFL_E_NOMEM);
+      return -1;
+    }
+
+  bool sorted = true;
+  for (size_t i = 0; i < n; ++i)
+    {
+      order[i].addr = addrs[i];
+      order[i].idx = i;
+      if (i > 0 && addrs[i] < addrs[i - 1])
+	sorted = false;
+    }
+  if (! sorted)
+    qsort (order, n, sizeof order[0], compare_batch_addr);
+
+  Dwarf_Addr bias = 0;
+  bool want_lines = (lines != NULL
+		     && INTUSE(dwfl_module_getdwarf) (mod, &bias) != NULL);
+
+  ptrdiff_t found = 0;
+  const char *name = NULL;
+  GElf_Off off = 0;
+  Dwfl_Line *line = NULL;
+  struct dwfl_cu *cu = NULL;
+  Dwarf_Addr cu_end = 0;
+  for (size_t i = 0; i < n; ++i)
+    {
+      GElf_Addr addr = order[i].addr;
+      if (i == 0 || addr != order[i - 1].addr)
+	{
+	  GElf_Sym sym;
+	  name = __libdwfl_addrsym (mod, addr, &off, &sym, NULL, NULL, NULL,
+				    false);
+	  if (want_lines)
+	    line = batch_getsrc (mod, bias, addr, &cu, &cu_end);
+	}
+
+      size_t idx = order[i].idx;
+      names[idx] = name;
+      if (offsets != NULL)
+	offsets[idx] = name != NULL ? off : 0;
+      if (lines != NULL)
+	lines[idx] = line;
+      if (name != NULL)
+	++found;
+    }
+
+  free (order);
+  return found;
+}
@@ -234,13 +234,232 @@ search_table (struct search_state *state, int start, int end)
 	}
 }
 
+/* Sort address index entries by value, keeping symbol table order
+   for equal values.  */
+static int
+compare_addrsym (const void *a, const void *b)
+{
+  const struct dwfl_addrsym *p1 = a;
+  const struct dwfl_addrsym *p2 = b;
+
+  if (p1->value != p2->value)
+    return p1->value < p2->value ? -1 : 1;
+  if (p1->ndx != p2->ndx)
+    return p1->ndx < p2->ndx ? -1 : 1;
+  return (int) p1->adjusted - (int) p2->adjusted;
+}
+
+/* Record every value search_table would try for the symbols START
+   up to END in ENTRIES, sorted by address.  Returns the number of
+   entries filled in.  */
+static size_t
+fill_index (Dwfl_Module *mod, bool adjust_st_value, int start, int end,
+	    struct dwfl_addrsym *entries)
+{
+  size_t n = 0;
+  for (int i = start; i < end; ++i)
+    {
+      GElf_Sym sym;
+      GElf_Addr value;
+      GElf_Word shndx;
+      Elf *elf;
+      bool resolved;
+      const char *name = __libdwfl_getsym (mod, i, &sym, &value,
+					   &shndx, &elf, NULL,
+					   &resolved, adjust_st_value);
+      if (name != NULL && name[0] != '\0'
+	  && sym.st_shndx != SHN_UNDEF
+	  && GELF_ST_TYPE (sym.st_info) != STT_SECTION
+	  && GELF_ST_TYPE (sym.st_info) != STT_FILE
+	  && GELF_ST_TYPE (sym.st_info) != STT_TLS)
+	{
+	  entries[n].value = value;
+	  entries[n].end = value + sym.st_size;
+	  entries[n].ndx = i;
+	  entries[n].adjusted = false;
+	  n++;
+
+	  if (resolved && mod->e_type != ET_REL)
+	    {
+	      GElf_Addr adjusted_st_value;
+	      adjusted_st_value = dwfl_adjusted_st_value (mod, elf,
+							  sym.st_value);
+	      if (value != adjusted_st_value)
+		{
+		  entries[n].value = adjusted_st_value;
+		  entries[n].end = adjusted_st_value + sym.st_size;
+		  entries[n].ndx = i;
+		  entries[n].adjusted = true;
+		  n++;
+		}
+	    }
+	}
+    }
+
+  qsort (entries, n, sizeof entries[0], compare_addrsym);
+
+  GElf_Addr max_end = 0;
+  for (size_t i = 0; i < n; ++i)
+    {
+      if (entries[i].end > max_end)
+	max_end = entries[i].end;
+      entries[i].max_end = max_end;
+    }
+
+  return n;
+}
+
+/* Return the address index for MOD, building it on first use.
+   Returns NULL if there is not enough memory, in which case the
+   caller should fall back to searching the symbol table.  */
+static struct dwfl_addrsym_index *
+get_index (Dwfl_Module *mod, bool adjust_st_value,
+	   int first_global, int syments)
+{
+  struct dwfl_addrsym_index *index = mod->addrsym_index[adjust_st_value];
+  if (index != NULL)
+    return index;
+
+  /* Each symbol can be tried at most twice, see search_table.  */
+  size_t max = 2 * (size_t) syments;
+  index = malloc (sizeof *index + max * sizeof index->entries[0]);
+  if (unlikely (index == NULL))
+    return NULL;
+
+  int globals_start = first_global == 0 ? 1 : first_global;
+  index->nglobals = fill_index (mod, adjust_st_value, globals_start, syments,
+				index->entries);
+  index->nlocals = 0;
+  if (first_global > 1)
+    index->nlocals = fill_index (mod, adjust_st_value, 1, first_global,
+				 &index->entries[index->nglobals]);
+
+  size_t n = index->nglobals + index->nlocals;
+  struct dwfl_addrsym_index *newp
+    = realloc (index, sizeof *index + n * sizeof index->entries[0]);
+  if (newp != NULL)
+    index = newp;
+
+  mod->addrsym_index[adjust_st_value] = index;
+  return index;
+}
+
+/* Sort candidates back into symbol table order.  */
+static int
+compare_candidates (const void *a, const void *b)
+{
+  const struct dwfl_addrsym *p1 = *(const struct dwfl_addrsym **) a;
+  const struct dwfl_addrsym *p2 = *(const struct dwfl_addrsym **) b;
+
+  if (p1->ndx != p2->ndx)
+    return p1->ndx < p2->ndx ? -1 : 1;
+  return (int) p1->adjusted - (int) p2->adjusted;
+}
+
+/* Like search_table, but only try the entries that can influence the
+   result, found by binary search in the N address sorted ENTRIES.
+
+   Every entry at or below ADDR raises min_label to its end, so after
+   the whole table has been tried it is the max_end of the last such
+   entry.  Setting it up front changes nothing for the entries still
+   tried: sized symbols not containing ADDR are never chosen and
+   sizeless symbols below the final min_label never survive the
+   fallback check.  What is left are the sized symbols containing ADDR
+   and the sizeless symbols at or above min_label, which are tried in
+   symbol table order to get the same tie-breaks as search_table.
+
+   Returns false if there is not enough memory, leaving STATE as it
+   was.  */
+static bool
+search_index (struct search_state *state,
+	      const struct dwfl_addrsym *entries, size_t n)
+{
+  /* Find the first entry above ADDR.  */
+  size_t l = 0, u = n;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      if (entries[idx].value <= state->addr)
+	l = idx + 1;
+      else
+	u = idx;
+    }
+  if (l == 0)
+    return true;
+
+  GElf_Addr min_label = state->min_label;
+  if (entries[l - 1].max_end > min_label)
+    min_label = entries[l - 1].max_end;
+
+  const struct dwfl_addrsym *stack_candidates[16];
+  const struct dwfl_addrsym **candidates = stack_candidates;
+  size_t ncandidates = 0;
+  size_t max_candidates = sizeof stack_candidates / sizeof candidates[0];
+  for (size_t i = l; i-- > 0; )
+    {
+      const struct dwfl_addrsym *entry = &entries[i];
+      if (entry->max_end <= state->addr && entry->value < min_label)
+	break;
+
+      if (entry->end == entry->value
+	  ? entry->value >= min_label : entry->end > state->addr)
+	{
+	  if (ncandidates == max_candidates)
+	    {
+	      const struct dwfl_addrsym **newp;
+	      max_candidates *= 2;
+	      newp = malloc (max_candidates * sizeof candidates[0]);
+	      if (unlikely (newp == NULL))
+		{
+		  if (candidates != stack_candidates)
+		    free (candidates);
+		  return false;
+		}
+	      memcpy (newp, candidates, ncandidates * sizeof candidates[0]);
+	      if (candidates != stack_candidates)
+		free (candidates);
+	      candidates = newp;
+	    }
+	  candidates[ncandidates++] = entry;
+	}
+    }
+
+  qsort (candidates, ncandidates, sizeof candidates[0], compare_candidates);
+
+  state->min_label = min_label;
+  for (size_t i = 0; i < ncandidates; ++i)
+    {
+      GElf_Sym sym;
+      GElf_Addr value;
+      GElf_Word shndx;
+      Elf *elf;
+      bool resolved;
+      const char *name = __libdwfl_getsym (state->mod, candidates[i]->ndx,
+					   &sym, &value, &shndx, &elf, NULL,
+					   &resolved, state->adjust_st_value);
+      if (unlikely (name == NULL))
+	continue;
+
+      if (candidates[i]->adjusted)
+	try_sym_value (state, candidates[i]->value, &sym, name, shndx,
+		       elf, false);
+      else
+	try_sym_value (state, value, &sym, name, shndx, elf, resolved);
+    }
+
+  if (candidates != stack_candidates)
+    free (candidates);
+  return true;
+}
+
 /* Returns the name of the symbol "closest" to ADDR.
    Never returns symbols at addresses above ADDR.
 
    Wrapper for old dwfl_module_addrsym and new dwfl_module_addrinfo.
    adjust_st_value set to true returns adjusted SYM st_value, set to false
    it will not adjust SYM at all, but does match against resolved values.   */
-static const char *
+const char *
+internal_function
 __libdwfl_addrsym (Dwfl_Module *_mod, GElf_Addr _addr, GElf_Off *off,
 		   GElf_Sym *_closest_sym, GElf_Word *shndxp,
 		   Elf **elfp, Dwarf_Addr *biasp, bool _adjust_st_value)
@@ -281,13 +500,25 @@ __libdwfl_addrsym (Dwfl_Module *_mod, GElf_Addr _addr, GElf_Off *off,
   int first_global = INTUSE (dwfl_module_getsymtab_first_global) (state.mod);
   if (first_global < 0)
     return NULL;
-  search_table (&state, first_global == 0 ? 1 : first_global, syments);
+
+  /* Use the address index when we can, the results are the same as
+     from searching the symbol tables.  */
+  struct dwfl_addrsym_index *index = get_index (state.mod, _adjust_st_value,
+						first_global, syments);
+  if (index == NULL
+      || ! search_index (&state, index->entries, index->nglobals))
+    search_table (&state, first_global == 0 ? 1 : first_global, syments);
 
   /* If we found nothing searching the global symbols, then try the locals.
      Unless we have a global sizeless symbol that matches exactly.  */
   if (state.closest_name == NULL && first_global > 1
       && (state.sizeless_name == NULL || state.sizeless_value != state.addr))
-    search_table (&state, 1, first_global);
+    {
+      if (index == NULL
+	  || ! search_index (&state, &index->entries[index->nglobals],
+			     index->nlocals))
+	search_table (&state, 1, first_global);
+    }
 
   /* If we found no proper sized symbol to use, fall back to the best
      candidate sizeless symbol we found, if any.  */
@@ -1368,6 +1368,10 @@ load_dw (Dwfl_Module *mod, struct dwfl_file *debugfile)
   if (mod->dw->debugdir == NULL && mod->elfdir != NULL
       && debugfile == &mod->main)
     mod->dw->debugdir = strdup (mod->elfdir);
+  if (mod->dw->elfpath == NULL && mod->elfdir != NULL
+      && mod->main.name != NULL && debugfile == &mod->main)
+    mod->dw->elfpath = __libdw_filepath (mod->elfdir, NULL,
+					 basename (mod->main.name));
 
   /* Until we have iterated through all CU's, we might do lazy lookups.  */
   mod->lazycu = 1;
@@ -40,13 +40,23 @@ dwfl_module_getsrc (Dwfl_Module *mod, Dwarf_Addr addr)
   if (INTUSE(dwfl_module_getdwarf) (mod, &bias) == NULL)
     return NULL;
 
+  /* Once we have seen a few lookups in this module, all its lines get
+     indexed, which saves finding the CU and searching its lines.  */
+  Dwfl_Line *line;
+  if (__libdwfl_line_index_lookup (mod, addr - bias, &line))
+    {
+      if (line == NULL)
+	__libdwfl_seterrno (DWFL_E_ADDR_OUTOFRANGE);
+      return line;
+    }
+
   struct dwfl_cu *cu;
   Dwfl_Error error = __libdwfl_addrcu (mod, addr, &cu);
   if (likely (error == DWFL_E_NOERROR))
     error = __libdwfl_cu_getsrclines (cu);
   if (likely (error == DWFL_E_NOERROR))
     {
-      Dwarf_Lines *lines = cu->die.cu->lines;
+      Dwarf_Lines *lines = __libdw_cu_lines (cu->die.cu);
       size_t nlines = lines->nlines;
       if (nlines > 0)
 	{
@@ -56,24 +66,12 @@ dwfl_module_getsrc (Dwfl_Module *mod, Dwarf_Addr addr)
 	  /* Now we look at the module-relative address.  */
 	  addr -= bias;
 
-	  /* The lines are sorted by address, so we can use binary search.  */
-	  size_t l = 0, u = nlines - 1;
-	  while (l < u)
-	    {
-	      size_t idx = u - (u - l) / 2;
-	      Dwarf_Line *line = &lines->info[idx];
-	      if (addr < line->addr)
-		u = idx - 1;
-	      else
-		l = idx;
-	    }
-
 	  /* The last line which is less than or equal to addr is what
 	     we want, unless it is the end_sequence which is after the
 	     current line sequence.  */
-	  Dwarf_Line *line = &lines->info[l];
-	  if (! line->end_sequence && line->addr <= addr)
-	    return &cu->lines->idx[l];
+	  size_t n = __libdw_lines_upto (lines, addr);
+	  if (n > 0 && ! lines->info[n - 1].end_sequence)
+	    return &cu->lines->idx[n - 1];
 	}
 
       error = DWFL_E_ADDR_OUTOFRANGE;
@@ -43,7 +43,7 @@ dwfl_dwarf_line_file (const Dwarf_Line *line)
 static inline Dwarf_Line *
 dwfl_line (const Dwfl_Line *line)
 {
-  return &dwfl_linecu (line)->die.cu->lines->info[line->idx];
+  return &__libdw_cu_lines (dwfl_linecu (line)->die.cu)->info[line->idx];
 }
 
 static inline const char *
@@ -85,9 +85,10 @@ dwfl_module_getsrc_file (Dwfl_Module *mod,
 	 no match is performed.  */
       const char *lastfile = NULL;
       bool lastmatch = false;
-      for (size_t cnt = 0; cnt < cu->die.cu->lines->nlines; ++cnt)
+      Dwarf_Lines *lines = __libdw_cu_lines (cu->die.cu);
+      for (size_t cnt = 0; cnt < lines->nlines; ++cnt)
 	{
-	  Dwarf_Line *line = &cu->die.cu->lines->info[cnt];
+	  Dwarf_Line *line = &lines->info[cnt];
 
 	  if (unlikely (line->file >= line->files->nfiles))
 	    {
@@ -50,7 +50,7 @@ dwfl_onesrcline (Dwarf_Die *cudie, size_t idx)
 	}
     }
 
-  if (idx >= cu->die.cu->lines->nlines)
+  if (idx >= __libdw_cu_lines (cu->die.cu)->nlines)
     {
       __libdwfl_seterrno (DWFL_E (LIBDW, DWARF_E_INVALID_LINE_IDX));
       return NULL;
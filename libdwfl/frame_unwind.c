@@ -34,6 +34,7 @@
 #include <stdlib.h>
 #include "libdwflP.h"
 #include "../libdw/dwarf.h"
+#include "../libdw/memory-access.h"
 #include <system.h>
 
 /* Maximum number of DWARF expression stack slots before returning an error.  */
@@ -140,6 +141,88 @@ do_pop (struct eval_stack *stack, Dwarf_Addr *val)
   return true;
 }
 
+/* Whether the memory of THREAD read last has the BYTES at ADDR.  */
+static bool
+thread_mem_has (Dwfl_Thread *thread, Dwarf_Addr addr, size_t bytes)
+{
+  return (addr >= thread->mem_addr && thread->mem_len >= bytes
+	  && addr - thread->mem_addr <= thread->mem_len - bytes);
+}
+
+/* The word of BYTES at P in the byte order of PROCESS.  */
+static Dwarf_Word
+read_word (Dwfl_Process *process, const unsigned char *p, unsigned bytes)
+{
+  bool msb = ebl_get_elfdata (process->ebl) == ELFDATA2MSB;
+  if (bytes == 8)
+    {
+      uint64_t val = read_8ubyte_unaligned_noncvt (p);
+      return msb ? BE64 (val) : LE64 (val);
+    }
+  uint32_t val = read_4ubyte_unaligned_noncvt (p);
+  return msb ? BE32 (val) : LE32 (val);
+}
+
+bool
+internal_function
+__libdwfl_memory_read (Dwfl_Thread *thread, Dwarf_Addr addr,
+		       Dwarf_Word *result)
+{
+  Dwfl_Process *process = thread->process;
+  unsigned bytes = ebl_get_elfclass (process->ebl) == ELFCLASS64 ? 8 : 4;
+  if (process->memory_read_range != NULL)
+    {
+      if (! thread_mem_has (thread, addr, bytes))
+	{
+	  /* Read the whole block, or if that isn't all there, like at
+	     the start of a copy of the stack, the rest of it.  */
+	  Dwarf_Addr block = addr & ~(Dwarf_Addr) (DWFL_MEMORY_BLOCK_SIZE - 1);
+	  size_t rest = DWFL_MEMORY_BLOCK_SIZE - (addr - block);
+	  thread->mem_len = 0;
+	  if (process->memory_read_range (process->dwfl, block, thread->mem,
+					  DWFL_MEMORY_BLOCK_SIZE,
+					  process->callbacks_arg))
+	    {
+	      thread->mem_addr = block;
+	      thread->mem_len = DWFL_MEMORY_BLOCK_SIZE;
+	    }
+	  else if (addr != block
+		   && process->memory_read_range (process->dwfl, addr,
+						  thread->mem, rest,
+						  process->callbacks_arg))
+	    {
+	      thread->mem_addr = addr;
+	      thread->mem_len = rest;
+	    }
+	}
+      if (thread_mem_has (thread, addr, bytes))
+	{
+	  *result = read_word (process, &thread->mem[addr - thread->mem_addr],
+			       bytes);
+	  return true;
+	}
+
+      /* Not in memory that could be read, or the word crosses blocks.  */
+      if (process->callbacks->memory_read == NULL)
+	{
+	  unsigned char buf[8];
+	  if (! process->memory_read_range (process->dwfl, addr, buf, bytes,
+					    process->callbacks_arg))
+	    return false;
+	  *result = read_word (process, buf, bytes);
+	  return true;
+	}
+    }
+
+  if (process->callbacks->memory_read == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_INVALID_ARGUMENT);
+      return false;
+    }
+  return process->callbacks->memory_read (process->dwfl, addr, result,
+					  process->callbacks_arg);
+}
+
 /* If FRAME is NULL is are computing CFI frame base.  In such case another
    DW_OP_call_frame_cfa is no longer permitted.  */
 
@@ -147,7 +230,6 @@ static bool
 expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	   size_t nops, Dwarf_Addr *result, Dwarf_Addr bias)
 {
-  Dwfl_Process *process = state->thread->process;
   if (nops == 0)
     {
       __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
@@ -306,15 +388,8 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	  break;
 	case DW_OP_deref:
 	case DW_OP_deref_size:
-	  if (process->callbacks->memory_read == NULL)
-	    {
-	      free (stack.addrs);
-	      __libdwfl_seterrno (DWFL_E_INVALID_ARGUMENT);
-	      return false;
-	    }
 	  if (! pop (&val1)
-	      || ! process->callbacks->memory_read (process->dwfl, val1, &val1,
-						    process->callbacks_arg))
+	      || ! __libdwfl_memory_read (state->thread, val1, &val1))
 	    {
 	      free (stack.addrs);
 	      return false;
@@ -491,17 +566,9 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
       return false;
     }
   free (stack.addrs);
-  if (is_location)
-    {
-      if (process->callbacks->memory_read == NULL)
-	{
-	  __libdwfl_seterrno (DWFL_E_INVALID_ARGUMENT);
-	  return false;
-	}
-      if (! process->callbacks->memory_read (process->dwfl, *result, result,
-					     process->callbacks_arg))
-	return false;
-    }
+  if (is_location
+      && ! __libdwfl_memory_read (state->thread, *result, result))
+    return false;
   return true;
 #undef push
 #undef pop
@@ -511,22 +578,10 @@ static Dwfl_Frame *
 new_unwound (Dwfl_Frame *state)
 {
   assert (state->unwound == NULL);
-  Dwfl_Thread *thread = state->thread;
-  Dwfl_Process *process = thread->process;
-  Ebl *ebl = process->ebl;
-  size_t nregs = ebl_frame_nregs (ebl);
-  assert (nregs > 0);
-  Dwfl_Frame *unwound;
-  unwound = malloc (sizeof (*unwound) + sizeof (*unwound->regs) * nregs);
+  Dwfl_Frame *unwound = __libdwfl_frame_alloc (state->thread);
   if (unlikely (unwound == NULL))
     return NULL;
   state->unwound = unwound;
-  unwound->thread = thread;
-  unwound->unwound = NULL;
-  unwound->signal_frame = false;
-  unwound->initial_frame = false;
-  unwound->pc_state = DWFL_FRAME_STATE_ERROR;
-  memset (unwound->regs_set, 0, sizeof (unwound->regs_set));
   return unwound;
 }
 
@@ -538,8 +593,10 @@ new_unwound (Dwfl_Frame *state)
 static void
 handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
 {
+  /* FRAME belongs to CFI, unwinding through the same code again just
+     looks it up.  */
   Dwarf_Frame *frame;
-  if (INTUSE(dwarf_cfi_addrframe) (cfi, pc, &frame) != 0)
+  if (INTUSE(dwarf_cfi_addrframe_cached) (cfi, pc, &frame) != 0)
     {
       __libdwfl_seterrno (DWFL_E_LIBDW);
       return;
@@ -669,7 +726,6 @@ handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
 	    unwound->pc_state = DWFL_FRAME_STATE_PC_UNDEFINED;
 	}
     }
-  free (frame);
 }
 
 static bool
@@ -707,10 +763,43 @@ static bool
 readfunc (Dwarf_Addr addr, Dwarf_Word *datap, void *arg)
 {
   Dwfl_Frame *state = arg;
-  Dwfl_Thread *thread = state->thread;
-  Dwfl_Process *process = thread->process;
-  return process->callbacks->memory_read (process->dwfl, addr, datap,
-					  process->callbacks_arg);
+  return __libdwfl_memory_read (state->thread, addr, datap);
+}
+
+/* Unwind STATE with the unwinder of the backend, which follows the frame
+   pointers of the architecture.  With FRAME_POINTER the one for return
+   addresses, which can go on from CFI and the other way around, else the
+   one for frames it is the only way to go on from.  Returns false if it
+   cannot.  */
+static bool
+ebl_unwind_state (Dwfl_Frame *state, Dwarf_Addr pc, bool frame_pointer)
+{
+  Ebl *ebl = state->thread->process->ebl;
+  if (new_unwound (state) == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_NOMEM);
+      return false;
+    }
+  state->unwound->pc_state = DWFL_FRAME_STATE_PC_UNDEFINED;
+  // &Dwfl_Frame.signal_frame cannot be passed as it is a bitfield.
+  bool signal_frame = false;
+  if (! (frame_pointer
+	 ? ebl_frame_pointer_unwind (ebl, pc, setfunc, getfunc, readfunc,
+				     state, &signal_frame)
+	 : ebl_unwind (ebl, pc, setfunc, getfunc, readfunc, state,
+		       &signal_frame)))
+    {
+      // Discard the unwind attempt.  During next __libdwfl_frame_unwind call
+      // we may have for example the appropriate Dwfl_Module already mapped.
+      assert (state->unwound->unwound == NULL);
+      __libdwfl_frame_free (state->unwound);
+      state->unwound = NULL;
+      return false;
+    }
+  assert (state->unwound->pc_state == DWFL_FRAME_STATE_PC_SET);
+  state->unwound->signal_frame = signal_frame;
+  state->unwound->ebl_unwound = ! frame_pointer;
+  return true;
 }
 
 void
@@ -727,8 +816,20 @@ __libdwfl_frame_unwind (Dwfl_Frame *state)
     return;
   /* Check whether this is the initial frame or a signal frame.
      Then we need to unwind from the original, unadjusted PC.  */
-  if (! state->initial_frame && ! state->signal_frame)
+  bool return_address = ! state->initial_frame && ! state->signal_frame;
+  if (return_address)
     pc--;
+  /* A return address is past the prologue of its function, so with
+     frame pointers there is no need for CFI.  Where ebl_unwind went
+     before, only it knows how to go on.  */
+  bool frame_pointer = return_address && ! state->ebl_unwound;
+  bool fp_tried = false;
+  if (frame_pointer && state->thread->process->frame_pointer_unwind)
+    {
+      if (ebl_unwind_state (state, pc, true))
+	return;
+      fp_tried = true;
+    }
   Dwfl_Module *mod = INTUSE(dwfl_addrmodule) (state->thread->process->dwfl, pc);
   if (mod == NULL)
     __libdwfl_seterrno (DWFL_E_NO_DWARF);
@@ -751,27 +852,7 @@ __libdwfl_frame_unwind (Dwfl_Frame *state)
 	}
     }
   assert (state->unwound == NULL);
-  Dwfl_Thread *thread = state->thread;
-  Dwfl_Process *process = thread->process;
-  Ebl *ebl = process->ebl;
-  if (new_unwound (state) == NULL)
-    {
-      __libdwfl_seterrno (DWFL_E_NOMEM);
-      return;
-    }
-  state->unwound->pc_state = DWFL_FRAME_STATE_PC_UNDEFINED;
-  // &Dwfl_Frame.signal_frame cannot be passed as it is a bitfield.
-  bool signal_frame = false;
-  if (! ebl_unwind (ebl, pc, setfunc, getfunc, readfunc, state, &signal_frame))
-    {
-      // Discard the unwind attempt.  During next __libdwfl_frame_unwind call
-      // we may have for example the appropriate Dwfl_Module already mapped.
-      assert (state->unwound->unwound == NULL);
-      free (state->unwound);
-      state->unwound = NULL;
-      // __libdwfl_seterrno has been called above.
-      return;
-    }
-  assert (state->unwound->pc_state == DWFL_FRAME_STATE_PC_SET);
-  state->unwound->signal_frame = signal_frame;
+  // On failure __libdwfl_seterrno has been called above.
+  if (! fp_tried)
+    ebl_unwind_state (state, pc, frame_pointer);
 }
@@ -494,6 +494,21 @@ extern const char *dwfl_module_addrinfo (Dwfl_Module *mod, GElf_Addr address,
 					 Dwarf_Addr *bias)
   __nonnull_attribute__ (3);
 
+/* Look up many addresses in MOD at once.  For each of the N ADDRS,
+   NAMES[i] is set to the symbol name dwfl_module_addrinfo would return
+   (NULL when nothing was found) and, if OFFSETS is not NULL, OFFSETS[i]
+   to the offset from the start of that symbol.  If LINES is not NULL,
+   LINES[i] is set to the source line dwfl_module_getsrc would return,
+   or NULL.  ADDRS does not need to be sorted, but sorted input avoids
+   sorting it internally.  Returns the number of addresses for which a
+   symbol was found, or -1 on error.  */
+extern ptrdiff_t dwfl_module_addrinfo_batch (Dwfl_Module *mod, size_t n,
+					     const GElf_Addr *addrs,
+					     const char **names,
+					     GElf_Off *offsets,
+					     Dwfl_Line **lines)
+  __nonnull_attribute__ (3, 4);
+
 /* Find the symbol that ADDRESS lies inside, and return detailed
    information as for dwfl_module_getsym (above).  Note that like
    dwfl_module_getsym this function also adjusts SYM->ST_VALUE to an
@@ -704,6 +719,34 @@ bool dwfl_attach_state (Dwfl *dwfl, Elf *elf, pid_t pid,
 			void *dwfl_arg)
   __nonnull_attribute__ (1, 4);
 
+/* Called after dwfl_attach_state for backends that can read more than a
+   word of memory at a time.  MEMORY_READ_RANGE reads SIZE bytes at ADDR
+   into BUF, in the byte order of the target, and returns true, or returns
+   false if not all of them could be read.  The unwinder then reads the
+   stack in blocks with it.  It still uses memory_read of the
+   Dwfl_Thread_Callbacks, if there is one, for words the blocks don't have.
+   Returns false if DWFL has no attached state.  */
+bool dwfl_set_memory_read_range (Dwfl *dwfl,
+				 bool (*memory_read_range) (Dwfl *dwfl,
+							    Dwarf_Addr addr,
+							    void *buf,
+							    size_t size,
+							    void *dwfl_arg))
+  __nonnull_attribute__ (1);
+
+/* Called after dwfl_attach_state to unwind with frame pointers first, for
+   processes whose code keeps them.  If ENABLE, the frames that were left
+   by a call are unwound by following the chain of frame pointers like
+   the architecture lays it out, and CFI is only used where that fails.
+   The initial frame and signal frames, which may stop in a prologue or
+   in a function without a frame, are still unwound with CFI first.
+   This is much faster, but gives wrong frames for calls from code that
+   does not keep a frame pointer.  Only some architectures can do it,
+   others always use CFI.  Returns false if DWFL has no attached
+   state.  */
+bool dwfl_set_frame_pointer_unwind (Dwfl *dwfl, bool enable)
+  __nonnull_attribute__ (1);
+
 /* Calls dwfl_attach_state with Dwfl_Thread_Callbacks setup for extracting
    thread state from the ELF core file.  Returns the pid number extracted
    from the core file, or -1 for errors.  */
@@ -721,6 +764,32 @@ extern int dwfl_core_file_attach (Dwfl *dwfl, Elf *elf);
 extern int dwfl_linux_proc_attach (Dwfl *dwfl, pid_t pid,
 				   bool assume_ptrace_stopped);
 
+/* Calls dwfl_attach_state with Dwfl_Thread_Callbacks setup for unwinding
+   samples of threads of process PID, given to dwfl_sample_getframes.
+   Nothing is read from the process, which doesn't need to exist anymore.
+   ELF is used like for dwfl_attach_state to find the architecture.
+   DWFL stays attached for any number of samples.  Returns zero on success,
+   -1 on error.  */
+extern int dwfl_sample_attach (Dwfl *dwfl, Elf *elf, pid_t pid)
+  __nonnull_attribute__ (1);
+
+/* Like dwfl_getthread_frames for a sample of thread TID, for DWFL on which
+   dwfl_sample_attach was called.  REGS are the NREGS registers of the
+   thread starting at DWARF register zero, PC is its program counter.
+   STACK is a copy of STACK_SIZE bytes of its memory starting at address
+   STACK_START, usually from the stack pointer up, like perf_event records
+   with PERF_SAMPLE_STACK_USER.  Memory is only read from that copy, so
+   unwinding stops where the frames leave it.  REGS and STACK are only used
+   during the call.  */
+extern int dwfl_sample_getframes (Dwfl *dwfl, pid_t tid, Dwarf_Addr pc,
+				  const Dwarf_Word *regs, unsigned int nregs,
+				  const void *stack, size_t stack_size,
+				  Dwarf_Addr stack_start,
+				  int (*callback) (Dwfl_Frame *state,
+						   void *arg),
+				  void *arg)
+  __nonnull_attribute__ (1, 9);
+
 /* Return PID for the process associated with DWFL.  Function returns -1 if
    dwfl_attach_state was not called for DWFL.  */
 pid_t dwfl_pid (Dwfl *dwfl)
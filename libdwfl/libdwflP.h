@@ -189,6 +189,10 @@ struct Dwfl_Module
   Elf_Data *symxndxdata;	/* Data in the extended section index table. */
   Elf_Data *aux_symxndxdata;	/* Data in the extended auxiliary table. */
 
+  /* Symbols sorted by address for dwfl_module_addrsym (index 1) and
+     dwfl_module_addrinfo (index 0), built lazily on first lookup.  */
+  struct dwfl_addrsym_index *addrsym_index[2];
+
   char *elfdir;			/* The dir where we found the main Elf.  */
 
   Dwarf *dw;			/* libdw handle for its debugging info.  */
@@ -206,6 +210,10 @@ struct Dwfl_Module
 
   struct dwfl_arange *aranges;	/* Mapping of addresses in module to CUs.  */
 
+  /* Lines of all CUs sorted by address for dwfl_module_getsrc, built
+     lazily after a number of lookups.  (void *) -1 if that failed.  */
+  struct dwfl_line_index *line_index;
+
   void *build_id_bits;		/* malloc'd copy of build ID bits.  */
   GElf_Addr build_id_vaddr;	/* Address where they reside, 0 if unknown.  */
   int build_id_len;		/* -1 for prior failure, 0 if unset.  */
@@ -213,6 +221,7 @@ struct Dwfl_Module
   unsigned int ncu;
   unsigned int lazycu;		/* Possible users, deleted when none left.  */
   unsigned int naranges;
+  unsigned int line_lookups;	/* Lookups before LINE_INDEX is built.  */
 
   Dwarf_CFI *dwarf_cfi;		/* Cached DWARF CFI for this module.  */
   Dwarf_CFI *eh_cfi;		/* Cached EH CFI for this module.  */
@@ -231,10 +240,22 @@ struct Dwfl_Process
   pid_t pid;
   const Dwfl_Thread_Callbacks *callbacks;
   void *callbacks_arg;
+  /* See dwfl_set_memory_read_range, NULL if not set.  */
+  bool (*memory_read_range) (Dwfl *dwfl, Dwarf_Addr addr, void *buf,
+			     size_t size, void *dwfl_arg);
   struct ebl *ebl;
   bool ebl_close:1;
+  /* See dwfl_set_frame_pointer_unwind.  */
+  bool frame_pointer_unwind:1;
+  /* Frames no longer used by any unwind, chained by their unwound
+     field, to be reused by the next ones.  */
+  Dwfl_Frame *free_frames;
 };
 
+/* Size and alignment of the blocks of memory read with
+   memory_read_range while unwinding, so a block never crosses a page.  */
+#define DWFL_MEMORY_BLOCK_SIZE 512
+
 /* See its typedef in libdwfl.h.  */
 
 struct Dwfl_Thread
@@ -244,6 +265,11 @@ struct Dwfl_Thread
   /* Bottom (innermost) frame while we're initializing, NULL afterwards.  */
   Dwfl_Frame *unwound;
   void *callbacks_arg;
+  /* The MEM_LEN bytes of memory at MEM_ADDR last read while unwinding.
+     Only used with memory_read_range of the process.  */
+  Dwarf_Addr mem_addr;
+  size_t mem_len;
+  unsigned char mem[DWFL_MEMORY_BLOCK_SIZE];
 };
 
 /* See its typedef in libdwfl.h.  */
@@ -255,6 +281,9 @@ struct Dwfl_Frame
   Dwfl_Frame *unwound;
   bool signal_frame : 1;
   bool initial_frame : 1;
+  /* Unwound by ebl_unwind, which leaves the registers in a way only it
+     can go on from.  */
+  bool ebl_unwound : 1;
   enum
   {
     /* This structure is still being initialized or there was an error
@@ -401,15 +430,66 @@ struct dwfl_arange
   size_t arange;		/* Index in Dwarf_Aranges.  */
 };
 
+/* One candidate value of a symbol as tried by __libdwfl_addrsym.  */
+struct dwfl_addrsym
+{
+  GElf_Addr value;		/* Symbol value as looked up.  */
+  GElf_Addr end;		/* value + st_size.  */
+  GElf_Addr max_end;		/* Highest end of this and all lower entries.  */
+  int ndx;			/* Index for dwfl_module_getsym.  */
+  bool adjusted;		/* Adjusted st_value of a resolved symbol.  */
+};
+
+/* Address-sorted symbol table of a Dwfl_Module.  The global symbols
+   come first, then the local symbols, each sorted separately since
+   __libdwfl_addrsym only looks at the locals when the globals give
+   no match.  */
+struct dwfl_addrsym_index
+{
+  size_t nglobals;
+  size_t nlocals;
+  struct dwfl_addrsym entries[];
+};
+
+/* Module-wide line index, see lines.c.  Entry I holds the line for
+   the addresses from ADDRS[I] up to ADDRS[I + 1].  */
+struct dwfl_line_index
+{
+  size_t n;
+  bool complete;		/* Else ask the CU before the first entry.  */
+  Dwfl_Line **lines;		/* NULL if no line, or ask the CU.  */
+  Dwarf_Addr addrs[];
+};
+
 #define __LIBDWFL_REMOTE_MEM_CACHE_SIZE 4096
-/* Structure for caching remote memory reads as used by __libdwfl_pid_arg.  */
-struct __libdwfl_remote_mem_cache
+/* The cache has this many sets of pages, a remote page can only be in
+   the set of its page number modulo the number of sets.  */
+#define __LIBDWFL_REMOTE_MEM_CACHE_SETS 16
+#define __LIBDWFL_REMOTE_MEM_CACHE_WAYS 4
+/* Number of pages read at once going up the stack, at most the number
+   of sets so they don't evict each other.  */
+#define __LIBDWFL_REMOTE_MEM_CACHE_PREFETCH 8
+
+/* One page of the remote memory cache.  */
+struct __libdwfl_remote_mem_page
 {
   Dwarf_Addr addr; /* Remote address.  */
   Dwarf_Off len;   /* Zero if cleared, otherwise likely 4K. */
+  unsigned int used; /* Time of the last use, for replacing pages.  */
   unsigned char buf[__LIBDWFL_REMOTE_MEM_CACHE_SIZE]; /* The actual cache.  */
 };
 
+/* Structure for caching remote memory reads as used by __libdwfl_pid_arg.
+   Set associative, the least recently used page of a set is replaced.  */
+struct __libdwfl_remote_mem_cache
+{
+  /* Counts the page lookups, zero if nothing was read since the cache
+     was cleared.  */
+  unsigned int clock;
+  struct __libdwfl_remote_mem_page pages[__LIBDWFL_REMOTE_MEM_CACHE_SETS
+					 * __LIBDWFL_REMOTE_MEM_CACHE_WAYS];
+};
+
 /* Structure used for keeping track of ptrace attaching a thread.
    Shared by linux-pid-attach and linux-proc-maps.  If it has been setup
    then get the instance through __libdwfl_get_pid_arg.  */
@@ -461,6 +541,15 @@ extern const char *__libdwfl_getsym (Dwfl_Module *mod, int ndx, GElf_Sym *sym,
 				     bool *resolved, bool adjust_st_value)
   internal_function;
 
+/* Internal wrapper for old dwfl_module_addrsym and new dwfl_module_addrinfo.
+   adjust_st_value set to true returns adjusted SYM st_value, set to false
+   it will not adjust SYM at all, but does match against resolved values.  */
+extern const char *__libdwfl_addrsym (Dwfl_Module *mod, GElf_Addr addr,
+				      GElf_Off *off, GElf_Sym *closest_sym,
+				      GElf_Word *shndxp, Elf **elfp,
+				      Dwarf_Addr *biasp, bool adjust_st_value)
+  internal_function;
+
 extern void __libdwfl_module_free (Dwfl_Module *mod) internal_function;
 
 /* Find the main ELF file, update MOD->elferr and/or MOD->main.elf.  */
@@ -516,10 +605,24 @@ extern Dwfl_Error __libdwfl_nextcu (Dwfl_Module *mod, struct dwfl_cu *lastcu,
 extern Dwfl_Error __libdwfl_addrcu (Dwfl_Module *mod, Dwarf_Addr addr,
 				    struct dwfl_cu **cu) internal_function;
 
+/* Like __libdwfl_addrcu, but also store in *END the first address
+   above ADDR that might belong to another CU.  */
+extern Dwfl_Error __libdwfl_addrcu_end (Dwfl_Module *mod, Dwarf_Addr addr,
+					struct dwfl_cu **cu, Dwarf_Addr *end)
+  internal_function;
+
 /* Ensure that CU->lines (and CU->cu->lines) is set up.  */
 extern Dwfl_Error __libdwfl_cu_getsrclines (struct dwfl_cu *cu)
   internal_function;
 
+/* Look up ADDR, a DWARF address in MOD, in the index of all lines of
+   the module.  Returns true and sets *LINE, NULL if there is no line
+   for ADDR.  Returns false if the line has to be looked up in the CU
+   of ADDR, which is also what happens until the index is built.  */
+extern bool __libdwfl_line_index_lookup (Dwfl_Module *mod, Dwarf_Addr addr,
+					 Dwfl_Line **line)
+  internal_function;
+
 /* Look in ELF for an NT_GNU_BUILD_ID note.  Store it to BUILD_ID_BITS,
    its vaddr in ELF to BUILD_ID_VADDR (it is unrelocated, even if MOD is not
    NULL) and store length to BUILD_ID_LEN.  Returns -1 for errors, 1 if it was
@@ -582,6 +685,16 @@ extern Dwfl_Module *__libdwfl_report_offline (Dwfl *dwfl, const char *name,
 extern void __libdwfl_process_free (Dwfl_Process *process)
   internal_function;
 
+/* Return a new frame for THREAD with no registers set, or NULL if out
+   of memory.  Frames come from the free ones of the process if there
+   are any.  */
+extern Dwfl_Frame *__libdwfl_frame_alloc (Dwfl_Thread *thread)
+  internal_function;
+
+/* Give STATE and the frames it unwound to back to their process.  */
+extern void __libdwfl_frame_free (Dwfl_Frame *state)
+  internal_function;
+
 /* Update STATE->unwound for the unwound frame.
    On error STATE->unwound == NULL
    or STATE->unwound->pc_state == DWFL_FRAME_STATE_ERROR;
@@ -591,6 +704,13 @@ extern void __libdwfl_process_free (Dwfl_Process *process)
 extern void __libdwfl_frame_unwind (Dwfl_Frame *state)
   internal_function;
 
+/* Read the address sized word at ADDR of the process of THREAD into
+   *RESULT, with the memory_read callback or from the blocks read with
+   memory_read_range.  */
+extern bool __libdwfl_memory_read (Dwfl_Thread *thread, Dwarf_Addr addr,
+				   Dwarf_Word *result)
+  internal_function;
+
 /* Align segment START downwards or END upwards addresses according to DWFL.  */
 extern GElf_Addr __libdwfl_segment_start (Dwfl *dwfl, GElf_Addr start)
   internal_function;
@@ -775,6 +895,7 @@ INTDECL (dwfl_module_relocate_address)
 INTDECL (dwfl_module_dwarf_cfi)
 INTDECL (dwfl_module_eh_cfi)
 INTDECL (dwfl_attach_state)
+INTDECL (dwfl_set_memory_read_range)
 INTDECL (dwfl_pid)
 INTDECL (dwfl_thread_dwfl)
 INTDECL (dwfl_thread_tid)
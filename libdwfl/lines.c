@@ -1,4 +1,4 @@
-/* Fetch source line info for CU.
+/* Fetch source line info for CU, and index all lines of a module.
    Copyright (C) 2005, 2006 Red Hat, Inc.
    This file is part of elfutils.
 
@@ -54,3 +54,228 @@ __libdwfl_cu_getsrclines (struct dwfl_cu *cu)
 
   return DWFL_E_NOERROR;
 }
+
+/* How many lookups a module gets before we index all its lines.  A
+   few lookups are cheaper done per CU than reading all line tables.  */
+#define LINE_INDEX_LOOKUPS 64
+
+/* An index entry for addresses that have to be looked up in their CU.  */
+#define LINE_INDEX_ASK_CU ((Dwfl_Line *) -1l)
+
+struct line_range
+{
+  Dwarf_Addr start;
+  Dwarf_Addr end;
+  Dwfl_Line *line;
+};
+
+static int
+compare_line_ranges (const void *a, const void *b)
+{
+  const struct line_range *r1 = a;
+  const struct line_range *r2 = b;
+
+  return (r1->start < r2->start) ? -1 : r1->start > r2->start;
+}
+
+static bool
+add_line_range (struct line_range **ranges, size_t *nranges,
+		size_t *nalloc, Dwarf_Addr start, Dwarf_Addr end,
+		Dwfl_Line *line)
+{
+  if (*nranges == *nalloc)
+    {
+      size_t n = *nalloc == 0 ? 256 : 2 * *nalloc;
+      struct line_range *newp = realloc (*ranges, n * sizeof **ranges);
+      if (newp == NULL)
+	return false;
+      *ranges = newp;
+      *nalloc = n;
+    }
+
+  (*ranges)[*nranges].start = start;
+  (*ranges)[*nranges].end = end;
+  (*ranges)[*nranges].line = line;
+  ++*nranges;
+  return true;
+}
+
+/* Collect the address range each line of each CU in MOD covers, as
+   dwfl_module_getsrc would find it in the CU's own table.  CUs
+   without lines get their address ranges to be looked up in the CU,
+   and *COMPLETE is cleared, because the addresses no line covers
+   might then still belong to such a CU.  */
+static struct line_range *
+collect_line_ranges (Dwfl_Module *mod, size_t *nranges, bool *complete)
+{
+  struct line_range *ranges = NULL;
+  size_t nalloc = 0;
+  *nranges = 0;
+  *complete = true;
+
+  struct dwfl_cu *cu = NULL;
+  while (true)
+    {
+      if (__libdwfl_nextcu (mod, cu, &cu) != DWFL_E_NOERROR)
+	break;
+      if (cu == NULL)
+	return ranges;
+
+      if (__libdwfl_cu_getsrclines (cu) != DWFL_E_NOERROR)
+	{
+	  *complete = false;
+	  Dwarf_Addr base, start, end;
+	  ptrdiff_t offset = 0;
+	  while ((offset = INTUSE(dwarf_ranges) (&cu->die, offset, &base,
+						 &start, &end)) > 0)
+	    if (! add_line_range (&ranges, nranges, &nalloc,
+				  start, end, LINE_INDEX_ASK_CU))
+	      break;
+	  if (offset != 0)
+	    break;
+	  continue;
+	}
+
+      Dwarf_Lines *lines = __libdw_cu_lines (cu->die.cu);
+      for (size_t i = 0; i + 1 < lines->nlines; ++i)
+	if (! lines->info[i].end_sequence
+	    && lines->info[i].addr < lines->info[i + 1].addr
+	    && ! add_line_range (&ranges, nranges, &nalloc,
+				 lines->info[i].addr,
+				 lines->info[i + 1].addr,
+				 &cu->lines->idx[i]))
+	  goto fail;
+    }
+
+  /* If we don't get through all CUs, we cannot tell which addresses
+     nobody else covers.  */
+ fail:
+  free (ranges);
+  return NULL;
+}
+
+static void
+add_index_entry (struct dwfl_line_index *index, Dwarf_Addr addr,
+		 Dwfl_Line *line)
+{
+  index->addrs[index->n] = addr;
+  index->lines[index->n] = line;
+  index->n++;
+}
+
+/* Build the index of all lines in MOD.  Each entry gives the line for
+   the addresses up to the next entry.  Where line ranges of different
+   CUs overlap the lookup goes to the CU found by address as before.  */
+static struct dwfl_line_index *
+build_line_index (Dwfl_Module *mod)
+{
+  size_t nranges;
+  bool complete;
+  struct line_range *ranges = collect_line_ranges (mod, &nranges, &complete);
+  if (ranges == NULL)
+    return NULL;
+
+  qsort (ranges, nranges, sizeof ranges[0], compare_line_ranges);
+
+  /* Each range adds at most a start and a gap after it.  */
+  size_t max = 2 * nranges + 1;
+  struct dwfl_line_index *index
+    = malloc (sizeof *index + max * (sizeof (Dwarf_Addr)
+				     + sizeof (Dwfl_Line *)));
+  if (unlikely (index == NULL))
+    {
+      free (ranges);
+      return NULL;
+    }
+  index->n = 0;
+  index->complete = complete;
+  index->lines = (Dwfl_Line **) &index->addrs[max];
+
+  Dwfl_Line *gap = complete ? NULL : LINE_INDEX_ASK_CU;
+  Dwarf_Addr end = 0;
+  for (size_t i = 0; i < nranges; ++i)
+    {
+      struct line_range *r = &ranges[i];
+      size_t n = index->n;
+      if (n > 0 && r->start < end)
+	{
+	  /* Overlap, nobody gets to claim the rest of the range.  */
+	  if (index->addrs[n - 1] == r->start)
+	    index->lines[n - 1] = LINE_INDEX_ASK_CU;
+	  else if (index->lines[n - 1] != LINE_INDEX_ASK_CU)
+	    add_index_entry (index, r->start, LINE_INDEX_ASK_CU);
+	  if (r->end > end)
+	    end = r->end;
+	  continue;
+	}
+
+      if (n > 0 && r->start > end)
+	add_index_entry (index, end, gap);
+      add_index_entry (index, r->start, r->line);
+      end = r->end;
+    }
+  if (index->n > 0)
+    add_index_entry (index, end, gap);
+
+  free (ranges);
+
+  /* Move the lines right after the addresses and give back the rest.  */
+  size_t n = index->n;
+  memmove (&index->addrs[n], index->lines, n * sizeof (Dwfl_Line *));
+  struct dwfl_line_index *newp
+    = realloc (index, sizeof *index + n * (sizeof (Dwarf_Addr)
+					   + sizeof (Dwfl_Line *)));
+  if (newp != NULL)
+    index = newp;
+  index->lines = (Dwfl_Line **) &index->addrs[n];
+  return index;
+}
+
+bool
+internal_function
+__libdwfl_line_index_lookup (Dwfl_Module *mod, Dwarf_Addr addr,
+			     Dwfl_Line **line)
+{
+  if (mod->line_index == NULL)
+    {
+      if (++mod->line_lookups < LINE_INDEX_LOOKUPS)
+	return false;
+
+      mod->line_index = build_line_index (mod);
+      if (mod->line_index == NULL)
+	{
+	  mod->line_index = (void *) -1l;
+	  return false;
+	}
+    }
+  if (mod->line_index == (void *) -1l)
+    return false;
+
+  /* Find the last entry at or before ADDR.  Only the address column is
+     touched until we know the entry, and the comparisons are not
+     branched on.  */
+  const struct dwfl_line_index *index = mod->line_index;
+  if (index->n == 0 || addr < index->addrs[0])
+    {
+      /* Like after the last entry, a CU without lines might still
+	 cover ADDR.  */
+      if (! index->complete)
+	return false;
+      *line = NULL;
+      return true;
+    }
+
+  size_t start = 0;
+  size_t n = index->n;
+  while (n > 1)
+    {
+      size_t half = n / 2;
+      start = index->addrs[start + half] <= addr ? start + half : start;
+      n -= half;
+    }
+
+  if (index->lines[start] == LINE_INDEX_ASK_CU)
+    return false;
+  *line = index->lines[start];
+  return true;
+}
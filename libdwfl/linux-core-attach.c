@@ -50,19 +50,17 @@ struct thread_arg
   size_t note_offset;
 };
 
-static bool
-core_memory_read (Dwfl *dwfl, Dwarf_Addr addr, Dwarf_Word *result,
-		  void *dwfl_arg)
+/* Return the SIZE bytes at ADDR in the PT_LOAD segments of the core
+   file as TYPE, or NULL if they are not all there.  */
+static Elf_Data *
+core_read (Dwfl *dwfl, Elf *core, Dwarf_Addr addr, size_t size,
+	   Elf_Type type)
 {
-  Dwfl_Process *process = dwfl->process;
-  struct core_arg *core_arg = dwfl_arg;
-  Elf *core = core_arg->core;
-  assert (core != NULL);
-  static size_t phnum;
+  size_t phnum;
   if (elf_getphdrnum (core, &phnum) < 0)
     {
       __libdwfl_seterrno (DWFL_E_LIBELF);
-      return false;
+      return NULL;
     }
   for (size_t cnt = 0; cnt < phnum; ++cnt)
     {
@@ -73,26 +71,52 @@ core_memory_read (Dwfl *dwfl, Dwarf_Addr addr, Dwarf_Word *result,
       GElf_Addr start = __libdwfl_segment_start (dwfl, phdr->p_vaddr);
       GElf_Addr end = __libdwfl_segment_end (dwfl,
 					     phdr->p_vaddr + phdr->p_memsz);
-      unsigned bytes = ebl_get_elfclass (process->ebl) == ELFCLASS64 ? 8 : 4;
-      if (addr < start || addr + bytes > end)
+      if (addr < start || addr + size > end)
 	continue;
       Elf_Data *data;
       data = elf_getdata_rawchunk (core, phdr->p_offset + addr - start,
-				   bytes, ELF_T_ADDR);
+				   size, type);
       if (data == NULL)
 	{
 	  __libdwfl_seterrno (DWFL_E_LIBELF);
-	  return false;
+	  return NULL;
 	}
-      assert (data->d_size == bytes);
-      if (bytes == 8)
-	*result = read_8ubyte_unaligned_noncvt (data->d_buf);
-      else
-	*result = read_4ubyte_unaligned_noncvt (data->d_buf);
-      return true;
+      assert (data->d_size == size);
+      return data;
     }
   __libdwfl_seterrno (DWFL_E_ADDR_OUTOFRANGE);
-  return false;
+  return NULL;
+}
+
+static bool
+core_memory_read (Dwfl *dwfl, Dwarf_Addr addr, Dwarf_Word *result,
+		  void *dwfl_arg)
+{
+  Dwfl_Process *process = dwfl->process;
+  struct core_arg *core_arg = dwfl_arg;
+  Elf *core = core_arg->core;
+  assert (core != NULL);
+  unsigned bytes = ebl_get_elfclass (process->ebl) == ELFCLASS64 ? 8 : 4;
+  Elf_Data *data = core_read (dwfl, core, addr, bytes, ELF_T_ADDR);
+  if (data == NULL)
+    return false;
+  if (bytes == 8)
+    *result = read_8ubyte_unaligned_noncvt (data->d_buf);
+  else
+    *result = read_4ubyte_unaligned_noncvt (data->d_buf);
+  return true;
+}
+
+static bool
+core_memory_read_range (Dwfl *dwfl, Dwarf_Addr addr, void *buf, size_t size,
+			void *dwfl_arg)
+{
+  struct core_arg *core_arg = dwfl_arg;
+  Elf_Data *data = core_read (dwfl, core_arg->core, addr, size, ELF_T_BYTE);
+  if (data == NULL)
+    return false;
+  memcpy (buf, data->d_buf, size);
+  return true;
 }
 
 static pid_t
@@ -429,6 +453,7 @@ dwfl_core_file_attach (Dwfl *dwfl, Elf *core)
       ebl_closebackend (ebl);
       return -1;
     }
+  INTUSE(dwfl_set_memory_read_range) (dwfl, core_memory_read_range);
   return pid;
 }
 INTDEF (dwfl_core_file_attach)
@@ -117,65 +117,172 @@ __libdwfl_ptrace_attach (pid_t tid, bool *tid_was_stoppedp)
 }
 
 #ifdef HAVE_PROCESS_VM_READV
-/* Note that the result word size depends on the architecture word size.
-   That is sizeof long. */
-static bool
-read_cached_memory (struct __libdwfl_pid_arg *pid_arg,
-		    Dwarf_Addr addr, Dwarf_Word *result)
+/* Return the cached page for the remote page at PAGE_ADDR, or NULL.  */
+static struct __libdwfl_remote_mem_page *
+find_cached_page (struct __libdwfl_remote_mem_cache *mem_cache,
+		  Dwarf_Addr page_addr)
 {
-  /* Let the ptrace fallback deal with the corner case of the address
-     possibly crossing a page boundary.  */
-  if ((addr & ((Dwarf_Addr)__LIBDWFL_REMOTE_MEM_CACHE_SIZE - 1))
-      > (Dwarf_Addr)__LIBDWFL_REMOTE_MEM_CACHE_SIZE - sizeof (unsigned long))
-    return false;
+  size_t set = ((page_addr / __LIBDWFL_REMOTE_MEM_CACHE_SIZE)
+		% __LIBDWFL_REMOTE_MEM_CACHE_SETS);
+  struct __libdwfl_remote_mem_page *pages
+    = &mem_cache->pages[set * __LIBDWFL_REMOTE_MEM_CACHE_WAYS];
+  for (size_t i = 0; i < __LIBDWFL_REMOTE_MEM_CACHE_WAYS; i++)
+    if (pages[i].len != 0 && pages[i].addr == page_addr)
+      return &pages[i];
+  return NULL;
+}
 
+/* Return the page to read the remote page at PAGE_ADDR into, the least
+   recently used one of its set.  */
+static struct __libdwfl_remote_mem_page *
+replace_page (struct __libdwfl_remote_mem_cache *mem_cache,
+	      Dwarf_Addr page_addr)
+{
+  size_t set = ((page_addr / __LIBDWFL_REMOTE_MEM_CACHE_SIZE)
+		% __LIBDWFL_REMOTE_MEM_CACHE_SETS);
+  struct __libdwfl_remote_mem_page *pages
+    = &mem_cache->pages[set * __LIBDWFL_REMOTE_MEM_CACHE_WAYS];
+  struct __libdwfl_remote_mem_page *oldest = &pages[0];
+  for (size_t i = 0; i < __LIBDWFL_REMOTE_MEM_CACHE_WAYS; i++)
+    {
+      if (pages[i].len == 0 || pages[i].addr == page_addr)
+	return &pages[i];
+      if (pages[i].used < oldest->used)
+	oldest = &pages[i];
+    }
+  return oldest;
+}
+
+/* Read NPAGES remote pages starting at PAGE_ADDR into the cache with
+   a single system call.  Returns the first one, or NULL if that could
+   not be read.  Reading stops at the first page that isn't mapped.  */
+static struct __libdwfl_remote_mem_page *
+read_pages (struct __libdwfl_pid_arg *pid_arg, Dwarf_Addr page_addr,
+	    size_t npages)
+{
   struct __libdwfl_remote_mem_cache *mem_cache = pid_arg->mem_cache;
-  if (mem_cache == NULL)
+  struct __libdwfl_remote_mem_page *pages[__LIBDWFL_REMOTE_MEM_CACHE_PREFETCH];
+  struct iovec local[__LIBDWFL_REMOTE_MEM_CACHE_PREFETCH];
+  struct iovec remote[__LIBDWFL_REMOTE_MEM_CACHE_PREFETCH];
+  assert (npages <= __LIBDWFL_REMOTE_MEM_CACHE_PREFETCH);
+
+  for (size_t i = 0; i < npages; i++)
     {
-      size_t mem_cache_size = sizeof (struct __libdwfl_remote_mem_cache);
-      mem_cache = (struct __libdwfl_remote_mem_cache *) malloc (mem_cache_size);
-      if (mem_cache == NULL)
-	return false;
+      Dwarf_Addr addr = page_addr + i * __LIBDWFL_REMOTE_MEM_CACHE_SIZE;
+      pages[i] = replace_page (mem_cache, addr);
+      pages[i]->addr = addr;
+      pages[i]->len = 0;
+      local[i].iov_base = pages[i]->buf;
+      local[i].iov_len = __LIBDWFL_REMOTE_MEM_CACHE_SIZE;
+      /* One remote iovec per page, the kernel only stops between
+	 them when a page cannot be read.  */
+      remote[i].iov_base = (void *) (uintptr_t) addr;
+      remote[i].iov_len = __LIBDWFL_REMOTE_MEM_CACHE_SIZE;
+    }
 
-      mem_cache->addr = 0;
-      mem_cache->len = 0;
-      pid_arg->mem_cache = mem_cache;
+  ssize_t res = process_vm_readv (pid_arg->tid_attached,
+				  local, npages, remote, npages, 0);
+  if (res < __LIBDWFL_REMOTE_MEM_CACHE_SIZE)
+    return NULL;
+
+  for (size_t i = 0; i < (size_t) res / __LIBDWFL_REMOTE_MEM_CACHE_SIZE; i++)
+    {
+      pages[i]->len = __LIBDWFL_REMOTE_MEM_CACHE_SIZE;
+      pages[i]->used = mem_cache->clock;
     }
+  return pages[0];
+}
 
-  unsigned char *d;
-  if (addr >= mem_cache->addr && addr - mem_cache->addr < mem_cache->len)
+/* Return the cached page for the remote page at PAGE_ADDR, reading it
+   if necessary.  The first read after the cache was cleared is from
+   the stack of a thread that was just attached, and unwinding goes up
+   the stack from there, so read ahead then and when the previous page
+   is already cached.  */
+static struct __libdwfl_remote_mem_page *
+get_page (struct __libdwfl_pid_arg *pid_arg, Dwarf_Addr page_addr)
+{
+  struct __libdwfl_remote_mem_cache *mem_cache = pid_arg->mem_cache;
+  bool first = mem_cache->clock++ == 0;
+  struct __libdwfl_remote_mem_page *page = find_cached_page (mem_cache,
+							     page_addr);
+  if (page != NULL)
     {
-      d = &mem_cache->buf[addr - mem_cache->addr];
-      if ((((uintptr_t) d) & (sizeof (unsigned long) - 1)) == 0)
-	*result = *(unsigned long *) d;
-      else
-	memcpy (result, d, sizeof (unsigned long));
-      return true;
+      page->used = mem_cache->clock;
+      return page;
     }
 
-  struct iovec local, remote;
-  mem_cache->addr = addr & ~((Dwarf_Addr)__LIBDWFL_REMOTE_MEM_CACHE_SIZE - 1);
-  local.iov_base = mem_cache->buf;
-  local.iov_len = __LIBDWFL_REMOTE_MEM_CACHE_SIZE;
-  remote.iov_base = (void *) (uintptr_t) mem_cache->addr;
-  remote.iov_len = __LIBDWFL_REMOTE_MEM_CACHE_SIZE;
+  size_t npages = 1;
+  if (first || (page_addr != 0
+		&& find_cached_page (mem_cache, (page_addr
+						 - __LIBDWFL_REMOTE_MEM_CACHE_SIZE))
+		   != NULL))
+    {
+      /* Not past the end of the address space.  */
+      Dwarf_Addr left = -page_addr / __LIBDWFL_REMOTE_MEM_CACHE_SIZE;
+      npages = __LIBDWFL_REMOTE_MEM_CACHE_PREFETCH;
+      if (left != 0 && left < npages)
+	npages = left;
+    }
+  return read_pages (pid_arg, page_addr, npages);
+}
 
-  ssize_t res = process_vm_readv (pid_arg->tid_attached,
-				  &local, 1, &remote, 1, 0);
-  if (res != __LIBDWFL_REMOTE_MEM_CACHE_SIZE)
+/* Copy SIZE bytes at ADDR from the cache into BUF, reading the pages
+   they are on if necessary.  */
+static bool
+read_cached_range (struct __libdwfl_pid_arg *pid_arg, Dwarf_Addr addr,
+		   void *buf, size_t size)
+{
+  struct __libdwfl_remote_mem_cache *mem_cache = pid_arg->mem_cache;
+  if (mem_cache == NULL)
     {
-      mem_cache->len = 0;
-      return false;
+      mem_cache = calloc (1, sizeof (struct __libdwfl_remote_mem_cache));
+      if (mem_cache == NULL)
+	return false;
+      pid_arg->mem_cache = mem_cache;
     }
 
-  mem_cache->len = res;
-  d = &mem_cache->buf[addr - mem_cache->addr];
-  if ((((uintptr_t) d) & (sizeof (unsigned long) - 1)) == 0)
-    *result = *(unsigned long *) d;
-  else
-    memcpy (result, d, sizeof (unsigned long));
+  unsigned char *d = buf;
+  while (size > 0)
+    {
+      Dwarf_Addr offset = addr & ((Dwarf_Addr) __LIBDWFL_REMOTE_MEM_CACHE_SIZE
+				  - 1);
+      struct __libdwfl_remote_mem_page *page = get_page (pid_arg,
+							 addr - offset);
+      if (page == NULL)
+	return false;
+      size_t n = __LIBDWFL_REMOTE_MEM_CACHE_SIZE - offset;
+      if (n > size)
+	n = size;
+      memcpy (d, &page->buf[offset], n);
+      d += n;
+      addr += n;
+      size -= n;
+    }
   return true;
 }
+
+/* Note that the result word size depends on the architecture word size.
+   That is sizeof long. */
+static bool
+read_cached_memory (struct __libdwfl_pid_arg *pid_arg,
+		    Dwarf_Addr addr, Dwarf_Word *result)
+{
+  /* The word might cross into the next page.  */
+  unsigned long word;
+  if (! read_cached_range (pid_arg, addr, &word, sizeof word))
+    return false;
+  *result = word;
+  return true;
+}
+
+static bool
+pid_memory_read_range (Dwfl *dwfl __attribute__ ((unused)), Dwarf_Addr addr,
+		       void *buf, size_t size, void *arg)
+{
+  struct __libdwfl_pid_arg *pid_arg = arg;
+  assert (pid_arg->tid_attached > 0);
+  return read_cached_range (pid_arg, addr, buf, size);
+}
 #endif /* HAVE_PROCESS_VM_READV */
 
 static void
@@ -183,7 +290,12 @@ clear_cached_memory (struct __libdwfl_pid_arg *pid_arg)
 {
   struct __libdwfl_remote_mem_cache *mem_cache = pid_arg->mem_cache;
   if (mem_cache != NULL)
-    mem_cache->len = 0;
+    {
+      mem_cache->clock = 0;
+      for (size_t i = 0; i < (__LIBDWFL_REMOTE_MEM_CACHE_SETS
+			      * __LIBDWFL_REMOTE_MEM_CACHE_WAYS); i++)
+	mem_cache->pages[i].len = 0;
+    }
 }
 
 /* Note that the result word size depends on the architecture word size.
@@ -484,6 +596,9 @@ dwfl_linux_proc_attach (Dwfl *dwfl, pid_t pid, bool assume_ptrace_stopped)
       free (pid_arg);
       return -1;
     }
+#ifdef HAVE_PROCESS_VM_READV
+  INTUSE(dwfl_set_memory_read_range) (dwfl, pid_memory_read_range);
+#endif
   return 0;
 }
 INTDEF (dwfl_linux_proc_attach)
@@ -0,0 +1,216 @@
+/* Get Dwarf Frame state from samples of registers and stack memory.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+
+#include "../libdw/memory-access.h"
+
+/* The sample dwfl_sample_getframes is unwinding.  */
+struct sample_arg
+{
+  pid_t tid;
+  Dwarf_Addr pc;
+  const Dwarf_Word *regs;
+  unsigned int nregs;
+  const unsigned char *stack;
+  size_t stack_size;
+  Dwarf_Addr stack_start;
+  /* Set while unwinding, the thread is only there then.  */
+  bool active;
+};
+
+/* Only the copy of the stack is available, there is nothing else to
+   read from.  */
+static bool
+sample_memory_read (Dwfl *dwfl, Dwarf_Addr addr, Dwarf_Word *result,
+		    void *dwfl_arg)
+{
+  Dwfl_Process *process = dwfl->process;
+  struct sample_arg *sample = dwfl_arg;
+  unsigned bytes = ebl_get_elfclass (process->ebl) == ELFCLASS64 ? 8 : 4;
+  if (addr < sample->stack_start
+      || sample->stack_size < bytes
+      || addr - sample->stack_start > sample->stack_size - bytes)
+    {
+      __libdwfl_seterrno (DWFL_E_ADDR_OUTOFRANGE);
+      return false;
+    }
+
+  const unsigned char *p = sample->stack + (addr - sample->stack_start);
+  if (bytes == 8)
+    *result = read_8ubyte_unaligned_noncvt (p);
+  else
+    *result = read_4ubyte_unaligned_noncvt (p);
+  return true;
+}
+
+static bool
+sample_memory_read_range (Dwfl *dwfl __attribute__ ((unused)),
+			  Dwarf_Addr addr, void *buf, size_t size,
+			  void *dwfl_arg)
+{
+  struct sample_arg *sample = dwfl_arg;
+  if (addr < sample->stack_start
+      || sample->stack_size < size
+      || addr - sample->stack_start > sample->stack_size - size)
+    {
+      __libdwfl_seterrno (DWFL_E_ADDR_OUTOFRANGE);
+      return false;
+    }
+
+  memcpy (buf, sample->stack + (addr - sample->stack_start), size);
+  return true;
+}
+
+static pid_t
+sample_next_thread (Dwfl *dwfl __attribute__ ((unused)), void *dwfl_arg,
+		    void **thread_argp)
+{
+  struct sample_arg *sample = dwfl_arg;
+  if (! sample->active || *thread_argp != NULL)
+    return 0;
+  *thread_argp = sample;
+  return sample->tid;
+}
+
+static bool
+sample_get_thread (Dwfl *dwfl __attribute__ ((unused)), pid_t tid,
+		   void *dwfl_arg, void **thread_argp)
+{
+  struct sample_arg *sample = dwfl_arg;
+  if (! sample->active || tid != sample->tid)
+    {
+      errno = ESRCH;
+      __libdwfl_seterrno (DWFL_E_ERRNO);
+      return false;
+    }
+  *thread_argp = sample;
+  return true;
+}
+
+static bool
+sample_set_initial_registers (Dwfl_Thread *thread, void *thread_arg)
+{
+  struct sample_arg *sample = thread_arg;
+  if (! INTUSE(dwfl_thread_state_registers) (thread, 0, sample->nregs,
+					     sample->regs))
+    return false;
+  INTUSE(dwfl_thread_state_register_pc) (thread, sample->pc);
+  return true;
+}
+
+static void
+sample_detach (Dwfl *dwfl __attribute__ ((unused)), void *dwfl_arg)
+{
+  free (dwfl_arg);
+}
+
+static const Dwfl_Thread_Callbacks sample_thread_callbacks =
+{
+  sample_next_thread,
+  sample_get_thread,
+  sample_memory_read,
+  sample_set_initial_registers,
+  sample_detach,
+  NULL, /* sample_thread_detach */
+};
+
+int
+dwfl_sample_attach (Dwfl *dwfl, Elf *elf, pid_t pid)
+{
+  struct sample_arg *sample = calloc (1, sizeof *sample);
+  if (sample == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_NOMEM);
+      return -1;
+    }
+  if (! INTUSE(dwfl_attach_state) (dwfl, elf, pid, &sample_thread_callbacks,
+				   sample))
+    {
+      free (sample);
+      return -1;
+    }
+  INTUSE(dwfl_set_memory_read_range) (dwfl, sample_memory_read_range);
+  return 0;
+}
+
+int
+dwfl_sample_getframes (Dwfl *dwfl, pid_t tid, Dwarf_Addr pc,
+		       const Dwarf_Word *regs, unsigned int nregs,
+		       const void *stack, size_t stack_size,
+		       Dwarf_Addr stack_start,
+		       int (*callback) (Dwfl_Frame *state, void *arg),
+		       void *arg)
+{
+  if (dwfl->attacherr != DWFL_E_NOERROR)
+    {
+      __libdwfl_seterrno (dwfl->attacherr);
+      return -1;
+    }
+
+  Dwfl_Process *process = dwfl->process;
+  if (process == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_NO_ATTACH_STATE);
+      return -1;
+    }
+  if (process->callbacks != &sample_thread_callbacks)
+    {
+      __libdwfl_seterrno (DWFL_E_ATTACH_STATE_CONFLICT);
+      return -1;
+    }
+
+  struct sample_arg *sample = process->callbacks_arg;
+  if (sample->active)
+    {
+      /* Called from the callback of another sample.  */
+      __libdwfl_seterrno (DWFL_E_INVALID_ARGUMENT);
+      return -1;
+    }
+  *sample = (struct sample_arg)
+    {
+      .tid = tid,
+      .pc = pc,
+      .regs = regs,
+      .nregs = nregs,
+      .stack = stack,
+      .stack_size = stack_size,
+      .stack_start = stack_start,
+      .active = true
+    };
+
+  int result = INTUSE(dwfl_getthread_frames) (dwfl, tid, callback, arg);
+
+  /* The caller's buffers are only valid during this call.  */
+  *sample = (struct sample_arg) { .active = false };
+  return result;
+}
@@ -179,6 +179,16 @@ bool EBLHOOK(unwind) (Ebl *ebl, Dwarf_Addr pc, ebl_tid_registers_t *setfunc,
 		      ebl_pid_memory_read_t *readfunc, void *arg,
 		      bool *signal_framep);
 
+/* Get previous frame state for an existing frame state whose PC is a
+   return address, by following the chain of frame pointers.  Arguments
+   as for unwind.  The registers of the existing frame are as CFI leaves
+   them, the registers set in the previous frame must be likewise.  */
+bool EBLHOOK(frame_pointer_unwind) (Ebl *ebl, Dwarf_Addr pc,
+				    ebl_tid_registers_t *setfunc,
+				    ebl_tid_registers_get_t *getfunc,
+				    ebl_pid_memory_read_t *readfunc,
+				    void *arg, bool *signal_framep);
+
 /* Returns true if the value can be resolved to an address in an
    allocated section, which will be returned in *ADDR.
    (e.g. function descriptor resolving)  */
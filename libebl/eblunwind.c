@@ -42,3 +42,18 @@ ebl_unwind (Ebl *ebl, Dwarf_Addr pc, ebl_tid_registers_t *setfunc,
     return false;
   return ebl->unwind (ebl, pc, setfunc, getfunc, readfunc, arg, signal_framep);
 }
+
+bool
+ebl_frame_pointer_unwind (Ebl *ebl, Dwarf_Addr pc,
+			  ebl_tid_registers_t *setfunc,
+			  ebl_tid_registers_get_t *getfunc,
+			  ebl_pid_memory_read_t *readfunc, void *arg,
+			  bool *signal_framep)
+{
+  /* ebl is declared NN */
+  if (ebl->frame_pointer_unwind == NULL)
+    return ebl_unwind (ebl, pc, setfunc, getfunc, readfunc, arg,
+		       signal_framep);
+  return ebl->frame_pointer_unwind (ebl, pc, setfunc, getfunc, readfunc, arg,
+				    signal_framep);
+}
@@ -390,6 +390,19 @@ extern bool ebl_unwind (Ebl *ebl, Dwarf_Addr pc, ebl_tid_registers_t *setfunc,
 			bool *signal_framep)
   __nonnull_attribute__ (1, 3, 4, 5, 7);
 
+/* Get previous frame state for an existing frame state whose PC is a
+   return address, by following the chain of frame pointers.  Arguments
+   as for ebl_unwind.  Unlike ebl_unwind it can be used on a frame
+   unwound with CFI, and the previous frame can be unwound with CFI in
+   turn.  Backends whose unwind already works like that leave it to
+   ebl_unwind.  */
+extern bool ebl_frame_pointer_unwind (Ebl *ebl, Dwarf_Addr pc,
+				      ebl_tid_registers_t *setfunc,
+				      ebl_tid_registers_get_t *getfunc,
+				      ebl_pid_memory_read_t *readfunc,
+				      void *arg, bool *signal_framep)
+  __nonnull_attribute__ (1, 3, 4, 5, 7);
+
 /* Returns true if the value can be resolved to an address in an
    allocated section, which will be returned in *ADDR
    (e.g. function descriptor resolving)  */
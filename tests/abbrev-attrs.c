@@ -0,0 +1,212 @@
+/* Test attribute lookup with shared, pre-decoded abbreviations.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+
+static size_t nattrs;
+static int errors;
+
+/* The attributes of the DIE seen so far, dwarf_attr only finds the
+   first one of a name.  */
+#define MAX_ATTRS 256
+static unsigned int seen[MAX_ATTRS];
+static size_t nseen;
+
+static int
+attr_callback (Dwarf_Attribute *attr, void *arg)
+{
+  Dwarf_Die *die = arg;
+  unsigned int name = dwarf_whatattr (attr);
+  for (size_t i = 0; i < nseen; i++)
+    if (seen[i] == name)
+      return DWARF_CB_OK;
+  if (nseen < MAX_ATTRS)
+    seen[nseen++] = name;
+
+  /* dwarf_getattrs walks the attributes in the abbrev, dwarf_attr uses
+     the decoded ones.  Both must point at the same value.  */
+  Dwarf_Attribute found;
+  if (dwarf_attr (die, name, &found) == NULL)
+    {
+      printf ("DIE %#" PRIx64 ": attribute %#x not found\n",
+	      dwarf_dieoffset (die), name);
+      errors++;
+    }
+  else if (dwarf_whatform (&found) != dwarf_whatform (attr)
+	   || found.valp != attr->valp)
+    {
+      printf ("DIE %#" PRIx64 ": attribute %#x differs\n",
+	      dwarf_dieoffset (die), name);
+      errors++;
+    }
+  else if (! dwarf_hasattr (die, name))
+    {
+      printf ("DIE %#" PRIx64 ": no attribute %#x\n",
+	      dwarf_dieoffset (die), name);
+      errors++;
+    }
+
+  nattrs++;
+  return DWARF_CB_OK;
+}
+
+static void
+check_dies (Dwarf_Die *die)
+{
+  Dwarf_Die cur = *die;
+  do
+    {
+      nseen = 0;
+      if (dwarf_getattrs (&cur, attr_callback, &cur, 0) != 1)
+	{
+	  printf ("DIE %#" PRIx64 ": dwarf_getattrs: %s\n",
+		  dwarf_dieoffset (&cur), dwarf_errmsg (-1));
+	  errors++;
+	}
+
+      Dwarf_Die child;
+      if (dwarf_child (&cur, &child) == 0)
+	check_dies (&child);
+    }
+  while (dwarf_siblingof (&cur, &cur) == 0);
+}
+
+struct unit_abbrev
+{
+  Dwarf_Off abbrev_offset;
+  Dwarf_Half version;
+  uint8_t address_size;
+  uint8_t offset_size;
+  Dwarf_Abbrev *abbrev;
+};
+
+/* Units with the same abbreviations, version and sizes must find the
+   same first abbrev.  Returns true when this is the first such unit.
+   NB: This doesn't know the contributions of units in a package file.  */
+static bool
+check_shared (Dwarf_Die *cudie, struct unit_abbrev **units, size_t *nunits,
+	      Dwarf_Off abbrev_offset, Dwarf_Half version,
+	      uint8_t address_size, uint8_t offset_size)
+{
+  size_t length;
+  Dwarf_Abbrev *abbrev = dwarf_getabbrev (cudie, 0, &length);
+  if (abbrev == NULL)
+    return false;
+
+  for (size_t i = 0; i < *nunits; i++)
+    if ((*units)[i].abbrev_offset == abbrev_offset
+	&& (*units)[i].version == version
+	&& (*units)[i].address_size == address_size
+	&& (*units)[i].offset_size == offset_size)
+      {
+	if ((*units)[i].abbrev != abbrev)
+	  {
+	    printf ("unit %#" PRIx64 ": abbrevs not shared\n",
+		    dwarf_dieoffset (cudie));
+	    errors++;
+	  }
+	return false;
+      }
+
+  *units = realloc (*units, (*nunits + 1) * sizeof (*units)[0]);
+  if (*units == NULL)
+    {
+      puts ("out of memory");
+      exit (1);
+    }
+  (*units)[*nunits] = (struct unit_abbrev)
+    {
+      .abbrev_offset = abbrev_offset,
+      .version = version,
+      .address_size = address_size,
+      .offset_size = offset_size,
+      .abbrev = abbrev
+    };
+  (*nunits)++;
+  return true;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      puts ("usage: abbrev-attrs FILE");
+      return 1;
+    }
+
+  int fd = open (argv[1], O_RDONLY);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[1], dwarf_errmsg (-1));
+      return 1;
+    }
+
+  struct unit_abbrev *units = NULL;
+  size_t nunits = 0;
+  size_t ntables = 0;
+  size_t ncus = 0;
+  for (int types = 0; types < 2; types++)
+    {
+      Dwarf_Off off = 0;
+      Dwarf_Off next;
+      size_t hsize;
+      Dwarf_Half version;
+      Dwarf_Off abbrev_offset;
+      uint8_t address_size;
+      uint8_t offset_size;
+      uint64_t type_signature;
+      Dwarf_Off type_offset;
+      while (dwarf_next_unit (dbg, off, &next, &hsize, &version,
+			      &abbrev_offset, &address_size, &offset_size,
+			      types ? &type_signature : NULL,
+			      types ? &type_offset : NULL) == 0)
+	{
+	  Dwarf_Die cudie;
+	  if ((types ? dwarf_offdie_types (dbg, off + hsize, &cudie)
+	       : dwarf_offdie (dbg, off + hsize, &cudie)) != NULL)
+	    {
+	      ncus++;
+	      if (check_shared (&cudie, &units, &nunits, abbrev_offset,
+				version, address_size, offset_size))
+		ntables++;
+	      check_dies (&cudie);
+	    }
+	  off = next;
+	}
+    }
+
+  printf ("%zu units, %zu abbrev tables, %zu attributes\n",
+	  ncus, ntables, nattrs);
+
+  free (units);
+  dwarf_end (dbg);
+  close (fd);
+
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+/* Test dwarf_cfi_addrframe_cached against dwarf_cfi_addrframe.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+#include ELFUTILS_HEADER(elf)
+#include <gelf.h>
+
+/* Enough for the DWARF registers of all supported architectures that
+   matter for unwinding.  */
+#define NREGS 128
+
+static bool
+same_ops (const Dwarf_Op *ops1, size_t nops1,
+	  const Dwarf_Op *ops2, size_t nops2)
+{
+  if (nops1 != nops2 || (nops1 == 0 && ops1 != ops2))
+    return false;
+  for (size_t i = 0; i < nops1; i++)
+    if (ops1[i].atom != ops2[i].atom
+	|| ops1[i].number != ops2[i].number
+	|| ops1[i].number2 != ops2[i].number2)
+      return false;
+  return true;
+}
+
+/* Compare everything a caller can see of the two frames.  */
+static bool
+same_frame (Dwarf_Frame *frame, Dwarf_Frame *cached)
+{
+  Dwarf_Addr start1, end1, start2, end2;
+  bool signal1, signal2;
+  if (dwarf_frame_info (frame, &start1, &end1, &signal1)
+      != dwarf_frame_info (cached, &start2, &end2, &signal2)
+      || start1 != start2 || end1 != end2 || signal1 != signal2)
+    return false;
+
+  Dwarf_Op *ops1, *ops2;
+  size_t nops1, nops2;
+  int res1 = dwarf_frame_cfa (frame, &ops1, &nops1);
+  int res2 = dwarf_frame_cfa (cached, &ops2, &nops2);
+  if (res1 != res2 || (res1 == 0 && ! same_ops (ops1, nops1, ops2, nops2)))
+    return false;
+
+  for (int regno = 0; regno < NREGS; regno++)
+    {
+      Dwarf_Op mem1[3], mem2[3];
+      res1 = dwarf_frame_register (frame, regno, mem1, &ops1, &nops1);
+      res2 = dwarf_frame_register (cached, regno, mem2, &ops2, &nops2);
+      if (res1 != res2)
+	return false;
+      if (res1 < 0)
+	continue;
+      /* An undefined register has no ops, but points to the caller's
+	 array.  */
+      bool undefined1 = nops1 == 0 && ops1 == mem1;
+      bool undefined2 = nops2 == 0 && ops2 == mem2;
+      if (undefined1 != undefined2
+	  || (! undefined1 && ! same_ops (ops1, nops1, ops2, nops2)))
+	return false;
+    }
+
+  return true;
+}
+
+/* Look up every address of the executable sections, first going up,
+   which fills the cache, then going down, which should mostly find
+   frames from the cache.  Returns the number of errors.  */
+static int
+check_cfi (Elf *elf, Dwarf_CFI *cfi, const char *what, size_t *nframes)
+{
+  int errors = 0;
+  for (int pass = 0; pass < 2; pass++)
+    {
+      Elf_Scn *scn = NULL;
+      while ((scn = elf_nextscn (elf, scn)) != NULL)
+	{
+	  GElf_Shdr shdr_mem;
+	  GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+	  if (shdr == NULL || (shdr->sh_flags & SHF_EXECINSTR) == 0)
+	    continue;
+
+	  for (GElf_Xword i = 0; i < shdr->sh_size; i++)
+	    {
+	      Dwarf_Addr addr = (pass == 0 ? shdr->sh_addr + i
+				 : shdr->sh_addr + shdr->sh_size - 1 - i);
+	      Dwarf_Frame *frame, *cached;
+	      int res = dwarf_cfi_addrframe (cfi, addr, &frame);
+	      if (dwarf_cfi_addrframe_cached (cfi, addr, &cached) != res)
+		{
+		  printf ("%s %#" PRIx64 ": results differ\n", what, addr);
+		  errors++;
+		}
+	      else if (res == 0)
+		{
+		  if (! same_frame (frame, cached))
+		    {
+		      printf ("%s %#" PRIx64 ": frames differ\n", what, addr);
+		      errors++;
+		    }
+
+		  /* Asking again must not compute a new frame.  */
+		  Dwarf_Frame *again;
+		  if (dwarf_cfi_addrframe_cached (cfi, addr, &again) != 0
+		      || again != cached)
+		    {
+		      printf ("%s %#" PRIx64 ": not cached\n", what, addr);
+		      errors++;
+		    }
+		  if (pass == 0)
+		    (*nframes)++;
+		}
+	      if (res == 0)
+		free (frame);
+	    }
+	}
+    }
+  return errors;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      puts ("usage: cfi-addrframe-cached FILE");
+      return 1;
+    }
+
+  elf_version (EV_CURRENT);
+  int fd = open (argv[1], O_RDONLY);
+  Elf *elf = elf_begin (fd, ELF_C_READ, NULL);
+  if (elf == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[1], elf_errmsg (-1));
+      return 1;
+    }
+
+  int errors = 0;
+  size_t eh_frames = 0, debug_frames = 0;
+  Dwarf_CFI *eh_cfi = dwarf_getcfi_elf (elf);
+  if (eh_cfi != NULL)
+    {
+      errors += check_cfi (elf, eh_cfi, ".eh_frame", &eh_frames);
+      dwarf_cfi_end (eh_cfi);
+    }
+
+  Dwarf *dbg = dwarf_begin_elf (elf, DWARF_C_READ, NULL);
+  if (dbg != NULL)
+    {
+      Dwarf_CFI *cfi = dwarf_getcfi (dbg);
+      if (cfi != NULL)
+	errors += check_cfi (elf, cfi, ".debug_frame", &debug_frames);
+      dwarf_end (dbg);
+    }
+
+  printf (".eh_frame: %zu addresses, .debug_frame: %zu addresses\n",
+	  eh_frames, debug_frames);
+
+  elf_end (elf);
+  close (fd);
+
+  return errors == 0 ? 0 : 1;
+}
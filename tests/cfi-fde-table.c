@@ -0,0 +1,200 @@
+/* Test looking up FDEs in .debug_frame, which has no search table.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+#include ELFUTILS_HEADER(elf)
+#include <gelf.h>
+
+struct fde_range
+{
+  Dwarf_Addr start;
+  Dwarf_Addr end;
+};
+
+static struct fde_range *fdes;
+static size_t nfdes;
+
+/* FDEs that overlap one before them in the section.  */
+static size_t noverlapping;
+
+static Dwarf_Addr
+read_addr (const unsigned char *p, size_t size, bool msb)
+{
+  Dwarf_Addr addr = 0;
+  for (size_t i = 0; i < size; i++)
+    addr |= (Dwarf_Addr) p[msb ? i : size - 1 - i] << (8 * (size - 1 - i));
+  return addr;
+}
+
+/* Read the ranges of all FDEs in section order.  In .debug_frame the
+   initial location and address range are plain addresses.  Like when
+   libdw reads them one by one, those overlapping an earlier one are
+   ignored.  */
+static void
+read_fdes (Elf *elf, Elf_Data *data)
+{
+  const unsigned char *e_ident = (const unsigned char *) elf_getident (elf,
+								      NULL);
+  size_t address_size = e_ident[EI_CLASS] == ELFCLASS32 ? 4 : 8;
+  bool msb = e_ident[EI_DATA] == ELFDATA2MSB;
+
+  Dwarf_Off offset = 0;
+  Dwarf_Off next_offset;
+  Dwarf_CFI_Entry entry;
+  int res;
+  while ((res = dwarf_next_cfi (e_ident, data, false, offset,
+				&next_offset, &entry)) <= 0)
+    {
+      if (res == 0 && ! dwarf_cfi_cie_p (&entry)
+	  && entry.fde.start + 2 * address_size <= entry.fde.end)
+	{
+	  Dwarf_Addr start = read_addr (entry.fde.start, address_size, msb);
+	  Dwarf_Addr end = start + read_addr (entry.fde.start + address_size,
+					      address_size, msb);
+	  size_t i;
+	  for (i = 0; i < nfdes; i++)
+	    if (start < fdes[i].end && fdes[i].start < end)
+	      break;
+	  if (i < nfdes)
+	    noverlapping++;
+	  else
+	    {
+	      fdes = realloc (fdes, (nfdes + 1) * sizeof fdes[0]);
+	      if (fdes == NULL)
+		{
+		  puts ("out of memory");
+		  exit (1);
+		}
+	      fdes[nfdes].start = start;
+	      fdes[nfdes].end = end;
+	      nfdes++;
+	    }
+	}
+      if (next_offset == offset)
+	break;
+      offset = next_offset;
+    }
+}
+
+/* The first FDE in the section that covers ADDR, if any.  */
+static const struct fde_range *
+expected_fde (Dwarf_Addr addr)
+{
+  for (size_t i = 0; i < nfdes; i++)
+    if (fdes[i].start <= addr && addr < fdes[i].end)
+      return &fdes[i];
+  return NULL;
+}
+
+static int
+check_addr (Dwarf_CFI *cfi, Dwarf_Addr addr)
+{
+  const struct fde_range *fde = expected_fde (addr);
+  Dwarf_Frame *frame;
+  if (dwarf_cfi_addrframe (cfi, addr, &frame) != 0)
+    {
+      if (fde == NULL)
+	return 0;
+      printf ("%#" PRIx64 ": no frame: %s\n", addr, dwarf_errmsg (-1));
+      return 1;
+    }
+
+  Dwarf_Addr start, end;
+  dwarf_frame_info (frame, &start, &end, NULL);
+  free (frame);
+  if (fde == NULL)
+    {
+      printf ("%#" PRIx64 ": unexpected frame [%#" PRIx64 ", %#" PRIx64 ")\n",
+	      addr, start, end);
+      return 1;
+    }
+  if (start < fde->start || end > fde->end)
+    {
+      printf ("%#" PRIx64 ": frame [%#" PRIx64 ", %#" PRIx64 ") not in FDE"
+	      " [%#" PRIx64 ", %#" PRIx64 ")\n",
+	      addr, start, end, fde->start, fde->end);
+      return 1;
+    }
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      puts ("usage: cfi-fde-table FILE");
+      return 1;
+    }
+
+  elf_version (EV_CURRENT);
+  int fd = open (argv[1], O_RDONLY);
+  Elf *elf = elf_begin (fd, ELF_C_READ, NULL);
+  Dwarf *dbg = dwarf_begin_elf (elf, DWARF_C_READ, NULL);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[1], dwarf_errmsg (-1));
+      return 1;
+    }
+
+  size_t shstrndx;
+  elf_getshdrstrndx (elf, &shstrndx);
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      const char *name = elf_strptr (elf, shstrndx, shdr->sh_name);
+      if (name != NULL && strcmp (name, ".debug_frame") == 0)
+	read_fdes (elf, elf_getdata (scn, NULL));
+    }
+
+  /* The first, middle and last address of every FDE, and the ones
+     just outside.  */
+  Dwarf_CFI *cfi = dwarf_getcfi (dbg);
+  int errors = 0;
+  for (size_t i = 0; i < nfdes; i++)
+    {
+      errors += check_addr (cfi, fdes[i].start - 1);
+      errors += check_addr (cfi, fdes[i].start);
+      errors += check_addr (cfi, fdes[i].start
+			    + (fdes[i].end - fdes[i].start) / 2);
+      errors += check_addr (cfi, fdes[i].end - 1);
+      errors += check_addr (cfi, fdes[i].end);
+    }
+
+  printf ("%zu FDEs\n", nfdes);
+  if (noverlapping > 0)
+    printf ("%zu overlapping FDEs\n", noverlapping);
+
+  free (fdes);
+  dwarf_end (dbg);
+  elf_end (elf);
+  close (fd);
+
+  return errors == 0 ? 0 : 1;
+}
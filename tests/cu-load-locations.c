@@ -0,0 +1,254 @@
+/* Test dwarf_cu_load_locations against locations decoded on demand.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+
+static size_t nexprs;
+static int errors;
+
+static int
+load_callback (Dwarf_CU *cu, Dwarf_Die *cudie __attribute__ ((unused)),
+	       void *arg __attribute__ ((unused)))
+{
+  if (dwarf_cu_load_locations (cu) != 0)
+    {
+      printf ("dwarf_cu_load_locations: %s\n", dwarf_errmsg (-1));
+      return DWARF_CB_ABORT;
+    }
+  return DWARF_CB_OK;
+}
+
+/* Some operations point to their operands in the section data, which
+   is mapped at a different address for each Dwarf.  */
+static bool
+same_op (Dwarf_Attribute *attr, Dwarf_Op *op,
+	 Dwarf_Attribute *fresh_attr, Dwarf_Op *fresh_op)
+{
+  if (op->atom != fresh_op->atom || op->number != fresh_op->number
+      || op->offset != fresh_op->offset)
+    return false;
+
+  const unsigned char *data = (const unsigned char *) (uintptr_t) op->number2;
+  const unsigned char *fresh_data
+    = (const unsigned char *) (uintptr_t) fresh_op->number2;
+  switch (op->atom)
+    {
+    case DW_OP_implicit_value:
+      {
+	Dwarf_Block block, fresh_block;
+	return (dwarf_getlocation_implicit_value (attr, op, &block) == 0
+		&& dwarf_getlocation_implicit_value (fresh_attr, fresh_op,
+						     &fresh_block) == 0
+		&& block.length == fresh_block.length
+		&& memcmp (block.data, fresh_block.data, block.length) == 0);
+      }
+
+    case DW_OP_entry_value:
+    case DW_OP_GNU_entry_value:
+      return memcmp (data, fresh_data, op->number) == 0;
+
+    case DW_OP_const_type:
+    case DW_OP_GNU_const_type:
+      return data[0] == fresh_data[0]
+	     && memcmp (data, fresh_data, data[0] + 1) == 0;
+
+    default:
+      return op->number2 == fresh_op->number2;
+    }
+}
+
+/* Compare all locations of ATTR, from the Dwarf that loaded all
+   locations up front, with those of FRESH_ATTR, from the Dwarf that
+   decodes them when asked.  */
+static void
+compare_locations (Dwarf_Attribute *attr, Dwarf_Attribute *fresh_attr)
+{
+  ptrdiff_t off = 0;
+  ptrdiff_t fresh_off = 0;
+  do
+    {
+      Dwarf_Addr base, start, end;
+      Dwarf_Op *expr;
+      size_t len;
+      off = dwarf_getlocations (attr, off, &base, &start, &end, &expr, &len);
+
+      Dwarf_Addr fresh_base, fresh_start, fresh_end;
+      Dwarf_Op *fresh_expr;
+      size_t fresh_len;
+      fresh_off = dwarf_getlocations (fresh_attr, fresh_off, &fresh_base,
+				      &fresh_start, &fresh_end,
+				      &fresh_expr, &fresh_len);
+
+      if (off != fresh_off)
+	{
+	  printf ("attribute %#x: got %td, expected %td\n",
+		  dwarf_whatattr (attr), off, fresh_off);
+	  errors++;
+	  return;
+	}
+      if (off <= 0)
+	return;
+
+      nexprs++;
+      if (start != fresh_start || end != fresh_end || len != fresh_len)
+	{
+	  printf ("attribute %#x: got [%#" PRIx64 ", %#" PRIx64 ") %zu ops,"
+		  " expected [%#" PRIx64 ", %#" PRIx64 ") %zu ops\n",
+		  dwarf_whatattr (attr), start, end, len,
+		  fresh_start, fresh_end, fresh_len);
+	  errors++;
+	  return;
+	}
+
+      for (size_t i = 0; i < len; i++)
+	if (! same_op (attr, &expr[i], fresh_attr, &fresh_expr[i]))
+	  {
+	    printf ("attribute %#x: op %zu differs\n",
+		    dwarf_whatattr (attr), i);
+	    errors++;
+	    return;
+	  }
+    }
+  while (off > 0);
+}
+
+static int
+attr_callback (Dwarf_Attribute *attr, void *arg)
+{
+  Dwarf_Die *fresh_die = arg;
+  Dwarf_Attribute fresh_attr;
+  if (dwarf_attr (fresh_die, dwarf_whatattr (attr), &fresh_attr) == NULL)
+    {
+      printf ("DIE %#" PRIx64 ": attribute %#x missing\n",
+	      dwarf_dieoffset (fresh_die), dwarf_whatattr (attr));
+      errors++;
+      return DWARF_CB_ABORT;
+    }
+
+  compare_locations (attr, &fresh_attr);
+
+  /* Asking again must give the very same expression.  */
+  Dwarf_Op *expr1, *expr2;
+  size_t len1, len2;
+  if (dwarf_getlocation (attr, &expr1, &len1) == 0
+      && (dwarf_getlocation (attr, &expr2, &len2) != 0
+	  || expr1 != expr2 || len1 != len2))
+    {
+      printf ("DIE %#" PRIx64 ": attribute %#x not cached\n",
+	      dwarf_dieoffset (fresh_die), dwarf_whatattr (attr));
+      errors++;
+    }
+
+  return DWARF_CB_OK;
+}
+
+static void
+compare_dies (Dwarf_Die *die, Dwarf_Die *fresh_die)
+{
+  Dwarf_Die cur = *die;
+  Dwarf_Die fresh_cur = *fresh_die;
+  int res, fresh_res;
+  do
+    {
+      dwarf_getattrs (&cur, attr_callback, &fresh_cur, 0);
+
+      Dwarf_Die child, fresh_child;
+      res = dwarf_child (&cur, &child);
+      fresh_res = dwarf_child (&fresh_cur, &fresh_child);
+      if (res != fresh_res)
+	{
+	  printf ("DIE %#" PRIx64 ": children differ\n", dwarf_dieoffset (&cur));
+	  errors++;
+	  return;
+	}
+      if (res == 0)
+	compare_dies (&child, &fresh_child);
+
+      res = dwarf_siblingof (&cur, &cur);
+      fresh_res = dwarf_siblingof (&fresh_cur, &fresh_cur);
+    }
+  while (res == 0 && fresh_res == 0);
+
+  if (res != fresh_res)
+    {
+      printf ("DIE %#" PRIx64 ": siblings differ\n", dwarf_dieoffset (&cur));
+      errors++;
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 3)
+    {
+      puts ("usage: cu-load-locations NTHREADS FILE");
+      return 1;
+    }
+
+  unsigned int nthreads = atoi (argv[1]);
+  int fd = open (argv[2], O_RDONLY);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  Dwarf *fresh_dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL || fresh_dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[2], dwarf_errmsg (-1));
+      return 1;
+    }
+
+  /* The second time around everything is already there.  */
+  for (int round = 0; round < 2; round++)
+    if (dwarf_parallel_units (dbg, nthreads, load_callback, NULL) != 0)
+      {
+	printf ("dwarf_parallel_units: %s\n", dwarf_errmsg (-1));
+	return 1;
+      }
+
+  Dwarf_CU *cu = NULL;
+  Dwarf_CU *fresh_cu = NULL;
+  Dwarf_Die cudie, fresh_cudie, subdie, fresh_subdie;
+  uint8_t unit_type;
+  while (dwarf_get_units (dbg, cu, &cu, NULL, &unit_type,
+			  &cudie, &subdie) == 0
+	 && dwarf_get_units (fresh_dbg, fresh_cu, &fresh_cu, NULL, NULL,
+			     &fresh_cudie, &fresh_subdie) == 0)
+    {
+      compare_dies (&cudie, &fresh_cudie);
+      if (unit_type == DW_UT_skeleton
+	  && dwarf_tag (&subdie) != DW_TAG_invalid
+	  && dwarf_tag (&fresh_subdie) != DW_TAG_invalid)
+	compare_dies (&subdie, &fresh_subdie);
+    }
+
+  printf ("%zu location expressions\n", nexprs);
+
+  dwarf_end (fresh_dbg);
+  dwarf_end (dbg);
+  close (fd);
+
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+/* Test program for dwarf_getnames.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <libelf.h>
+#include ELFUTILS_HEADER(dw)
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static int
+callback (Dwarf *dbg, Dwarf_Global *gl, unsigned int tag, void *arg)
+{
+  int *result = arg;
+
+  printf (" \"%s\", tag: 0x%x, die: %llu, cu: %llu\n",
+	  gl->name, tag, (unsigned long long int) gl->die_offset,
+	  (unsigned long long int) gl->cu_offset);
+
+  Dwarf_Die cu_die;
+  const char *cuname;
+  if (dwarf_offdie (dbg, gl->cu_offset, &cu_die) == NULL
+      || (cuname = dwarf_diename (&cu_die)) == NULL)
+    {
+      puts ("failed to get CU die");
+      *result = 1;
+      return DWARF_CB_ABORT;
+    }
+
+  /* The index entry has to match the DIE it points to.  */
+  Dwarf_Die die;
+  const char *diename;
+  if (dwarf_offdie (dbg, gl->die_offset, &die) == NULL
+      || (diename = dwarf_diename (&die)) == NULL)
+    {
+      puts ("failed to get object die");
+      *result = 1;
+      return DWARF_CB_ABORT;
+    }
+  if (strcmp (diename, gl->name) != 0 || (unsigned int) dwarf_tag (&die) != tag)
+    {
+      printf ("index entry doesn't match die \"%s\", tag 0x%x\n",
+	      diename, dwarf_tag (&die));
+      *result = 1;
+    }
+
+  printf ("CU name: \"%s\"\n", cuname);
+  return DWARF_CB_OK;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  int result = 0;
+
+  if (argc < 2)
+    {
+      puts ("usage: debug-names FILE [NAME...]");
+      return 1;
+    }
+
+  int fd = open (argv[1], O_RDONLY);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[1], dwarf_errmsg (-1));
+      close (fd);
+      return 1;
+    }
+
+  /* Without names list the whole index, otherwise look up each name.  */
+  if (argc == 2)
+    {
+      if (dwarf_getnames (dbg, NULL, callback, &result) != 0)
+	{
+	  printf ("dwarf_getnames didn't return zero: %s\n",
+		  dwarf_errmsg (-1));
+	  result = 1;
+	}
+    }
+  else
+    for (int cnt = 2; cnt < argc; ++cnt)
+      {
+	printf ("%s:\n", argv[cnt]);
+	if (dwarf_getnames (dbg, argv[cnt], callback, &result) != 0)
+	  {
+	    printf ("dwarf_getnames didn't return zero: %s\n",
+		    dwarf_errmsg (-1));
+	    result = 1;
+	  }
+      }
+
+  dwarf_end (dbg);
+  close (fd);
+
+  return result;
+}
@@ -28,6 +28,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include "system.h"
+#include "libeu.h"
 
 int
 main (int argc, char *argv[])
@@ -54,7 +55,21 @@ main (int argc, char *argv[])
       if (debug == NULL)
 	printf ("%s: <no gnu_debuglink file>\n", file);
       else
-	printf ("%s: %s, crc: %" PRIx32 "\n", file, debug, crc);
+	{
+	  printf ("%s: %s, crc: %" PRIx32, file, debug, crc);
+
+	  /* If the debug file is around, check its CRC.  */
+	  int debug_fd = open (debug, O_RDONLY);
+	  if (debug_fd >= 0)
+	    {
+	      uint32_t file_crc;
+	      if (crc32_file (debug_fd, &file_crc) != 0)
+		error (EXIT_FAILURE, errno, "couldn't read '%s'", debug);
+	      printf (", %s", file_crc == crc ? "matches" : "differs");
+	      close (debug_fd);
+	    }
+	  printf ("\n");
+	}
 
       elf_end (elf);
       close (fd);
@@ -0,0 +1,232 @@
+/* Test walking DIE trees with a Dwarf_Die_Cursor.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+
+/* One step of a walk.  */
+struct visit
+{
+  Dwarf_Off offset;
+  unsigned int depth;
+  int order;
+};
+
+static struct visit *visits;
+static size_t nvisits;
+static size_t visits_size;
+static int errors;
+
+static void
+add_visit (Dwarf_Off offset, unsigned int depth, int order)
+{
+  if (nvisits == visits_size)
+    {
+      visits_size = visits_size == 0 ? 1024 : 2 * visits_size;
+      visits = realloc (visits, visits_size * sizeof visits[0]);
+      if (visits == NULL)
+	{
+	  puts ("out of memory");
+	  exit (1);
+	}
+    }
+  visits[nvisits++] = (struct visit) { offset, depth, order };
+}
+
+/* The walk the cursor should do, with recursion.  */
+static void
+walk (Dwarf_Die *die, unsigned int depth, bool postorder)
+{
+  add_visit (dwarf_dieoffset (die), depth, DWARF_DIE_CURSOR_PRE);
+  Dwarf_Die child;
+  if (dwarf_child (die, &child) == 0)
+    do
+      walk (&child, depth + 1, postorder);
+    while (dwarf_siblingof (&child, &child) == 0);
+  if (postorder)
+    add_visit (dwarf_dieoffset (die), depth, DWARF_DIE_CURSOR_POST);
+}
+
+/* Compare the rest of the walk of CURSOR with the visits from FIRST.  */
+static void
+compare_walk (Dwarf_Die_Cursor *cursor, size_t first, const char *what)
+{
+  Dwarf_Die die;
+  unsigned int depth;
+  int order;
+  size_t i = first;
+  int res;
+  while ((res = dwarf_die_cursor_next (cursor, &die, &depth, &order)) == 0)
+    {
+      if (i >= nvisits
+	  || visits[i].offset != dwarf_dieoffset (&die)
+	  || visits[i].depth != depth || visits[i].order != order)
+	{
+	  printf ("%s: step %zu differs at DIE %#" PRIx64 "\n",
+		  what, i, dwarf_dieoffset (&die));
+	  errors++;
+	  return;
+	}
+      i++;
+    }
+
+  if (res < 0 || i != nvisits)
+    {
+      printf ("%s: walk ended after %zu of %zu steps: %s\n",
+	      what, i, nvisits, res < 0 ? dwarf_errmsg (-1) : "no error");
+      errors++;
+    }
+}
+
+/* Skip the children of all DIEs right below DIE, which must give
+   the same DIEs as going over its children with dwarf_siblingof.  */
+static void
+check_skip (Dwarf_Die *die)
+{
+  size_t expected = 0;
+  Dwarf_Die child;
+  if (dwarf_child (die, &child) == 0)
+    do
+      expected++;
+    while (dwarf_siblingof (&child, &child) == 0);
+
+  Dwarf_Die_Cursor *cursor = dwarf_die_cursor_begin (die, false);
+  size_t found = 0;
+  unsigned int depth;
+  while (dwarf_die_cursor_next (cursor, &child, &depth, NULL) == 0)
+    if (depth == 1)
+      {
+	found++;
+	if (dwarf_die_cursor_skip (cursor) != 0)
+	  {
+	    printf ("dwarf_die_cursor_skip: %s\n", dwarf_errmsg (-1));
+	    errors++;
+	  }
+      }
+    else if (depth > 1)
+      {
+	printf ("DIE %#" PRIx64 " not skipped\n", dwarf_dieoffset (&child));
+	errors++;
+	break;
+      }
+  dwarf_die_cursor_end (cursor);
+
+  if (found != expected)
+    {
+      printf ("skipping found %zu children, expected %zu\n", found, expected);
+      errors++;
+    }
+}
+
+/* Stop the walk at a few positions, and resume it from there with a
+   new cursor.  */
+static void
+check_resume (Dwarf_Die *die, bool postorder)
+{
+  Dwarf_Die_Cursor *cursor = dwarf_die_cursor_begin (die, postorder);
+  Dwarf_Die cur;
+  size_t step = nvisits / 7 + 1;
+  for (size_t i = 0; i < nvisits; i++)
+    {
+      int order;
+      if (dwarf_die_cursor_next (cursor, &cur, NULL, &order) != 0)
+	break;
+      if (i % step != 0)
+	continue;
+
+      Dwarf_Off offsets[64];
+      size_t n = dwarf_die_cursor_position (cursor, offsets, 64);
+      if (n == 0 || n > 64)
+	continue;
+
+      Dwarf_Die_Cursor *resumed = dwarf_die_cursor_begin (die, postorder);
+      if (dwarf_die_cursor_resume (resumed, offsets, n, order) != 0)
+	{
+	  printf ("dwarf_die_cursor_resume: %s\n", dwarf_errmsg (-1));
+	  errors++;
+	}
+      else
+	compare_walk (resumed, i + 1, "resumed");
+      dwarf_die_cursor_end (resumed);
+    }
+  dwarf_die_cursor_end (cursor);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      puts ("usage: die-cursor FILE");
+      return 1;
+    }
+
+  int fd = open (argv[1], O_RDONLY);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[1], dwarf_errmsg (-1));
+      return 1;
+    }
+
+  size_t ndies = 0;
+  unsigned int max_depth = 0;
+  Dwarf_CU *cu = NULL;
+  Dwarf_Die cudie;
+  while (dwarf_get_units (dbg, cu, &cu, NULL, NULL, &cudie, NULL) == 0)
+    for (int postorder = 0; postorder < 2; postorder++)
+      {
+	nvisits = 0;
+	walk (&cudie, 0, postorder);
+
+	Dwarf_Die_Cursor *cursor = dwarf_die_cursor_begin (&cudie, postorder);
+	if (cursor == NULL)
+	  {
+	    printf ("dwarf_die_cursor_begin: %s\n", dwarf_errmsg (-1));
+	    return 1;
+	  }
+	compare_walk (cursor, 0, postorder ? "postorder" : "preorder");
+	dwarf_die_cursor_end (cursor);
+
+	check_resume (&cudie, postorder);
+
+	if (! postorder)
+	  {
+	    check_skip (&cudie);
+	    ndies += nvisits;
+	    for (size_t i = 0; i < nvisits; i++)
+	      if (visits[i].depth > max_depth)
+		max_depth = visits[i].depth;
+	  }
+      }
+
+  printf ("%zu DIEs, depth %u\n", ndies, max_depth);
+
+  free (visits);
+  dwarf_end (dbg);
+  close (fd);
+
+  return errors == 0 ? 0 : 1;
+}
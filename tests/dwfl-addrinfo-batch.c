@@ -0,0 +1,139 @@
+/* Test program for dwfl_module_addrinfo_batch.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include ELFUTILS_HEADER(dwfl)
+#include "system.h"
+
+static const Dwfl_Callbacks offline_callbacks =
+  {
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+    .section_address = dwfl_offline_section_address,
+  };
+
+static int
+compare_addr (const void *a, const void *b)
+{
+  GElf_Addr a1 = *(const GElf_Addr *) a;
+  GElf_Addr a2 = *(const GElf_Addr *) b;
+  return a1 < a2 ? -1 : a1 > a2;
+}
+
+/* Compare the batch results for ADDRS against one at a time lookups.  */
+static int
+check (Dwfl_Module *mod, size_t n, GElf_Addr *addrs)
+{
+  const char **names = malloc (n * sizeof names[0]);
+  GElf_Off *offsets = malloc (n * sizeof offsets[0]);
+  Dwfl_Line **lines = malloc (n * sizeof lines[0]);
+  if (names == NULL || offsets == NULL || lines == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+
+  ptrdiff_t found = dwfl_module_addrinfo_batch (mod, n, addrs, names,
+						offsets, lines);
+  if (found < 0)
+    error (EXIT_FAILURE, 0, "dwfl_module_addrinfo_batch: %s",
+	   dwfl_errmsg (-1));
+
+  int errors = 0;
+  ptrdiff_t expected = 0;
+  for (size_t i = 0; i < n; ++i)
+    {
+      GElf_Off off;
+      GElf_Sym sym;
+      const char *name = dwfl_module_addrinfo (mod, addrs[i], &off, &sym,
+					       NULL, NULL, NULL);
+      Dwfl_Line *line = dwfl_module_getsrc (mod, addrs[i]);
+      if (name != NULL)
+	++expected;
+      if (name != names[i]
+	  || (name != NULL && off != offsets[i])
+	  || line != lines[i])
+	{
+	  printf ("%#" PRIx64 ": batch %s+%#" PRIx64 " %p, "
+		  "single %s+%#" PRIx64 " %p\n",
+		  addrs[i], names[i] ?: "??", offsets[i], lines[i],
+		  name ?: "??", name != NULL ? off : 0, line);
+	  ++errors;
+	}
+    }
+  if (found != expected)
+    {
+      printf ("batch found %td, expected %td\n", found, expected);
+      ++errors;
+    }
+
+  free (names);
+  free (offsets);
+  free (lines);
+  return errors;
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc != 2)
+    error (EXIT_FAILURE, 0, "usage: %s FILE", argv[0]);
+
+  Dwfl *dwfl = dwfl_begin (&offline_callbacks);
+  if (dwfl == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  Dwfl_Module *mod = dwfl_report_offline (dwfl, argv[1], argv[1], -1);
+  if (mod == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_report_offline: %s", dwfl_errmsg (-1));
+  dwfl_report_end (dwfl, NULL, NULL);
+
+  int syms = dwfl_module_getsymtab (mod);
+  if (syms < 0)
+    syms = 0;
+
+  /* Each symbol start, middle, end and just below it, plus some
+     addresses spread over the module.  */
+  GElf_Addr low, high;
+  dwfl_module_info (mod, NULL, &low, &high, NULL, NULL, NULL, NULL);
+  size_t max = 4 * (size_t) syms + 1024;
+  GElf_Addr *addrs = malloc (max * sizeof addrs[0]);
+  if (addrs == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+  size_t n = 0;
+  for (int i = 0; i < syms; ++i)
+    {
+      GElf_Sym sym;
+      GElf_Addr value;
+      if (dwfl_module_getsym_info (mod, i, &sym, &value,
+				   NULL, NULL, NULL) == NULL)
+	continue;
+      addrs[n++] = value - 1;
+      addrs[n++] = value;
+      addrs[n++] = value + sym.st_size / 2;
+      addrs[n++] = value + sym.st_size;
+    }
+  for (size_t i = 0; i < 1024; ++i)
+    addrs[n++] = low + (high - low) / 1024 * i;
+
+  /* Once in symbol table order, once sorted.  */
+  int errors = check (mod, n, addrs);
+  qsort (addrs, n, sizeof addrs[0], compare_addr);
+  errors += check (mod, n, addrs);
+
+  free (addrs);
+  dwfl_end (dwfl);
+  return errors == 0 ? 0 : 1;
+}
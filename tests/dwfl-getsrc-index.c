@@ -0,0 +1,108 @@
+/* Test dwfl_module_getsrc with the module-wide line index.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include ELFUTILS_HEADER(dw)
+#include ELFUTILS_HEADER(dwfl)
+#include "system.h"
+
+static const Dwfl_Callbacks offline_callbacks =
+  {
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+    .section_address = dwfl_offline_section_address,
+  };
+
+/* Look up ADDR with dwfl_module_getsrc, which uses its line index
+   after the first few lookups, and in the lines of the CU for ADDR,
+   which is what dwfl_module_getsrc did before.  */
+static int
+check_addr (Dwfl_Module *mod, Dwarf_Addr addr)
+{
+  Dwarf_Line *expected = NULL;
+  Dwarf_Addr bias;
+  Dwarf_Die *cudie = dwfl_module_addrdie (mod, addr, &bias);
+  if (cudie != NULL)
+    expected = dwarf_getsrc_die (cudie, addr - bias);
+
+  Dwarf_Line *found = NULL;
+  Dwfl_Line *line = dwfl_module_getsrc (mod, addr);
+  if (line != NULL)
+    {
+      Dwarf_Addr line_bias;
+      found = dwfl_dwarf_line (line, &line_bias);
+    }
+
+  if (found != expected)
+    {
+      printf ("%#" PRIx64 ": got %p, expected %p\n", addr, found, expected);
+      return 1;
+    }
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc != 2)
+    error (EXIT_FAILURE, 0, "usage: %s FILE", argv[0]);
+
+  Dwfl *dwfl = dwfl_begin (&offline_callbacks);
+  if (dwfl == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  Dwfl_Module *mod = dwfl_report_offline (dwfl, argv[1], argv[1], -1);
+  if (mod == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_report_offline: %s", dwfl_errmsg (-1));
+  dwfl_report_end (dwfl, NULL, NULL);
+
+  Dwarf_Addr bias;
+  if (dwfl_module_getdwarf (mod, &bias) == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_module_getdwarf: %s", dwfl_errmsg (-1));
+
+  /* Every line address, the one before it and the one after it, and
+     some addresses spread over the module, which might not be in any
+     CU at all.  */
+  int errors = 0;
+  Dwarf_Die *cudie = NULL;
+  Dwarf_Addr cubias;
+  while ((cudie = dwfl_module_nextcu (mod, cudie, &cubias)) != NULL)
+    {
+      Dwarf_Lines *lines;
+      size_t nlines;
+      if (dwarf_getsrclines (cudie, &lines, &nlines) != 0)
+	continue;
+
+      for (size_t i = 0; i < nlines; ++i)
+	{
+	  Dwarf_Addr addr;
+	  dwarf_lineaddr (dwarf_onesrcline (lines, i), &addr);
+	  addr += bias;
+	  errors += check_addr (mod, addr - 1);
+	  errors += check_addr (mod, addr);
+	  errors += check_addr (mod, addr + 1);
+	}
+    }
+
+  GElf_Addr low, high;
+  dwfl_module_info (mod, NULL, &low, &high, NULL, NULL, NULL, NULL);
+  for (size_t i = 0; i < 1024; ++i)
+    errors += check_addr (mod, low + (high - low) / 1024 * i);
+
+  dwfl_end (dwfl);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+/* Test dwfl_set_frame_pointer_unwind against unwinding with CFI.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dwfl)
+
+#define MAX_FRAMES 64
+#define MAX_THREADS 16
+
+struct frames
+{
+  pid_t tid;
+  Dwarf_Addr pcs[MAX_FRAMES];
+  size_t npcs;
+};
+
+static struct frames threads[2][MAX_THREADS];
+static size_t nthreads[2];
+
+static int
+frame_callback (Dwfl_Frame *state, void *arg)
+{
+  struct frames *frames = arg;
+  Dwarf_Addr pc;
+  if (! dwfl_frame_pc (state, &pc, NULL) || frames->npcs == MAX_FRAMES)
+    return DWARF_CB_ABORT;
+  frames->pcs[frames->npcs++] = pc;
+  return DWARF_CB_OK;
+}
+
+static int
+thread_callback (Dwfl_Thread *thread, void *arg)
+{
+  int fp = *(int *) arg;
+  if (nthreads[fp] == MAX_THREADS)
+    return DWARF_CB_ABORT;
+  struct frames *frames = &threads[fp][nthreads[fp]++];
+  frames->tid = dwfl_thread_tid (thread);
+  frames->npcs = 0;
+  /* Like backtrace, not all threads end their unwind cleanly.  */
+  dwfl_thread_getframes (thread, frame_callback, frames);
+  return DWARF_CB_OK;
+}
+
+static const Dwfl_Callbacks callbacks =
+  {
+    .find_elf = dwfl_build_id_find_elf,
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+  };
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 3)
+    {
+      puts ("usage: frame-pointer-unwind EXECUTABLE CORE");
+      return 1;
+    }
+
+  elf_version (EV_CURRENT);
+  int fd = open (argv[2], O_RDONLY);
+  Elf *core = elf_begin (fd, ELF_C_READ_MMAP, NULL);
+  Dwfl *dwfl = dwfl_begin (&callbacks);
+  if (core == NULL || dwfl == NULL
+      || dwfl_core_file_report (dwfl, core, argv[1]) < 0
+      || dwfl_report_end (dwfl, NULL, NULL) != 0
+      || dwfl_core_file_attach (dwfl, core) < 0)
+    {
+      printf ("cannot attach to %s: %s\n", argv[2], dwfl_errmsg (-1));
+      return 1;
+    }
+
+  /* First with CFI, then with frame pointers.  */
+  for (int fp = 0; fp < 2; fp++)
+    {
+      if (! dwfl_set_frame_pointer_unwind (dwfl, fp))
+	{
+	  printf ("dwfl_set_frame_pointer_unwind: %s\n", dwfl_errmsg (-1));
+	  return 1;
+	}
+      if (dwfl_getthreads (dwfl, thread_callback, &fp) != 0)
+	{
+	  printf ("dwfl_getthreads: %s\n", dwfl_errmsg (-1));
+	  return 1;
+	}
+    }
+
+  /* The code keeps frame pointers, so both must find the same frames.
+     Following them may go on where there is no CFI, like into clone.  */
+  int errors = 0;
+  if (nthreads[0] != nthreads[1])
+    {
+      printf ("%zu threads with CFI, %zu with frame pointers\n",
+	      nthreads[0], nthreads[1]);
+      errors++;
+    }
+  for (size_t i = 0; i < nthreads[0] && i < nthreads[1]; i++)
+    {
+      struct frames *cfi = &threads[0][i];
+      struct frames *fp = &threads[1][i];
+      printf ("tid %d: %zu frames\n", cfi->tid, cfi->npcs);
+      if (fp->tid != cfi->tid || fp->npcs < cfi->npcs
+	  || memcmp (fp->pcs, cfi->pcs, cfi->npcs * sizeof cfi->pcs[0]) != 0)
+	{
+	  printf ("tid %d: %zu frames with frame pointers\n",
+		  fp->tid, fp->npcs);
+	  for (size_t j = 0; j < fp->npcs; j++)
+	    printf ("  %#" PRIx64 "\n", fp->pcs[j]);
+	  errors++;
+	}
+    }
+
+  dwfl_end (dwfl);
+  elf_end (core);
+  close (fd);
+
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/* Test program for the .gdb_index fallbacks of dwarf_getaranges and
+   dwarf_getnames.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <libelf.h>
+#include ELFUTILS_HEADER(dw)
+#include <stdio.h>
+#include <unistd.h>
+
+
+static int
+callback (Dwarf *dbg, Dwarf_Global *gl, unsigned int tag,
+	  void *arg __attribute__ ((unused)))
+{
+  Dwarf_Die cu_die;
+  Dwarf_Die die;
+  if (dwarf_offdie (dbg, gl->cu_offset, &cu_die) == NULL
+      || dwarf_offdie (dbg, gl->die_offset, &die) == NULL)
+    {
+      printf ("bad offsets for \"%s\"\n", gl->name);
+      return DWARF_CB_ABORT;
+    }
+
+  printf (" \"%s\", tag: 0x%x, die: %llu, CU: \"%s\"\n", gl->name, tag,
+	  (unsigned long long int) gl->die_offset, dwarf_diename (&cu_die));
+  return DWARF_CB_OK;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  int result = 0;
+
+  if (argc < 2)
+    {
+      puts ("usage: gdb-index FILE [NAME...]");
+      return 1;
+    }
+
+  int fd = open (argv[1], O_RDONLY);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[1], dwarf_errmsg (-1));
+      close (fd);
+      return 1;
+    }
+
+  Dwarf_Aranges *aranges;
+  size_t naranges;
+  if (dwarf_getaranges (dbg, &aranges, &naranges) != 0)
+    {
+      printf ("dwarf_getaranges failed: %s\n", dwarf_errmsg (-1));
+      result = 1;
+    }
+  else
+    for (size_t i = 0; i < naranges; ++i)
+      {
+	Dwarf_Arange *arange = dwarf_onearange (aranges, i);
+	Dwarf_Addr start;
+	Dwarf_Word length;
+	Dwarf_Off offset;
+	Dwarf_Die cu_die;
+	if (arange == NULL
+	    || dwarf_getarangeinfo (arange, &start, &length, &offset) != 0
+	    || dwarf_addrdie (dbg, start + length - 1, &cu_die) == NULL
+	    || dwarf_dieoffset (&cu_die) != offset)
+	  {
+	    printf ("bad arange %zu: %s\n", i, dwarf_errmsg (-1));
+	    result = 1;
+	    continue;
+	  }
+	printf ("arange %zu: %#" PRIx64 "..%#" PRIx64 ", CU: \"%s\"\n", i,
+		start, start + length, dwarf_diename (&cu_die));
+      }
+
+  for (int cnt = 2; cnt < argc; ++cnt)
+    {
+      printf ("%s:\n", argv[cnt]);
+      if (dwarf_getnames (dbg, argv[cnt], callback, NULL) != 0)
+	{
+	  printf ("dwarf_getnames didn't return zero: %s\n",
+		  dwarf_errmsg (-1));
+	  result = 1;
+	}
+    }
+
+  dwarf_end (dbg);
+  close (fd);
+
+  return result;
+}
@@ -23,6 +23,8 @@
 #include <libelf.h>
 #include ELFUTILS_HEADER(dw)
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 
@@ -34,14 +36,26 @@ static const Dwarf_Addr testaddr[] =
 };
 #define ntestaddr (sizeof (testaddr) / sizeof (testaddr[0]))
 
+/* Addresses given with -a, printed with the offset of their CU.  */
+#define MAX_EXTRA_ADDRS 16
+static Dwarf_Addr extra_addrs[MAX_EXTRA_ADDRS];
+static size_t nextra_addrs;
+
 
 int
 main (int argc, char *argv[])
 {
   int result = 0;
-  int cnt;
+  int cnt = 1;
+
+  while (cnt + 1 < argc && strcmp (argv[cnt], "-a") == 0
+	 && nextra_addrs < MAX_EXTRA_ADDRS)
+    {
+      extra_addrs[nextra_addrs++] = strtoull (argv[cnt + 1], NULL, 0);
+      cnt += 2;
+    }
 
-  for (cnt = 1; cnt < argc; ++cnt)
+  for (; cnt < argc; ++cnt)
     {
       int fd = open (argv[cnt], O_RDONLY);
 
@@ -94,6 +108,29 @@ main (int argc, char *argv[])
 			(unsigned long long int) testaddr[i]);
 	    }
 
+	  for (size_t i = 0; i < nextra_addrs; ++i)
+	    {
+	      Dwarf_Arange *found = dwarf_getarange_addr (aranges,
+							  extra_addrs[i]);
+	      Dwarf_Off cu_offset;
+	      Dwarf_Die cu_die;
+	      const char *cuname;
+	      if (found == NULL)
+		printf ("%#llx: not in range\n",
+			(unsigned long long int) extra_addrs[i]);
+	      else if (dwarf_getarangeinfo (found, NULL, NULL, &cu_offset) != 0
+		       || dwarf_offdie (dbg, cu_offset, &cu_die) == NULL
+		       || (cuname = dwarf_diename (&cu_die)) == NULL)
+		{
+		  puts ("failed to get CU die");
+		  result = 1;
+		}
+	      else
+		printf ("%#llx: cu: %llu, CU name: \"%s\"\n",
+			(unsigned long long int) extra_addrs[i],
+			(unsigned long long int) cu_offset, cuname);
+	    }
+
 	  for (size_t i = 0; i < naranges; ++i)
 	    {
 	      Dwarf_Arange *arange = dwarf_onearange (aranges, i);
@@ -0,0 +1,271 @@
+/* Test dwarf_getscopes against a walk of the DIE tree for every address.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+
+#define MAX_DEPTH 256
+
+/* The DIEs from the CU down to the one being looked at.  */
+static Dwarf_Die path[MAX_DEPTH];
+static int errors;
+
+static bool
+may_have_scopes (Dwarf_Die *die)
+{
+  switch (dwarf_tag (die))
+    {
+    case DW_TAG_compile_unit:
+    case DW_TAG_module:
+    case DW_TAG_lexical_block:
+    case DW_TAG_with_stmt:
+    case DW_TAG_catch_block:
+    case DW_TAG_try_block:
+    case DW_TAG_entry_point:
+    case DW_TAG_inlined_subroutine:
+    case DW_TAG_subprogram:
+    case DW_TAG_namespace:
+    case DW_TAG_class_type:
+    case DW_TAG_structure_type:
+      return true;
+    default:
+      return false;
+    }
+}
+
+/* Call CALLBACK for the children of DIE at DEPTH, like dwarf_getscopes
+   goes over them, with the children of imported units in place.
+   Children are only looked at when CALLBACK returns 1.  A nonzero
+   result of CALLBACK ends the walk.  */
+static int
+walk (Dwarf_Die *die, unsigned int depth,
+      int (*callback) (unsigned int depth, void *arg), void *arg)
+{
+  Dwarf_Die child;
+  if (depth >= MAX_DEPTH || dwarf_child (die, &child) != 0)
+    return 0;
+  do
+    {
+      if (dwarf_tag (&child) == DW_TAG_imported_unit)
+	{
+	  Dwarf_Attribute attr_mem;
+	  Dwarf_Die unit;
+	  if (dwarf_formref_die (dwarf_attr (&child, DW_AT_import, &attr_mem),
+				 &unit) != NULL
+	      && dwarf_tag (&unit) != DW_TAG_compile_unit)
+	    {
+	      int result = walk (&unit, depth, callback, arg);
+	      if (result != 0)
+		return result;
+	    }
+	  continue;
+	}
+
+      path[depth] = child;
+      int result = callback (depth, arg);
+      if (result == 1)
+	{
+	  if (may_have_scopes (&child))
+	    result = walk (&child, depth + 1, callback, arg);
+	  else
+	    result = 0;
+	}
+      if (result != 0)
+	return result;
+    }
+  while (dwarf_siblingof (&child, &child) == 0);
+  return 0;
+}
+
+struct expected
+{
+  Dwarf_Addr pc;
+  Dwarf_Die scopes[MAX_DEPTH];
+  unsigned int nscopes;
+  unsigned int inlined;
+  Dwarf_Die origin;
+  bool error;
+};
+
+/* Go into the DIEs containing the PC, the first one without such
+   children is the innermost scope.  DIEs without ranges don't contain
+   it, other errors make dwarf_getscopes fail.  */
+static int
+find_pc (unsigned int depth, void *arg)
+{
+  struct expected *e = arg;
+  int res = dwarf_haspc (&path[depth], e->pc);
+  if (res < 0 && dwarf_errno () != 0)
+    e->error = true;
+  if (res <= 0)
+    return 0;
+  if (dwarf_tag (&path[depth]) == DW_TAG_inlined_subroutine)
+    e->inlined = depth;
+
+  e->nscopes = 0;
+  int result = 0;
+  if (may_have_scopes (&path[depth]))
+    result = walk (&path[depth], depth + 1, find_pc, arg);
+  if (result == 0 && e->nscopes == 0)
+    {
+      for (unsigned int i = 0; i <= depth; i++)
+	e->scopes[depth - i] = path[i];
+      e->nscopes = depth + 1;
+    }
+  return 2;
+}
+
+/* Find the abstract definition anywhere in the CU.  */
+static int
+find_origin (unsigned int depth, void *arg)
+{
+  struct expected *e = arg;
+  if (dwarf_dieoffset (&path[depth]) != dwarf_dieoffset (&e->origin))
+    return 1;
+  for (unsigned int i = 0; i < depth; i++)
+    e->scopes[e->nscopes++] = path[depth - 1 - i];
+  return 2;
+}
+
+static void
+check_pc (Dwarf_Die *cudie, Dwarf_Addr pc)
+{
+  struct expected e = { .pc = pc };
+  path[0] = *cudie;
+  walk (cudie, 1, find_pc, &e);
+  if (e.nscopes != 0 && e.inlined != 0)
+    {
+      /* Only up to the inlined instance, then the parents of its
+	 abstract definition.  */
+      unsigned int innermost = e.nscopes - 1;
+      e.nscopes = innermost + 1 - e.inlined;
+      Dwarf_Attribute attr_mem;
+      if (dwarf_formref_die (dwarf_attr (&e.scopes[e.nscopes - 1],
+					 DW_AT_abstract_origin, &attr_mem),
+			     &e.origin) == NULL
+	  || walk (cudie, 1, find_origin, &e) == 0)
+	e.nscopes = 0;
+    }
+
+  Dwarf_Die *scopes;
+  int n = dwarf_getscopes (cudie, pc, &scopes);
+  if (n < 0 || e.error)
+    {
+      if (n >= 0 || ! e.error)
+	{
+	  printf ("%#" PRIx64 ": dwarf_getscopes: %s\n", pc,
+		  n < 0 ? dwarf_errmsg (-1) : "no error, expected one");
+	  errors++;
+	}
+      if (n > 0)
+	free (scopes);
+      return;
+    }
+  if ((unsigned int) n != e.nscopes)
+    {
+      printf ("%#" PRIx64 ": %d scopes, expected %u\n", pc, n, e.nscopes);
+      errors++;
+    }
+  else
+    for (int i = 0; i < n; i++)
+      if (dwarf_dieoffset (&scopes[i]) != dwarf_dieoffset (&e.scopes[i]))
+	{
+	  printf ("%#" PRIx64 ": scope %d is DIE %#" PRIx64
+		  ", expected %#" PRIx64 "\n", pc, i,
+		  dwarf_dieoffset (&scopes[i]), dwarf_dieoffset (&e.scopes[i]));
+	  errors++;
+	  break;
+	}
+  if (n > 0)
+    free (scopes);
+}
+
+struct unit_pcs
+{
+  Dwarf_Die *cudie;
+  size_t npcs;
+};
+
+/* Look up the start, middle and end of every range.  */
+static int
+check_ranges (unsigned int depth, void *arg)
+{
+  struct unit_pcs *u = arg;
+  Dwarf_Addr base, start, end;
+  ptrdiff_t off = 0;
+  while ((off = dwarf_ranges (&path[depth], off, &base, &start, &end)) > 0)
+    if (start < end)
+      {
+	check_pc (u->cudie, start);
+	check_pc (u->cudie, start + (end - start) / 2);
+	check_pc (u->cudie, end - 1);
+	check_pc (u->cudie, end);
+	u->npcs += 4;
+      }
+  return 1;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      puts ("usage: getscopes-index FILE");
+      return 1;
+    }
+
+  int fd = open (argv[1], O_RDONLY);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[1], dwarf_errmsg (-1));
+      return 1;
+    }
+
+  size_t ncus = 0;
+  size_t npcs = 0;
+  Dwarf_CU *cu = NULL;
+  Dwarf_Die cudie;
+  uint8_t unit_type;
+  while (dwarf_get_units (dbg, cu, &cu, NULL, &unit_type, &cudie, NULL) == 0)
+    if (unit_type != DW_UT_partial && unit_type != DW_UT_type
+	&& unit_type != DW_UT_split_type)
+      {
+	struct unit_pcs u = { .cudie = &cudie };
+	path[0] = cudie;
+	check_ranges (0, &u);
+	walk (&cudie, 1, check_ranges, &u);
+	npcs += u.npcs;
+	ncus++;
+      }
+
+  printf ("%zu units, %zu addresses\n", ncus, npcs);
+
+  dwarf_end (dbg);
+  close (fd);
+
+  return errors == 0 ? 0 : 1;
+}
@@ -29,15 +29,87 @@
 #include "system.h"
 
 
+/* Check dwarf_getsrc_die against a linear search for the address of
+   every line, and the addresses right before and after it.  */
+static int
+check_all_lines (Dwarf *dbg)
+{
+  int result = 0;
+  size_t checked = 0;
+  Dwarf_CU *cu = NULL;
+  Dwarf_Die cudie;
+  while (dwarf_get_units (dbg, cu, &cu, NULL, NULL, &cudie, NULL) == 0)
+    {
+      Dwarf_Lines *lines;
+      size_t nlines;
+      if (dwarf_getsrclines (&cudie, &lines, &nlines) != 0)
+	continue;
+
+      /* The lines are sorted, so for each delta the first line after
+	 the address only moves forward.  */
+      size_t next[3] = { 0, 0, 0 };
+      for (size_t i = 0; i < nlines; i++)
+	for (int delta = -1; delta <= 1; delta++)
+	  {
+	    Dwarf_Addr addr;
+	    dwarf_lineaddr (dwarf_onesrcline (lines, i), &addr);
+	    if ((delta < 0 && addr == 0) || (delta > 0 && addr == (Dwarf_Addr) -1))
+	      continue;
+	    addr += delta;
+
+	    size_t *j = &next[delta + 1];
+	    while (*j < nlines)
+	      {
+		Dwarf_Addr line_addr;
+		dwarf_lineaddr (dwarf_onesrcline (lines, *j), &line_addr);
+		if (line_addr > addr)
+		  break;
+		++*j;
+	      }
+
+	    Dwarf_Line *expected = NULL;
+	    if (*j > 0)
+	      {
+		bool end_sequence;
+		expected = dwarf_onesrcline (lines, *j - 1);
+		dwarf_lineendsequence (expected, &end_sequence);
+		if (end_sequence)
+		  expected = NULL;
+	      }
+
+	    Dwarf_Line *line = dwarf_getsrc_die (&cudie, addr);
+	    if (line != expected)
+	      {
+		printf ("CU %#" PRIx64 " address %#" PRIx64 ": got %p,"
+			" expected %p\n", dwarf_dieoffset (&cudie), addr,
+			line, expected);
+		result = 1;
+	      }
+	    checked++;
+	  }
+    }
+
+  printf ("%zu addresses checked\n", checked);
+  return result;
+}
+
 int
 main (int argc, char *argv[])
 {
-  /* file addr+ */
+  /* file [addr+] */
   int fd = open (argv[1], O_RDONLY);
   Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
   if  (dbg == NULL)
     error (-1, 0, "dwarf_begin (%s): %s\n", argv[1], dwarf_errmsg (-1));
 
+  if (argc == 2)
+    {
+      int result = check_all_lines (dbg);
+      dwarf_end (dbg);
+      close (fd);
+      return result;
+    }
+
   for (int i = 2; i < argc; i++)
     {
       Dwarf_Addr addr;
@@ -0,0 +1,206 @@
+/* Test dwarf_getsrclines on the same units from several threads.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+
+#define NTHREADS 8
+#define NROUNDS 16
+
+/* The offset of each CU DIE and its number of lines and files as read
+   by a single thread, zero if it has none.  */
+struct unit_info
+{
+  Dwarf_Off offset;
+  size_t nlines;
+  size_t nfiles;
+};
+
+static struct unit_info *units;
+static size_t nunits;
+
+/* A new Dwarf for each round, which hasn't read any line table yet
+   when the threads start.  */
+static Dwarf *shared_dbg;
+static pthread_barrier_t barrier;
+
+/* The tables found by each thread.  */
+static Dwarf_Lines **found_lines[NTHREADS];
+static Dwarf_Files **found_files[NTHREADS];
+
+static void
+read_unit (Dwarf_Die *cudie, size_t *nlines, size_t *nfiles)
+{
+  Dwarf_Lines *lines;
+  Dwarf_Files *files;
+  *nlines = *nfiles = 0;
+  if (dwarf_getsrclines (cudie, &lines, nlines) != 0)
+    *nlines = 0;
+  if (dwarf_getsrcfiles (cudie, &files, nfiles) != 0)
+    *nfiles = 0;
+}
+
+static void *
+check_units (void *arg)
+{
+  /* All threads go through the units in the same order at the same
+     time, so most line tables are asked for by several at once.  */
+  size_t t = (size_t) arg;
+  pthread_barrier_wait (&barrier);
+  for (size_t i = 0; i < nunits; i++)
+    {
+      Dwarf_Die cudie;
+      if (dwarf_offdie (shared_dbg, units[i].offset, &cudie) == NULL)
+	return (void *) -1;
+
+      size_t nlines;
+      if (units[i].nlines == 0)
+	found_lines[t][i] = NULL;
+      else if (dwarf_getsrclines (&cudie, &found_lines[t][i], &nlines) != 0
+	       || nlines != units[i].nlines)
+	return (void *) -1;
+
+      size_t nfiles;
+      if (units[i].nfiles == 0)
+	found_files[t][i] = NULL;
+      else if (dwarf_getsrcfiles (&cudie, &found_files[t][i], &nfiles) != 0
+	       || nfiles != units[i].nfiles)
+	return (void *) -1;
+    }
+  return NULL;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      puts ("usage: getsrclines-threads FILE");
+      return 1;
+    }
+
+  int fd = open (argv[1], O_RDONLY);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[1], dwarf_errmsg (-1));
+      return 1;
+    }
+
+  size_t nalloc = 0;
+  Dwarf_CU *cu = NULL;
+  Dwarf_Die cudie;
+  while (dwarf_get_units (dbg, cu, &cu, NULL, NULL, &cudie, NULL) == 0)
+    {
+      if (nunits == nalloc)
+	{
+	  nalloc = nalloc == 0 ? 64 : 2 * nalloc;
+	  units = realloc (units, nalloc * sizeof (struct unit_info));
+	  if (units == NULL)
+	    {
+	      puts ("out of memory");
+	      return 1;
+	    }
+	}
+      units[nunits].offset = dwarf_dieoffset (&cudie);
+      read_unit (&cudie, &units[nunits].nlines, &units[nunits].nfiles);
+      nunits++;
+    }
+  dwarf_end (dbg);
+
+  for (size_t t = 0; t < NTHREADS; t++)
+    {
+      found_lines[t] = malloc (nunits * sizeof (Dwarf_Lines *));
+      found_files[t] = malloc (nunits * sizeof (Dwarf_Files *));
+      if (found_lines[t] == NULL || found_files[t] == NULL)
+	{
+	  puts ("out of memory");
+	  return 1;
+	}
+    }
+
+  int result = 0;
+  pthread_barrier_init (&barrier, NULL, NTHREADS);
+  for (int round = 0; round < NROUNDS; round++)
+    {
+      shared_dbg = dwarf_begin (fd, DWARF_C_READ);
+      if (shared_dbg == NULL)
+	{
+	  printf ("%s not usable: %s\n", argv[1], dwarf_errmsg (-1));
+	  return 1;
+	}
+
+      pthread_t threads[NTHREADS];
+      for (size_t t = 0; t < NTHREADS; t++)
+	if (pthread_create (&threads[t], NULL, check_units, (void *) t) != 0)
+	  {
+	    puts ("pthread_create failed");
+	    return 1;
+	  }
+
+      for (size_t t = 0; t < NTHREADS; t++)
+	{
+	  void *ret;
+	  if (pthread_join (threads[t], &ret) != 0 || ret != NULL)
+	    {
+	      printf ("round %d thread %zu failed\n", round, t);
+	      result = 1;
+	    }
+	}
+
+      /* There is only one table of each unit, whoever read it.  */
+      for (size_t t = 1; t < NTHREADS && result == 0; t++)
+	for (size_t i = 0; i < nunits; i++)
+	  if (found_lines[t][i] != found_lines[0][i]
+	      || found_files[t][i] != found_files[0][i])
+	    {
+	      printf ("round %d: unit %#llx has different tables\n", round,
+		      (unsigned long long int) units[i].offset);
+	      result = 1;
+	      break;
+	    }
+
+      dwarf_end (shared_dbg);
+    }
+  pthread_barrier_destroy (&barrier);
+
+  size_t nlines = 0;
+  for (size_t i = 0; i < nunits; i++)
+    nlines += units[i].nlines;
+  if (nlines == 0)
+    {
+      printf ("no lines in %s\n", argv[1]);
+      result = 1;
+    }
+
+  for (size_t t = 0; t < NTHREADS; t++)
+    {
+      free (found_lines[t]);
+      free (found_files[t]);
+    }
+  free (units);
+  close (fd);
+
+  return result;
+}
@@ -19,6 +19,7 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include <libdw.h>
 #include "../libdw/libdwP.h"
 #include "../libdw/memory-access.h"
@@ -133,6 +134,16 @@ test_one_uleb (const unsigned char *data, size_t len, uint64_t expect)
   if (value != expect || p != data + len)
     return FAIL;
 
+  if (__libdw_skip_uleb128 (data, data + len) != len)
+    return FAIL;
+
+  /* With more bytes after the number it is skipped a word at a time.  */
+  unsigned char buf[32];
+  memcpy (buf, data, len);
+  memset (buf + len, 0x80, sizeof buf - len);
+  if (__libdw_skip_uleb128 (buf, buf + sizeof buf) != len)
+    return FAIL;
+
   return OK;
 }
 
@@ -166,8 +177,29 @@ test_uleb (void)
   return OK;
 }
 
+static int
+test_skip_uleb (void)
+{
+  /* Numbers that don't end are skipped as far as they are read.  */
+  unsigned char buf[16];
+  memset (buf, 0x80, sizeof buf);
+  for (size_t len = 0; len <= sizeof buf; len++)
+    {
+      uint64_t value __attribute__ ((unused));
+      const unsigned char *p = buf;
+      if (len > 0)
+	get_uleb128 (value, p, buf + len);
+      else
+	p++;
+      if (__libdw_skip_uleb128 (buf, buf + len) != (size_t) (p - buf))
+	return FAIL;
+    }
+
+  return OK;
+}
+
 int
 main (void)
 {
-  return test_sleb () || test_uleb ();
+  return test_sleb () || test_uleb () || test_skip_uleb ();
 }
@@ -0,0 +1,184 @@
+/* Test dwarf_offdie and reading DIEs from multiple threads at once.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+
+#define NTHREADS 8
+#define NROUNDS 4
+
+/* Offsets of the CU DIEs and their first children, the offset of the
+   CU DIE they belong to, and for CU DIEs the number of DIEs in the CU,
+   as read by a single thread.  */
+struct die_info
+{
+  Dwarf_Off offset;
+  Dwarf_Off cu_offset;
+  size_t count;
+};
+
+static struct die_info *dies;
+static size_t ndies;
+
+/* The Dwarf shared by all threads, which hasn't read any unit yet
+   when the threads start.  */
+static Dwarf *shared_dbg;
+
+/* Count DIE, its siblings and all their children.  */
+static size_t
+count_dies (Dwarf_Die *die)
+{
+  size_t count = 0;
+  Dwarf_Die cur = *die;
+  do
+    {
+      count++;
+      Dwarf_Die child;
+      if (dwarf_child (&cur, &child) == 0)
+	count += count_dies (&child);
+    }
+  while (dwarf_siblingof (&cur, &cur) == 0);
+  return count;
+}
+
+static void
+add_die (Dwarf_Die *die, Dwarf_Die *cudie)
+{
+  static size_t nalloc;
+  if (ndies == nalloc)
+    {
+      nalloc = nalloc == 0 ? 64 : 2 * nalloc;
+      dies = realloc (dies, nalloc * sizeof (struct die_info));
+      if (dies == NULL)
+	{
+	  puts ("out of memory");
+	  exit (1);
+	}
+    }
+  dies[ndies].offset = dwarf_dieoffset (die);
+  dies[ndies].cu_offset = dwarf_dieoffset (cudie);
+  dies[ndies].count = die == cudie ? count_dies (die) : 0;
+  ndies++;
+}
+
+static void *
+check_dies (void *arg)
+{
+  /* Every thread looks at all DIEs, but starts at a different one, so
+     some units are first seen by each of the threads.  */
+  size_t t = (size_t) arg;
+  size_t start = t * ndies / NTHREADS;
+  for (size_t i = 0; i < ndies; i++)
+    {
+      size_t n = (start + i) % ndies;
+      struct die_info *info = &dies[n];
+      Dwarf_Die die;
+      Dwarf_Die cudie;
+      if (dwarf_offdie (shared_dbg, info->offset, &die) == NULL
+	  || dwarf_dieoffset (&die) != info->offset
+	  || dwarf_diecu (&die, &cudie, NULL, NULL) == NULL
+	  || dwarf_dieoffset (&cudie) != info->cu_offset)
+	return (void *) -1;
+
+      /* Reading the DIEs of a CU decodes its abbreviations, which
+	 isn't done concurrently for the same CU, so only one thread
+	 reads each.  This makes all threads allocate memory at once.  */
+      if (info->count != 0 && n % NTHREADS == t
+	  && count_dies (&die) != info->count)
+	return (void *) -1;
+    }
+  return NULL;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      puts ("usage: offdie-threads FILE");
+      return 1;
+    }
+
+  int fd = open (argv[1], O_RDONLY);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[1], dwarf_errmsg (-1));
+      return 1;
+    }
+
+  Dwarf_CU *cu = NULL;
+  Dwarf_Die cudie;
+  while (dwarf_get_units (dbg, cu, &cu, NULL, NULL, &cudie, NULL) == 0)
+    {
+      add_die (&cudie, &cudie);
+      Dwarf_Die child;
+      if (dwarf_child (&cudie, &child) == 0)
+	add_die (&child, &cudie);
+    }
+  dwarf_end (dbg);
+
+  shared_dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (shared_dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[1], dwarf_errmsg (-1));
+      return 1;
+    }
+
+  /* Each round uses new threads, which continue with the memory of
+     the threads of the previous round.  */
+  int result = 0;
+  for (int round = 0; round < NROUNDS; round++)
+    {
+      pthread_t threads[NTHREADS];
+      for (size_t t = 0; t < NTHREADS; t++)
+	if (pthread_create (&threads[t], NULL, check_dies, (void *) t) != 0)
+	  {
+	    puts ("pthread_create failed");
+	    return 1;
+	  }
+
+      for (size_t t = 0; t < NTHREADS; t++)
+	{
+	  void *ret;
+	  if (pthread_join (threads[t], &ret) != 0 || ret != NULL)
+	    {
+	      printf ("round %d thread %zu failed\n", round, t);
+	      result = 1;
+	    }
+	}
+    }
+
+  dwarf_end (shared_dbg);
+  close (fd);
+  free (dies);
+
+  if (ndies == 0)
+    {
+      printf ("no units in %s\n", argv[1]);
+      result = 1;
+    }
+
+  return result;
+}
@@ -0,0 +1,212 @@
+/* Test dwarf_parallel_units against a serial walk of all units.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+
+/* What we find in each unit.  The tags make sure abbreviations are
+   decoded, the names that string offsets are used and the split DIEs
+   that split units are found.  */
+struct unit_info
+{
+  Dwarf_Off offset;
+  size_t dies;
+  size_t tags;
+  size_t names;
+  size_t lines;
+  size_t split_dies;
+  int done;
+};
+
+static Dwarf_CU *const *par_units;
+static size_t par_nunits;
+static struct unit_info *par_info;
+
+static void
+walk_dies (Dwarf_Die *die, size_t *dies, size_t *tags, size_t *names)
+{
+  Dwarf_Die cur = *die;
+  do
+    {
+      (*dies)++;
+      *tags += dwarf_tag (&cur);
+      const char *name = dwarf_diename (&cur);
+      if (name != NULL)
+	*names += strlen (name);
+      Dwarf_Die child;
+      if (dwarf_child (&cur, &child) == 0)
+	walk_dies (&child, dies, tags, names);
+    }
+  while (dwarf_siblingof (&cur, &cur) == 0);
+}
+
+static void
+unit_info (Dwarf_CU *cu, Dwarf_Die *cudie, struct unit_info *info)
+{
+  memset (info, 0, sizeof *info);
+  info->offset = dwarf_dieoffset (cudie);
+  walk_dies (cudie, &info->dies, &info->tags, &info->names);
+
+  Dwarf_Lines *lines;
+  if (dwarf_getsrclines (cudie, &lines, &info->lines) != 0)
+    info->lines = 0;
+
+  uint8_t unit_type;
+  Dwarf_Die subdie;
+  if (dwarf_cu_info (cu, NULL, &unit_type, NULL, &subdie,
+		     NULL, NULL, NULL) == 0
+      && unit_type == DW_UT_skeleton
+      && dwarf_tag (&subdie) != DW_TAG_invalid)
+    walk_dies (&subdie, &info->split_dies, &info->tags, &info->names);
+
+  info->done = 1;
+}
+
+static int
+parallel_callback (Dwarf_CU *cu, Dwarf_Die *cudie, void *arg)
+{
+  if (arg != &par_info)
+    return DWARF_CB_ABORT;
+
+  for (size_t i = 0; i < par_nunits; i++)
+    if (par_units[i] == cu)
+      {
+	if (par_info[i].done)
+	  {
+	    printf ("unit %zu seen twice\n", i);
+	    return DWARF_CB_ABORT;
+	  }
+	unit_info (cu, cudie, &par_info[i]);
+	return DWARF_CB_OK;
+      }
+
+  puts ("unknown unit");
+  return DWARF_CB_ABORT;
+}
+
+static int
+count_callback (Dwarf_CU *cu __attribute__ ((unused)),
+		Dwarf_Die *cudie __attribute__ ((unused)), void *arg)
+{
+  /* Abort at the first unit, the other threads might still see a few
+     more.  */
+  __atomic_fetch_add ((size_t *) arg, 1, __ATOMIC_RELAXED);
+  return DWARF_CB_ABORT;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 3)
+    {
+      puts ("usage: parallel-units NTHREADS FILE");
+      return 1;
+    }
+
+  unsigned int nthreads = atoi (argv[1]);
+  int fd = open (argv[2], O_RDONLY);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[2], dwarf_errmsg (-1));
+      return 1;
+    }
+
+  if (dwarf_get_unit_list (dbg, &par_units, &par_nunits) != 0)
+    {
+      printf ("dwarf_get_unit_list: %s\n", dwarf_errmsg (-1));
+      return 1;
+    }
+  par_info = calloc (par_nunits, sizeof (struct unit_info));
+  if (par_info == NULL && par_nunits > 0)
+    {
+      puts ("out of memory");
+      return 1;
+    }
+
+  int result = 0;
+  int res = dwarf_parallel_units (dbg, nthreads, parallel_callback,
+				  &par_info);
+  if (res != 0)
+    {
+      printf ("dwarf_parallel_units returned %d: %s\n", res,
+	      dwarf_errmsg (-1));
+      result = 1;
+    }
+
+  size_t seen = 0;
+  if (dwarf_parallel_units (dbg, nthreads, count_callback, &seen) != 1
+      || seen == 0 || seen > (nthreads == 0 ? par_nunits : nthreads))
+    {
+      printf ("aborting didn't work, saw %zu units\n", seen);
+      result = 1;
+    }
+
+  /* Now the same from a single thread in a fresh Dwarf.  */
+  Dwarf *serial_dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (serial_dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[2], dwarf_errmsg (-1));
+      return 1;
+    }
+
+  size_t n = 0;
+  size_t dies = 0, tags = 0, names = 0, lines = 0, split_dies = 0;
+  Dwarf_CU *cu = NULL;
+  Dwarf_Die cudie;
+  while (dwarf_get_units (serial_dbg, cu, &cu,
+			  NULL, NULL, &cudie, NULL) == 0)
+    {
+      struct unit_info info;
+      unit_info (cu, &cudie, &info);
+      if (n >= par_nunits || memcmp (&info, &par_info[n], sizeof info) != 0)
+	{
+	  printf ("unit %zu at %#" PRIx64 " differs\n", n, info.offset);
+	  result = 1;
+	}
+      dies += info.dies;
+      tags += info.tags;
+      names += info.names;
+      lines += info.lines;
+      split_dies += info.split_dies;
+      n++;
+    }
+  if (n != par_nunits)
+    {
+      printf ("%zu units, but %zu in parallel\n", n, par_nunits);
+      result = 1;
+    }
+
+  printf ("units: %zu, DIEs: %zu, split DIEs: %zu, tags: %zu, names: %zu,"
+	  " lines: %zu\n", n, dies, split_dies, tags, names, lines);
+
+  dwarf_end (serial_dbg);
+  dwarf_end (dbg);
+  close (fd);
+  free (par_info);
+
+  return result;
+}
@@ -0,0 +1,53 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Look up every attribute with dwarf_attr, which uses the decoded
+# abbreviations, and compare with dwarf_getattrs.
+
+# See run-readelf-types.sh
+testfiles testfile-debug-types
+
+# See run-unstrip-test4.sh
+testfiles testfile-strtab
+
+# See run-dwarf-die-addr-die.sh
+testfiles testfile-dwarf-4 testfile-dwarf-5 testfile-hello5.dwo
+
+testrun_compare ${abs_builddir}/abbrev-attrs testfile-debug-types <<\EOF2
+3 units, 1 abbrev tables, 59 attributes
+EOF2
+
+testrun_compare ${abs_builddir}/abbrev-attrs testfile-strtab <<\EOF2
+2 units, 1 abbrev tables, 45951 attributes
+EOF2
+
+testrun_compare ${abs_builddir}/abbrev-attrs testfile-dwarf-4 <<\EOF2
+2 units, 2 abbrev tables, 317 attributes
+EOF2
+
+testrun_compare ${abs_builddir}/abbrev-attrs testfile-dwarf-5 <<\EOF2
+2 units, 2 abbrev tables, 317 attributes
+EOF2
+
+testrun_compare ${abs_builddir}/abbrev-attrs testfile-hello5.dwo <<\EOF2
+1 units, 1 abbrev tables, 158 attributes
+EOF2
+
+testrun_on_self_quiet ${abs_builddir}/abbrev-attrs
+
+exit 0
@@ -0,0 +1,60 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Look up the frame state at every address of the code with
+# dwarf_cfi_addrframe_cached and compare with dwarf_cfi_addrframe.
+
+# See run-addrcfi.sh and run-dwarfcfi.sh
+testfiles testfile11 testfile12 testfileppc32 testfileppc64
+testfiles testfiles390x testfileaarch64 testfilearm-debugframe
+
+testrun_compare ${abs_builddir}/cfi-addrframe-cached testfile11 <<\EOF2
+.eh_frame: 883 addresses, .debug_frame: 1063 addresses
+EOF2
+
+testrun_compare ${abs_builddir}/cfi-addrframe-cached testfile12 <<\EOF2
+.eh_frame: 23 addresses, .debug_frame: 23 addresses
+EOF2
+
+testrun_compare ${abs_builddir}/cfi-addrframe-cached testfileppc32 <<\EOF2
+.eh_frame: 308 addresses, .debug_frame: 32 addresses
+EOF2
+
+testrun_compare ${abs_builddir}/cfi-addrframe-cached testfileppc64 <<\EOF2
+.eh_frame: 220 addresses, .debug_frame: 100 addresses
+EOF2
+
+testrun_compare ${abs_builddir}/cfi-addrframe-cached testfiles390x <<\EOF2
+.eh_frame: 150 addresses, .debug_frame: 0 addresses
+EOF2
+
+testrun_compare ${abs_builddir}/cfi-addrframe-cached testfileaarch64 <<\EOF2
+.eh_frame: 124 addresses, .debug_frame: 40 addresses
+EOF2
+
+testrun_compare ${abs_builddir}/cfi-addrframe-cached testfilearm-debugframe <<\EOF2
+.eh_frame: 0 addresses, .debug_frame: 40 addresses
+EOF2
+
+# Optimized code has lots of DW_CFA_remember_state and
+# DW_CFA_restore_state.  Not the object files, their sections, and so
+# their FDEs, all start at zero.
+testrun_on_self_exe ${abs_builddir}/cfi-addrframe-cached
+testrun_on_self_lib ${abs_builddir}/cfi-addrframe-cached
+
+exit 0
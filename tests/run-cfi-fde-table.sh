@@ -0,0 +1,156 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# .debug_frame has no search table, so the first lookup reads the
+# ranges of all FDEs into a sorted table.  Check that every FDE is
+# found from it, and no FDE where there is none.
+
+# See run-dwarfcfi.sh
+testfiles testfile11-debugframe testfile12-debugframe
+testfiles testfileaarch64-debugframe testfilearm-debugframe
+testfiles testfileppc32-debugframe testfileppc64-debugframe
+
+testrun_compare ${abs_builddir}/cfi-fde-table testfile11-debugframe <<\EOF2
+8 FDEs
+EOF2
+
+testrun_compare ${abs_builddir}/cfi-fde-table testfile12-debugframe <<\EOF2
+1 FDEs
+EOF2
+
+testrun_compare ${abs_builddir}/cfi-fde-table testfileaarch64-debugframe <<\EOF2
+2 FDEs
+EOF2
+
+testrun_compare ${abs_builddir}/cfi-fde-table testfilearm-debugframe <<\EOF2
+2 FDEs
+EOF2
+
+testrun_compare ${abs_builddir}/cfi-fde-table testfileppc32-debugframe <<\EOF2
+2 FDEs
+EOF2
+
+testrun_compare ${abs_builddir}/cfi-fde-table testfileppc64-debugframe <<\EOF2
+2 FDEs
+EOF2
+
+# Linked with --gc-sections, the FDEs of the discarded functions are
+# left in .debug_frame starting at zero, where they overlap.  As when
+# reading the FDEs one by one, only the first of those is found there.
+#
+# int unused1 (int a) { return a * 3 + 1; }
+# int unused2 (int a, int b) { return a * b - 7; }
+# __attribute__ ((noinline)) int used1 (int a) { return a + 42; }
+# int unused3 (int a) { return a << 2; }
+# __attribute__ ((noinline)) int used2 (int a) { return used1 (a) * 5; }
+# __attribute__ ((noinline)) int used3 (int a) { return used2 (a) ^ 3; }
+# int main (int argc, char **argv) { return used3 (argc) + used1 (argc); }
+#
+# gcc -O2 -g -fno-asynchronous-unwind-tables -ffunction-sections \
+#     -fno-pie -no-pie -nostdlib -e main -Wl,--gc-sections \
+#     -o testfile-debugframe-gc gc.c
+testfiles testfile-debugframe-gc
+testrun_compare ${abs_builddir}/cfi-fde-table testfile-debugframe-gc <<\EOF2
+5 FDEs
+2 overlapping FDEs
+EOF2
+
+# In a relocatable file all FDEs start at zero until relocated.
+#
+# int foo (int a) { return a + 1; }
+# int bar (int a, int b) { return foo (a) * b; }
+#
+# gcc -g -O0 -fno-asynchronous-unwind-tables -c -o testfile-debugframe-rel.o two.c
+testfiles testfile-debugframe-rel.o
+testrun_compare ${abs_builddir}/cfi-fde-table testfile-debugframe-rel.o <<\EOF2
+1 FDEs
+1 overlapping FDEs
+EOF2
+
+# libdwfl relocates them, the function at zero is found too.
+testrun_compare ${abs_builddir}/addrcfi -e testfile-debugframe-rel.o 0x5 <<\EOF2
+handle_cfi no CFI (.eh_frame): no DWARF information
+.debug_frame has 0x5 => [0x4, 0xe):
+	return address in reg16
+	CFA location expression: bregx(6,16)
+	integer reg0 (%rax): same_value
+	integer reg1 (%rdx): undefined
+	integer reg2 (%rcx): undefined
+	integer reg3 (%rbx): undefined
+	integer reg4 (%rsi): undefined
+	integer reg5 (%rdi): undefined
+	integer reg6 (%rbp): location expression: call_frame_cfa plus_uconst(-16)
+	integer reg7 (%rsp): location expression: call_frame_cfa stack_value
+	integer reg8 (%r8): undefined
+	integer reg9 (%r9): undefined
+	integer reg10 (%r10): undefined
+	integer reg11 (%r11): undefined
+	integer reg12 (%r12): same_value
+	integer reg13 (%r13): same_value
+	integer reg14 (%r14): same_value
+	integer reg15 (%r15): same_value
+	integer reg16 (%rip): location expression: call_frame_cfa plus_uconst(-8)
+	SSE reg17 (%xmm0): undefined
+	SSE reg18 (%xmm1): undefined
+	SSE reg19 (%xmm2): undefined
+	SSE reg20 (%xmm3): undefined
+	SSE reg21 (%xmm4): undefined
+	SSE reg22 (%xmm5): undefined
+	SSE reg23 (%xmm6): undefined
+	SSE reg24 (%xmm7): undefined
+	SSE reg25 (%xmm8): undefined
+	SSE reg26 (%xmm9): undefined
+	SSE reg27 (%xmm10): undefined
+	SSE reg28 (%xmm11): undefined
+	SSE reg29 (%xmm12): undefined
+	SSE reg30 (%xmm13): undefined
+	SSE reg31 (%xmm14): undefined
+	SSE reg32 (%xmm15): undefined
+	x87 reg33 (%st0): undefined
+	x87 reg34 (%st1): undefined
+	x87 reg35 (%st2): undefined
+	x87 reg36 (%st3): undefined
+	x87 reg37 (%st4): undefined
+	x87 reg38 (%st5): undefined
+	x87 reg39 (%st6): undefined
+	x87 reg40 (%st7): undefined
+	MMX reg41 (%mm0): undefined
+	MMX reg42 (%mm1): undefined
+	MMX reg43 (%mm2): undefined
+	MMX reg44 (%mm3): undefined
+	MMX reg45 (%mm4): undefined
+	MMX reg46 (%mm5): undefined
+	MMX reg47 (%mm6): undefined
+	MMX reg48 (%mm7): undefined
+	integer reg49 (%rflags): undefined
+	segment reg50 (%es): undefined
+	segment reg51 (%cs): undefined
+	segment reg52 (%ss): undefined
+	segment reg53 (%ds): undefined
+	segment reg54 (%fs): undefined
+	segment reg55 (%gs): undefined
+	segment reg58 (%fs.base): undefined
+	segment reg59 (%gs.base): undefined
+	control reg62 (%tr): undefined
+	control reg63 (%ldtr): undefined
+	control reg64 (%mxcsr): undefined
+	control reg65 (%fcw): undefined
+	control reg66 (%fsw): undefined
+EOF2
+
+exit 0
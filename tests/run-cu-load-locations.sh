@@ -0,0 +1,46 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Load all locations with dwarf_cu_load_locations from several threads
+# and compare them with the locations decoded one at a time.
+
+# See run-varlocs.sh
+testfiles testfile_implicit_value testfile_entry_value testfileloc
+
+# See run-readelf-loc.sh
+testfiles testfile-splitdwarf-5 testfile-hello5.dwo testfile-world5.dwo
+
+testrun_compare ${abs_builddir}/cu-load-locations 4 testfile_implicit_value <<\EOF2
+3 location expressions
+EOF2
+
+testrun_compare ${abs_builddir}/cu-load-locations 4 testfile_entry_value <<\EOF2
+32 location expressions
+EOF2
+
+testrun_compare ${abs_builddir}/cu-load-locations 4 testfileloc <<\EOF2
+21 location expressions
+EOF2
+
+testrun_compare ${abs_builddir}/cu-load-locations 2 testfile-splitdwarf-5 <<\EOF2
+33 location expressions
+EOF2
+
+testrun_on_self_quiet ${abs_builddir}/cu-load-locations 8
+
+exit 0
@@ -0,0 +1,105 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# = main.c =
+# struct point { int x, y; };
+# typedef struct point Point;
+# int global_counter;
+# extern int other_function (int);
+# static int helper (int a) { return a + 1; }
+# int MixedCase (Point *p) { return p->x + p->y; }
+# int
+# main (void)
+# {
+#   Point p = { 1, 2 };
+#   global_counter = helper (MixedCase (&p));
+#   return other_function (global_counter);
+# }
+#
+# = other.c =
+# enum color { red, green, blue };
+# static int helper (int a) { return a * 2; }
+# int
+# other_function (int x)
+# {
+#   enum color c = green;
+#   return helper (x) + c;
+# }
+#
+# gcc -gdwarf-5 -O0 -o testfile-debug-names main.c other.c
+#
+# GCC doesn't emit .debug_names, so a DWARF 5 name index with one
+# entry per named top-level DIE was added afterwards with objcopy
+# --add-section.  "point" and "Point" share a (case folded) hash,
+# "helper" and "int" have entries in both CUs.
+
+testfiles testfile-debug-names
+
+testrun_compare ${abs_builddir}/debug-names testfile-debug-names <<\EOF
+ "MixedCase", tag: 0x2e, die: 189, cu: 12
+CU name: "main.c"
+ "color", tag: 0x4, die: 332, cu: 298
+CU name: "other.c"
+ "other_function", tag: 0x2e, die: 376, cu: 298
+CU name: "other.c"
+ "unsigned int", tag: 0x24, die: 369, cu: 298
+CU name: "other.c"
+ "main", tag: 0x2e, die: 141, cu: 12
+CU name: "main.c"
+ "global_counter", tag: 0x34, die: 97, cu: 12
+CU name: "main.c"
+ "int", tag: 0x24, die: 78, cu: 12
+CU name: "main.c"
+ "int", tag: 0x24, die: 436, cu: 298
+CU name: "other.c"
+ "Point", tag: 0x16, die: 85, cu: 12
+CU name: "main.c"
+ "helper", tag: 0x2e, die: 242, cu: 12
+CU name: "main.c"
+ "helper", tag: 0x2e, die: 443, cu: 298
+CU name: "other.c"
+ "point", tag: 0x13, die: 46, cu: 12
+CU name: "main.c"
+EOF
+
+testrun_compare ${abs_builddir}/debug-names testfile-debug-names \
+	helper point Point mixedcase MixedCase nothere int <<\EOF
+helper:
+ "helper", tag: 0x2e, die: 242, cu: 12
+CU name: "main.c"
+ "helper", tag: 0x2e, die: 443, cu: 298
+CU name: "other.c"
+point:
+ "point", tag: 0x13, die: 46, cu: 12
+CU name: "main.c"
+Point:
+ "Point", tag: 0x16, die: 85, cu: 12
+CU name: "main.c"
+mixedcase:
+MixedCase:
+ "MixedCase", tag: 0x2e, die: 189, cu: 12
+CU name: "main.c"
+nothere:
+int:
+ "int", tag: 0x24, die: 78, cu: 12
+CU name: "main.c"
+ "int", tag: 0x24, die: 436, cu: 298
+CU name: "other.c"
+EOF
+
+exit 0
@@ -26,4 +26,12 @@ testfile52-32.so: testfile52-32.so.debug, crc: b835a71d
 testfile42: <no gnu_debuglink file>
 EOF
 
+# With the debug files around their CRC is checked too.
+testfiles testfile36.debug testfile52-32.so.debug
+
+testrun_compare  ${abs_builddir}/debuglink testfile36 testfile52-32.so <<\EOF
+testfile36: testfile36.debug, crc: 8c5c20a3, matches
+testfile52-32.so: testfile52-32.so.debug, crc: b835a71d, matches
+EOF
+
 exit 0
@@ -0,0 +1,46 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Walk all units with a Dwarf_Die_Cursor, in pre and post order,
+# skipping subtrees and resuming from saved positions, and compare
+# with a recursive walk.
+
+# See run-readelf-types.sh
+testfiles testfile-debug-types
+
+# See run-unstrip-test4.sh
+testfiles testfile-strtab
+
+# See run-dwarf-die-addr-die.sh
+testfiles testfile-dwarf-5
+
+testrun_compare ${abs_builddir}/die-cursor testfile-debug-types <<\EOF2
+13 DIEs, depth 2
+EOF2
+
+testrun_compare ${abs_builddir}/die-cursor testfile-strtab <<\EOF2
+12682 DIEs, depth 12
+EOF2
+
+testrun_compare ${abs_builddir}/die-cursor testfile-dwarf-5 <<\EOF2
+74 DIEs, depth 6
+EOF2
+
+testrun_on_self_quiet ${abs_builddir}/die-cursor
+
+exit 0
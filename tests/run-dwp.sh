@@ -0,0 +1,564 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Split DWARF units found through a DWARF package file, without any
+# .dwo files around.  The results should be the same as when reading
+# the .dwo files.
+#
+# main.c
+# struct point { int x, y; };
+# typedef struct point Point;
+# int global_counter;
+# extern int other_function (int);
+# static int helper (int a) { return a + 1; }
+# int MixedCase (Point *p) { return p->x + p->y; }
+# int
+# main (void)
+# {
+#   Point p = { 1, 2 };
+#   global_counter = helper (MixedCase (&p));
+#   return other_function (global_counter);
+# }
+#
+# other.c
+# enum color { red, green, blue };
+# static int helper (int a) { return a * 2; }
+# int
+# other_function (int x)
+# {
+#   enum color c = green;
+#   return helper (x) + c;
+# }
+#
+# gcc -c -O2 -gdwarf-4 -gsplit-dwarf -o testfile-dwp-4-main.o main.c
+# gcc -c -O2 -gdwarf-4 -gsplit-dwarf -o testfile-dwp-4-other.o other.c
+# gcc -O2 -o testfile-dwp-4 testfile-dwp-4-main.o testfile-dwp-4-other.o
+# dwp -e testfile-dwp-4
+#
+# testfile-dwp-5 was built the same way with -gdwarf-5.  binutils dwp
+# only creates version 2 indexes, so testfile-dwp-5.dwp was assembled
+# from the .dwo files following the DWARF5 package file layout (one
+# contribution per unit, .debug_str_offsets.dwo entries relocated into
+# the combined .debug_str.dwo, a version 5 .debug_cu_index).
+
+testfiles testfile-dwp-4 testfile-dwp-4.dwp
+testfiles testfile-dwp-5 testfile-dwp-5.dwp
+
+testrun_compare ${abs_builddir}/get-units-split testfile-dwp-4 <<\EOF
+file: testfile-dwp-4
+Got cudie unit_type: 4
+Found a skeleton unit, with split die: main.c
+Got cudie unit_type: 4
+Found a skeleton unit, with split die: other.c
+
+EOF
+
+testrun_compare ${abs_builddir}/all-dwarf-ranges testfile-dwp-4 <<\EOF
+die: main.c (11)
+ 1150..1156
+ 1040..1054
+
+die: main (2e)
+ 1040..1054
+
+die: MixedCase (2e)
+ 1150..1156
+
+die: other.c (11)
+ 1160..1165
+
+die: other_function (2e)
+ 1160..1165
+
+die: helper (1d)
+ 1160..1160
+
+EOF
+
+testrun_compare ${abs_builddir}/varlocs --exprlocs -e testfile-dwp-4 <<\EOF
+module 'testfile-dwp-4'
+[b] CU 'main.c'
+  producer (GNU_str_index)
+  language (data1)
+  name (GNU_str_index)
+  comp_dir (GNU_str_index)
+  GNU_dwo_id (data8)
+  [18] structure_type "point"
+    name (GNU_str_index)
+    byte_size (data1)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    sibling (ref4)
+    [22] member "x"
+      name (string)
+      decl_file (data1)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+      data_member_location (data1) {plus_uconst(0)}
+    [2d] member "y"
+      name (string)
+      decl_file (data1)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+      data_member_location (data1) {plus_uconst(4)}
+  [39] base_type "int"
+    byte_size (data1)
+    encoding (data1)
+    name (string)
+  [40] typedef "Point"
+    name (GNU_str_index)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    type (ref4)
+  [49] variable "global_counter"
+    name (GNU_str_index)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    type (ref4)
+    external (flag_present)
+    location (exprloc) {addr: 0x4014}
+  [55] subprogram "other_function"
+    external (flag_present)
+    name (GNU_str_index)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    prototyped (flag_present)
+    type (ref4)
+    declaration (flag_present)
+    sibling (ref4)
+    [62] formal_parameter
+      type (ref4)
+  [68] subprogram "main"
+    external (flag_present)
+    name (GNU_str_index)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    prototyped (flag_present)
+    type (ref4)
+    low_pc (GNU_addr_index)
+    high_pc (data8)
+    frame_base (exprloc) {call_frame_cfa {bregx(7,8)}}
+    GNU_all_call_sites (flag_present)
+    sibling (ref4)
+    [80] variable "p"
+      name (string)
+      decl_file (data1)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+      location (sec_offset)
+            [1040,1054) {lit1, stack_value, piece(4), lit2, stack_value, piece(4)}
+      GNU_locviews (sec_offset)
+    [92] GNU_call_site "other_function"
+      low_pc (GNU_addr_index)
+      GNU_tail_call (flag_present)
+      abstract_origin (ref4)
+      [98] GNU_call_site_parameter
+        location (exprloc) {reg5}
+        GNU_call_site_value (exprloc) {lit4}
+  [9f] subprogram "MixedCase"
+    external (flag_present)
+    name (GNU_str_index)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    prototyped (flag_present)
+    type (ref4)
+    inline (data1)
+    sibling (ref4)
+    [ad] formal_parameter "p"
+      name (string)
+      decl_file (data1)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+  [b8] pointer_type
+    byte_size (data1)
+    type (ref4)
+  [be] subprogram "helper"
+    name (GNU_str_index)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    prototyped (flag_present)
+    type (ref4)
+    inline (data1)
+    sibling (ref4)
+    [cc] formal_parameter "a"
+      name (string)
+      decl_file (data1)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+  [d7] subprogram "MixedCase"
+    abstract_origin (ref4)
+    low_pc (GNU_addr_index)
+    high_pc (data8)
+    frame_base (exprloc) {call_frame_cfa {bregx(7,8)}}
+    GNU_all_call_sites (flag_present)
+    [e7] formal_parameter "p"
+      abstract_origin (ref4)
+      location (exprloc) {reg5}
+module 'testfile-dwp-4'
+[fb] CU 'other.c'
+  producer (GNU_str_index)
+  language (data1)
+  name (GNU_str_index)
+  comp_dir (GNU_str_index)
+  GNU_dwo_id (data8)
+  [108] enumeration_type "color"
+    name (GNU_str_index)
+    encoding (data1)
+    byte_size (data1)
+    type (ref4)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    sibling (ref4)
+    [117] enumerator "red"
+      name (string)
+      const_value (data1)
+    [11d] enumerator "green"
+      name (GNU_str_index)
+      const_value (data1)
+    [120] enumerator "blue"
+      name (GNU_str_index)
+      const_value (data1)
+  [124] base_type "unsigned int"
+    byte_size (data1)
+    encoding (data1)
+    name (GNU_str_index)
+  [128] subprogram "other_function"
+    external (flag_present)
+    name (GNU_str_index)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    prototyped (flag_present)
+    type (ref4)
+    low_pc (GNU_addr_index)
+    high_pc (data8)
+    frame_base (exprloc) {call_frame_cfa {bregx(7,8)}}
+    GNU_all_call_sites (flag_present)
+    sibling (ref4)
+    [140] formal_parameter "x"
+      name (string)
+      decl_file (data1)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+      location (exprloc) {reg5}
+    [14c] variable "c"
+      name (string)
+      decl_file (data1)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+      const_value (data1)
+    [157] inlined_subroutine "helper"
+      abstract_origin (ref4)
+      entry_pc (GNU_addr_index)
+      GNU_entry_view (data1)
+      low_pc (GNU_addr_index)
+      high_pc (data8)
+      call_file (data1)
+      call_line (data1)
+      call_column (data1)
+      [16a] formal_parameter "a"
+        abstract_origin (ref4)
+        location (sec_offset)
+              [1160,1160) {reg5}
+        GNU_locviews (sec_offset)
+  [179] base_type "int"
+    byte_size (data1)
+    encoding (data1)
+    name (string)
+  [180] subprogram "helper"
+    name (GNU_str_index)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    prototyped (flag_present)
+    type (ref4)
+    inline (data1)
+    [18a] formal_parameter "a"
+      name (string)
+      decl_file (data1)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+EOF
+
+testrun_compare ${abs_builddir}/get-units-split testfile-dwp-5 <<\EOF
+file: testfile-dwp-5
+Got cudie unit_type: 4
+Found a skeleton unit, with split die: main.c
+Got cudie unit_type: 4
+Found a skeleton unit, with split die: other.c
+
+EOF
+
+testrun_compare ${abs_builddir}/all-dwarf-ranges testfile-dwp-5 <<\EOF
+die: main.c (11)
+ 1150..1156
+ 1040..1054
+
+die: main (2e)
+ 1040..1054
+
+die: MixedCase (2e)
+ 1150..1156
+
+die: other.c (11)
+ 1160..1165
+
+die: other_function (2e)
+ 1160..1165
+
+die: helper (1d)
+ 1160..1160
+
+EOF
+
+testrun_compare ${abs_builddir}/varlocs --exprlocs -e testfile-dwp-5 <<\EOF
+module 'testfile-dwp-5'
+[14] CU 'main.c'
+  producer (strx)
+  language (data1)
+  name (strx)
+  comp_dir (strx)
+  [19] structure_type "point"
+    name (strx)
+    byte_size (data1)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    sibling (ref4)
+    [23] member "x"
+      name (string)
+      decl_file (implicit_const)
+      decl_line (implicit_const)
+      decl_column (data1)
+      type (ref4)
+      data_member_location (data1) {plus_uconst(0)}
+    [2c] member "y"
+      name (string)
+      decl_file (implicit_const)
+      decl_line (implicit_const)
+      decl_column (data1)
+      type (ref4)
+      data_member_location (data1) {plus_uconst(4)}
+  [36] base_type "int"
+    byte_size (data1)
+    encoding (data1)
+    name (string)
+  [3d] typedef "Point"
+    name (strx)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    type (ref4)
+  [46] variable "global_counter"
+    name (strx)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    type (ref4)
+    external (flag_present)
+    location (exprloc) {addr: 0x4014}
+  [52] subprogram "other_function"
+    external (flag_present)
+    name (strx)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    prototyped (flag_present)
+    type (ref4)
+    declaration (flag_present)
+    sibling (ref4)
+    [5f] formal_parameter
+      type (ref4)
+  [65] subprogram "main"
+    external (flag_present)
+    name (strx)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    prototyped (flag_present)
+    type (ref4)
+    low_pc (addrx)
+    high_pc (data8)
+    frame_base (exprloc) {call_frame_cfa {bregx(7,8)}}
+    call_all_calls (flag_present)
+    sibling (ref4)
+    [7d] variable "p"
+      name (string)
+      decl_file (data1)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+      location (loclistx)
+            [1040,1054) {lit1, stack_value, piece(4), lit2, stack_value, piece(4)}
+      GNU_locviews (sec_offset)
+    [8c] call_site
+      call_return_pc (addrx)
+      call_tail_call (flag_present)
+      call_origin (ref4)
+      [92] call_site_parameter
+        location (exprloc) {reg5}
+        call_value (exprloc) {lit4}
+  [99] subprogram "MixedCase"
+    external (flag_present)
+    name (strx)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    prototyped (flag_present)
+    type (ref4)
+    inline (data1)
+    sibling (ref4)
+    [a7] formal_parameter "p"
+      name (string)
+      decl_file (implicit_const)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+  [b1] pointer_type
+    byte_size (data1)
+    type (ref4)
+  [b7] subprogram "helper"
+    name (strx)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    prototyped (flag_present)
+    type (ref4)
+    inline (data1)
+    sibling (ref4)
+    [c5] formal_parameter "a"
+      name (string)
+      decl_file (implicit_const)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+  [cf] subprogram "MixedCase"
+    abstract_origin (ref4)
+    low_pc (addrx)
+    high_pc (data8)
+    frame_base (exprloc) {call_frame_cfa {bregx(7,8)}}
+    call_all_calls (flag_present)
+    [df] formal_parameter "p"
+      abstract_origin (ref4)
+      location (exprloc) {reg5}
+module 'testfile-dwp-5'
+[fc] CU 'other.c'
+  producer (strx)
+  language (data1)
+  name (strx)
+  comp_dir (strx)
+  [101] enumeration_type "color"
+    name (strx)
+    encoding (data1)
+    byte_size (data1)
+    type (ref4)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    sibling (ref4)
+    [110] enumerator "red"
+      name (string)
+      const_value (data1)
+    [116] enumerator "green"
+      name (strx)
+      const_value (data1)
+    [119] enumerator "blue"
+      name (strx)
+      const_value (data1)
+  [11d] base_type "unsigned int"
+    byte_size (data1)
+    encoding (data1)
+    name (strx)
+  [121] subprogram "other_function"
+    external (flag_present)
+    name (strx)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    prototyped (flag_present)
+    type (ref4)
+    low_pc (addrx)
+    high_pc (data8)
+    frame_base (exprloc) {call_frame_cfa {bregx(7,8)}}
+    call_all_calls (flag_present)
+    sibling (ref4)
+    [139] formal_parameter "x"
+      name (string)
+      decl_file (data1)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+      location (exprloc) {reg5}
+    [145] variable "c"
+      name (string)
+      decl_file (data1)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+      const_value (data1)
+    [150] inlined_subroutine "helper"
+      abstract_origin (ref4)
+      entry_pc (addrx)
+      GNU_entry_view (data1)
+      low_pc (addrx)
+      high_pc (data8)
+      call_file (data1)
+      call_line (data1)
+      call_column (data1)
+      [163] formal_parameter "a"
+        abstract_origin (ref4)
+        location (loclistx)
+              [1160,1160) {reg5}
+        GNU_locviews (sec_offset)
+  [16f] base_type "int"
+    byte_size (data1)
+    encoding (data1)
+    name (string)
+  [176] subprogram "helper"
+    name (strx)
+    decl_file (data1)
+    decl_line (data1)
+    decl_column (data1)
+    prototyped (flag_present)
+    type (ref4)
+    inline (data1)
+    [180] formal_parameter "a"
+      name (string)
+      decl_file (data1)
+      decl_line (data1)
+      decl_column (data1)
+      type (ref4)
+EOF
+
+exit 0
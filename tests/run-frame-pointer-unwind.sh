@@ -0,0 +1,66 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+# Unwind the threads of core files of binaries built with frame
+# pointers, with CFI and with dwfl_set_frame_pointer_unwind.  Both must
+# find the same frames, frame pointers may find some more at the end.
+# The code of the fp binaries has no CFI, so there both go by frame
+# pointers where CFI stops.
+
+# See run-backtrace-fp-core-x86_64.sh
+testfiles backtrace.x86_64.fp.exec backtrace.x86_64.fp.core
+
+testrun_compare ${abs_builddir}/frame-pointer-unwind ./backtrace.x86_64.fp.exec ./backtrace.x86_64.fp.core <<\EOF2
+tid 28872: 7 frames
+tid 28871: 4 frames
+EOF2
+
+# See run-backtrace-fp-core-i386.sh
+testfiles backtrace.i386.fp.exec backtrace.i386.fp.core
+
+testrun_compare ${abs_builddir}/frame-pointer-unwind ./backtrace.i386.fp.exec ./backtrace.i386.fp.core <<\EOF2
+tid 12045: 8 frames
+tid 12044: 5 frames
+EOF2
+
+# See run-backtrace-fp-core-aarch64.sh
+testfiles backtrace.aarch64.fp.exec backtrace.aarch64.fp.core
+
+testrun_compare ${abs_builddir}/frame-pointer-unwind ./backtrace.aarch64.fp.exec ./backtrace.aarch64.fp.core <<\EOF2
+tid 350: 7 frames
+tid 349: 4 frames
+EOF2
+
+# The code of this one keeps frame pointers and has CFI too, so the
+# frame pointers are followed from frames unwound with CFI.
+# See run-backtrace-core-aarch64.sh
+testfiles backtrace.aarch64.exec backtrace.aarch64.core
+
+testrun_compare ${abs_builddir}/frame-pointer-unwind ./backtrace.aarch64.exec ./backtrace.aarch64.core <<\EOF2
+tid 24044: 7 frames
+tid 24043: 4 frames
+EOF2
+
+# See run-backtrace-fp-core-ppc64le.sh
+testfiles backtrace.ppc64le.fp.exec backtrace.ppc64le.fp.core
+
+testrun_compare ${abs_builddir}/frame-pointer-unwind ./backtrace.ppc64le.fp.exec ./backtrace.ppc64le.fp.core <<\EOF2
+tid 23728: 6 frames
+tid 23727: 4 frames
+EOF2
+
+exit 0
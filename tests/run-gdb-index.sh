@@ -0,0 +1,96 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# See run-readelf-gdb_index.sh for the sources of testfilegdbindex5
+# and testfilegdbindex7.
+#
+# objcopy --remove-section=.debug_aranges testfilegdbindex7 \
+#   testfilegdbindex7-noaranges
+#
+# Without .debug_names the names come from the .gdb_index symbol table.
+# "foo" is only defined in a type unit, which isn't searched.
+
+testfiles testfilegdbindex5 testfilegdbindex7 testfilegdbindex7-noaranges
+
+testrun_compare ${abs_builddir}/gdb-index testfilegdbindex5 \
+	main say global hello foo int Int char nothere <<\EOF
+arange 0: 0x40049c..0x4004d2, CU: "hello.c"
+arange 1: 0x4004d4..0x40050c, CU: "world.c"
+main:
+ "main", tag: 0x2e, die: 52, CU: "hello.c"
+say:
+ "say", tag: 0x2e, die: 302, CU: "world.c"
+global:
+ "global", tag: 0x34, die: 360, CU: "world.c"
+hello:
+ "hello", tag: 0x34, die: 151, CU: "hello.c"
+ "hello", tag: 0x2e, die: 247, CU: "world.c"
+foo:
+int:
+ "int", tag: 0x24, die: 132, CU: "hello.c"
+Int:
+char:
+ "char", tag: 0x24, die: 45, CU: "hello.c"
+nothere:
+EOF
+
+testrun_compare ${abs_builddir}/gdb-index testfilegdbindex7 \
+	main say global hello foo int Int char nothere <<\EOF
+arange 0: 0x40049c..0x4004d2, CU: "hello.c"
+arange 1: 0x4004d4..0x40050c, CU: "world.c"
+main:
+ "main", tag: 0x2e, die: 52, CU: "hello.c"
+say:
+ "say", tag: 0x2e, die: 302, CU: "world.c"
+global:
+ "global", tag: 0x34, die: 360, CU: "world.c"
+hello:
+ "hello", tag: 0x34, die: 151, CU: "hello.c"
+ "hello", tag: 0x2e, die: 247, CU: "world.c"
+foo:
+int:
+ "int", tag: 0x24, die: 132, CU: "hello.c"
+Int:
+char:
+ "char", tag: 0x24, die: 45, CU: "hello.c"
+nothere:
+EOF
+
+testrun_compare ${abs_builddir}/gdb-index testfilegdbindex7-noaranges \
+	main say global hello foo int Int char nothere <<\EOF
+arange 0: 0x40049c..0x4004d2, CU: "hello.c"
+arange 1: 0x4004d4..0x40050c, CU: "world.c"
+main:
+ "main", tag: 0x2e, die: 52, CU: "hello.c"
+say:
+ "say", tag: 0x2e, die: 302, CU: "world.c"
+global:
+ "global", tag: 0x34, die: 360, CU: "world.c"
+hello:
+ "hello", tag: 0x34, die: 151, CU: "hello.c"
+ "hello", tag: 0x2e, die: 247, CU: "world.c"
+foo:
+int:
+ "int", tag: 0x24, die: 132, CU: "hello.c"
+Int:
+char:
+ "char", tag: 0x24, die: 45, CU: "hello.c"
+nothere:
+EOF
+
+exit 0
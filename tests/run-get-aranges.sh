@@ -65,4 +65,72 @@ CU name: "f.c"
 CU name: "m.c"
 EOF
 
+# Compilers don't always emit .debug_aranges, or not for every CU.
+# Then the ranges are taken from the CUs themselves.
+# See run-debug-names.sh for main.c and other.c.
+#
+# gcc -g -O2 -c main.c other.c
+# objcopy -R .debug_aranges other.o
+# gcc -o testfile-partial-aranges main.o other.o
+# objcopy -R .debug_aranges testfile-partial-aranges testfile-noaranges
+
+testfiles testfile-partial-aranges testfile-noaranges
+
+# 0x1160 and 0x1164 are in other.c, which has no .debug_aranges entry
+# in either file, 0x1040 is in main.c, which only has one in the first.
+testrun_compare ${abs_builddir}/get-aranges \
+	-a 0x1040 -a 0x1160 -a 0x1164 -a 0x1165 \
+	testfile-partial-aranges testfile-noaranges <<\EOF
+0x804842b: not in range
+0x804842c: not in range
+0x804843c: not in range
+0x8048459: not in range
+0x804845a: not in range
+0x804845b: not in range
+0x804845c: not in range
+0x8048460: not in range
+0x8048465: not in range
+0x8048466: not in range
+0x8048467: not in range
+0x8048468: not in range
+0x8048470: not in range
+0x8048471: not in range
+0x8048472: not in range
+0x1040: cu: 12, CU name: "main.c"
+0x1160: cu: 313, CU name: "other.c"
+0x1164: cu: 313, CU name: "other.c"
+0x1165: not in range
+ [ 0] start: 0x1040, length: 20, cu: 12
+CU name: "main.c"
+ [ 1] start: 0x1150, length: 6, cu: 12
+CU name: "main.c"
+ [ 2] start: 0x1160, length: 5, cu: 313
+CU name: "other.c"
+0x804842b: not in range
+0x804842c: not in range
+0x804843c: not in range
+0x8048459: not in range
+0x804845a: not in range
+0x804845b: not in range
+0x804845c: not in range
+0x8048460: not in range
+0x8048465: not in range
+0x8048466: not in range
+0x8048467: not in range
+0x8048468: not in range
+0x8048470: not in range
+0x8048471: not in range
+0x8048472: not in range
+0x1040: cu: 12, CU name: "main.c"
+0x1160: cu: 313, CU name: "other.c"
+0x1164: cu: 313, CU name: "other.c"
+0x1165: not in range
+ [ 0] start: 0x1040, length: 20, cu: 12
+CU name: "main.c"
+ [ 1] start: 0x1150, length: 6, cu: 12
+CU name: "main.c"
+ [ 2] start: 0x1160, length: 5, cu: 313
+CU name: "other.c"
+EOF
+
 exit 0
@@ -0,0 +1,45 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+# Look up the scopes at the start, middle and end of the ranges of
+# all DIEs and compare with a walk over the DIE tree, like
+# dwarf_getscopes did before it used an index.
+
+# See run-addr2line-i-test.sh
+testfiles testfile-inlines
+
+# See run-unstrip-test4.sh
+testfiles testfile-strtab
+
+# See run-dwarf-die-addr-die.sh
+testfiles testfile-dwarf-5
+
+testrun_compare ${abs_builddir}/getscopes-index testfile-inlines <<\EOF2
+1 units, 60 addresses
+EOF2
+
+testrun_compare ${abs_builddir}/getscopes-index testfile-strtab <<\EOF2
+2 units, 2556 addresses
+EOF2
+
+testrun_compare ${abs_builddir}/getscopes-index testfile-dwarf-5 <<\EOF2
+2 units, 64 addresses
+EOF2
+
+testrun_on_self_quiet ${abs_builddir}/getscopes-index
+
+exit 0
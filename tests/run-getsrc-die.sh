@@ -48,4 +48,16 @@ testrun_compare ${abs_top_builddir}/tests/getsrc_die testfile-lex-inlines 0x0000
 /tmp/x.cpp:5
 EOF
 
+# Without addresses every line address and its neighbors are checked
+# against a linear search.
+testrun_compare ${abs_top_builddir}/tests/getsrc_die testfile <<\EOF
+39 addresses checked
+EOF
+
+testrun_compare ${abs_top_builddir}/tests/getsrc_die testfile-inlines <<\EOF
+66 addresses checked
+EOF
+
+testrun_on_self_quiet ${abs_top_builddir}/tests/getsrc_die
+
 exit 0
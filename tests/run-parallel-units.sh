@@ -0,0 +1,51 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Read all units with dwarf_parallel_units and compare with reading
+# them one by one from a single thread.  The split DWARF files also
+# look up the split units concurrently, from .dwo files and from a
+# DWARF package file.
+
+# see tests/testfile-dwarf-45.source
+testfiles testfile-splitdwarf-4 testfile-hello4.dwo testfile-world4.dwo
+testfiles testfile-splitdwarf-5 testfile-hello5.dwo testfile-world5.dwo
+
+# See run-dwp.sh
+testfiles testfile-dwp-4 testfile-dwp-4.dwp
+testfiles testfile-dwp-5 testfile-dwp-5.dwp
+
+testrun_compare ${abs_builddir}/parallel-units 4 testfile-splitdwarf-4 <<\EOF2
+units: 2, DIEs: 2, split DIEs: 74, tags: 101923, names: 311, lines: 57
+EOF2
+
+testrun_compare ${abs_builddir}/parallel-units 4 testfile-splitdwarf-5 <<\EOF2
+units: 2, DIEs: 2, split DIEs: 74, tags: 2575, names: 293, lines: 57
+EOF2
+
+testrun_compare ${abs_builddir}/parallel-units 2 testfile-dwp-4 <<\EOF2
+units: 2, DIEs: 2, split DIEs: 34, tags: 34223, names: 164, lines: 21
+EOF2
+
+testrun_compare ${abs_builddir}/parallel-units 2 testfile-dwp-5 <<\EOF2
+units: 2, DIEs: 2, split DIEs: 34, tags: 1183, names: 150, lines: 21
+EOF2
+
+testrun_on_self ${abs_builddir}/parallel-units 8
+testrun_on_self ${abs_builddir}/parallel-units 0
+
+exit 0
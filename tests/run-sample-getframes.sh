@@ -0,0 +1,34 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+# Take the registers and stacks of the threads of a core file as
+# samples and unwind them with dwfl_sample_getframes, the whole stack
+# and parts of it, which must give the frames from the core file.
+# Then with a Dwfl_Thread_Callbacks backend reading memory by word and
+# with dwfl_set_memory_read_range.
+
+# See run-backtrace-core-x86_64.sh
+testfiles backtrace.x86_64.exec backtrace.x86_64.core
+
+testrun_compare ${abs_builddir}/sample-getframes ./backtrace.x86_64.exec ./backtrace.x86_64.core <<\EOF2
+tid 23097: 7 frames
+tid 23096: 4 frames
+memory_read: 25 word reads, 0 range reads
+memory_read_range: 0 word reads, 6 range reads
+EOF2
+
+exit 0
@@ -0,0 +1,337 @@
+/* Test dwfl_sample_getframes with samples taken from a core file.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dwfl)
+#include <gelf.h>
+
+/* A sample of a thread is the registers of its NT_PRSTATUS note, in
+   DWARF order, and the memory from its stack pointer to the end of the
+   segment.  This only knows the note of x86_64 cores.  */
+#define NREGS 17
+#define SP_REG 7
+#define PC_REG 16
+#define MAX_FRAMES 64
+#define MAX_THREADS 16
+
+/* struct user_regs_struct index of each DWARF register.  */
+static const int x86_64_regs[NREGS] =
+  { 10, 12, 11, 5, 13, 14, 4, 19, 9, 8, 7, 6, 3, 2, 1, 0, 16 };
+
+struct frames
+{
+  Dwarf_Addr pcs[MAX_FRAMES];
+  size_t npcs;
+};
+
+struct sample
+{
+  pid_t tid;
+  Dwarf_Word regs[NREGS];
+  const void *stack;
+  size_t stack_size;
+  /* What unwinding from the core file finds.  */
+  struct frames expected;
+};
+
+static struct sample samples[MAX_THREADS];
+static size_t nsamples;
+static int errors;
+
+static void
+read_stack (Elf *core, size_t phnum, struct sample *s)
+{
+  Dwarf_Addr sp = s->regs[SP_REG];
+  for (size_t i = 0; i < phnum; i++)
+    {
+      GElf_Phdr phdr_mem, *phdr = gelf_getphdr (core, i, &phdr_mem);
+      if (phdr != NULL && phdr->p_type == PT_LOAD
+	  && phdr->p_vaddr <= sp && sp - phdr->p_vaddr < phdr->p_filesz)
+	{
+	  size_t skip = sp - phdr->p_vaddr;
+	  Elf_Data *data = elf_getdata_rawchunk (core, phdr->p_offset + skip,
+						 phdr->p_filesz - skip,
+						 ELF_T_BYTE);
+	  if (data != NULL)
+	    {
+	      s->stack = data->d_buf;
+	      s->stack_size = data->d_size;
+	    }
+	  return;
+	}
+    }
+}
+
+static void
+read_samples (Elf *core)
+{
+  size_t phnum;
+  if (elf_getphdrnum (core, &phnum) != 0)
+    return;
+
+  for (size_t i = 0; i < phnum; i++)
+    {
+      GElf_Phdr phdr_mem, *phdr = gelf_getphdr (core, i, &phdr_mem);
+      if (phdr == NULL || phdr->p_type != PT_NOTE)
+	continue;
+
+      Elf_Data *data = elf_getdata_rawchunk (core, phdr->p_offset,
+					     phdr->p_filesz, ELF_T_NHDR);
+      GElf_Nhdr nhdr;
+      size_t name_offset, desc_offset;
+      size_t offset = 0;
+      while (data != NULL && nsamples < MAX_THREADS
+	     && (offset = gelf_getnote (data, offset, &nhdr, &name_offset,
+					&desc_offset)) > 0)
+	if (nhdr.n_type == NT_PRSTATUS && nhdr.n_descsz >= 112 + 27 * 8)
+	  {
+	    const unsigned char *desc = data->d_buf + desc_offset;
+	    struct sample *s = &samples[nsamples++];
+	    int32_t pid;
+	    memcpy (&pid, desc + 32, sizeof pid);
+	    s->tid = pid;
+	    for (int r = 0; r < NREGS; r++)
+	      memcpy (&s->regs[r], desc + 112 + 8 * x86_64_regs[r], 8);
+	    read_stack (core, phnum, s);
+	  }
+    }
+}
+
+static int
+frame_callback (Dwfl_Frame *state, void *arg)
+{
+  struct frames *frames = arg;
+  Dwarf_Addr pc;
+  if (! dwfl_frame_pc (state, &pc, NULL))
+    return DWARF_CB_ABORT;
+  if (frames->npcs == MAX_FRAMES)
+    return DWARF_CB_ABORT;
+  frames->pcs[frames->npcs++] = pc;
+  return DWARF_CB_OK;
+}
+
+/* Unwind S with the first STACK_SIZE bytes of its stack, which must
+   give the frames unwinding from the core gave, or the first ones of
+   them if the stack is cut short.  */
+static void
+check_sample (Dwfl *dwfl, struct sample *s, size_t stack_size)
+{
+  struct frames frames = { .npcs = 0 };
+  int res = dwfl_sample_getframes (dwfl, s->tid, s->regs[PC_REG],
+				   s->regs, NREGS, s->stack, stack_size,
+				   s->regs[SP_REG], frame_callback, &frames);
+  bool complete = stack_size == s->stack_size;
+  if (frames.npcs > s->expected.npcs
+      || (complete && frames.npcs != s->expected.npcs)
+      || memcmp (frames.pcs, s->expected.pcs,
+		 frames.npcs * sizeof frames.pcs[0]) != 0)
+    {
+      printf ("tid %d, %zu stack bytes: %zu frames (%s), expected %zu\n",
+	      s->tid, stack_size, frames.npcs,
+	      res == 0 ? "no error" : dwfl_errmsg (-1), s->expected.npcs);
+      errors++;
+    }
+}
+
+/* A backend of our own for one sample at a time, which counts how the
+   unwinder reads memory.  */
+static struct sample *current;
+static size_t nwords;
+static size_t nranges;
+
+static bool
+read_stack_range (Dwarf_Addr addr, void *buf, size_t size)
+{
+  Dwarf_Addr start = current->regs[SP_REG];
+  if (addr < start || size > current->stack_size
+      || addr - start > current->stack_size - size)
+    return false;
+  memcpy (buf, (const unsigned char *) current->stack + (addr - start), size);
+  return true;
+}
+
+static bool
+custom_memory_read (Dwfl *dwfl __attribute__ ((unused)), Dwarf_Addr addr,
+		    Dwarf_Word *result, void *arg __attribute__ ((unused)))
+{
+  nwords++;
+  return read_stack_range (addr, result, sizeof *result);
+}
+
+static bool
+custom_memory_read_range (Dwfl *dwfl __attribute__ ((unused)),
+			  Dwarf_Addr addr, void *buf, size_t size,
+			  void *arg __attribute__ ((unused)))
+{
+  nranges++;
+  return read_stack_range (addr, buf, size);
+}
+
+static pid_t
+custom_next_thread (Dwfl *dwfl __attribute__ ((unused)),
+		    void *arg __attribute__ ((unused)), void **thread_argp)
+{
+  if (*thread_argp != NULL)
+    return 0;
+  *thread_argp = current;
+  return current->tid;
+}
+
+static bool
+custom_set_initial_registers (Dwfl_Thread *thread,
+			      void *arg __attribute__ ((unused)))
+{
+  dwfl_thread_state_register_pc (thread, current->regs[PC_REG]);
+  return dwfl_thread_state_registers (thread, 0, NREGS, current->regs);
+}
+
+static const Dwfl_Thread_Callbacks custom_callbacks =
+{
+  .next_thread = custom_next_thread,
+  .memory_read = custom_memory_read,
+  .set_initial_registers = custom_set_initial_registers,
+};
+
+/* Unwind all samples with our backend, which must give the expected
+   frames whether memory is read by word or by range.  */
+static void
+check_custom (Dwfl *dwfl, const char *what)
+{
+  nwords = nranges = 0;
+  for (size_t i = 0; i < nsamples; i++)
+    {
+      struct frames frames = { .npcs = 0 };
+      current = &samples[i];
+      dwfl_getthread_frames (dwfl, current->tid, frame_callback, &frames);
+      if (frames.npcs != current->expected.npcs
+	  || memcmp (frames.pcs, current->expected.pcs,
+		     frames.npcs * sizeof frames.pcs[0]) != 0)
+	{
+	  printf ("%s, tid %d: %zu frames, expected %zu\n", what,
+		  current->tid, frames.npcs, current->expected.npcs);
+	  errors++;
+	}
+    }
+  printf ("%s: %zu word reads, %zu range reads\n", what, nwords, nranges);
+}
+
+static const Dwfl_Callbacks callbacks =
+  {
+    .find_elf = dwfl_build_id_find_elf,
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+  };
+
+static Dwfl *
+report_core (Elf *core, const char *executable)
+{
+  Dwfl *dwfl = dwfl_begin (&callbacks);
+  if (dwfl == NULL
+      || dwfl_core_file_report (dwfl, core, executable) < 0
+      || dwfl_report_end (dwfl, NULL, NULL) != 0)
+    {
+      printf ("cannot report core: %s\n", dwfl_errmsg (-1));
+      exit (1);
+    }
+  return dwfl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 3)
+    {
+      puts ("usage: sample-getframes EXECUTABLE CORE");
+      return 1;
+    }
+
+  elf_version (EV_CURRENT);
+  int fd = open (argv[2], O_RDONLY);
+  Elf *core = elf_begin (fd, ELF_C_READ_MMAP, NULL);
+  GElf_Ehdr ehdr_mem, *ehdr = gelf_getehdr (core, &ehdr_mem);
+  if (ehdr == NULL || ehdr->e_type != ET_CORE
+      || ehdr->e_machine != EM_X86_64)
+    {
+      printf ("%s: not an x86_64 core file\n", argv[2]);
+      return 1;
+    }
+  read_samples (core);
+
+  /* The frames of the threads like the core file has them.  */
+  Dwfl *core_dwfl = report_core (core, argv[1]);
+  pid_t pid = dwfl_core_file_attach (core_dwfl, core);
+  if (pid < 0)
+    {
+      printf ("dwfl_core_file_attach: %s\n", dwfl_errmsg (-1));
+      return 1;
+    }
+  for (size_t i = 0; i < nsamples; i++)
+    dwfl_getthread_frames (core_dwfl, samples[i].tid, frame_callback,
+			   &samples[i].expected);
+  dwfl_end (core_dwfl);
+
+  /* The same Dwfl unwinds every sample many times.  */
+  Dwfl *dwfl = report_core (core, argv[1]);
+  if (dwfl_sample_attach (dwfl, core, pid) != 0)
+    {
+      printf ("dwfl_sample_attach: %s\n", dwfl_errmsg (-1));
+      return 1;
+    }
+  for (int round = 0; round < 100; round++)
+    for (size_t i = 0; i < nsamples; i++)
+      check_sample (dwfl, &samples[i], samples[i].stack_size);
+
+  /* Less stack gives fewer frames.  */
+  for (size_t i = 0; i < nsamples; i++)
+    for (size_t size = 0; size < samples[i].stack_size; size += 8)
+      check_sample (dwfl, &samples[i], size);
+
+  /* Attaching to the core again is not possible.  */
+  if (dwfl_core_file_attach (dwfl, core) >= 0)
+    {
+      puts ("dwfl_core_file_attach after dwfl_sample_attach succeeded");
+      errors++;
+    }
+
+  for (size_t i = 0; i < nsamples; i++)
+    printf ("tid %d: %zu frames\n", samples[i].tid, samples[i].expected.npcs);
+
+  dwfl_end (dwfl);
+
+  dwfl = report_core (core, argv[1]);
+  if (! dwfl_attach_state (dwfl, core, pid, &custom_callbacks, NULL))
+    {
+      printf ("dwfl_attach_state: %s\n", dwfl_errmsg (-1));
+      return 1;
+    }
+  check_custom (dwfl, "memory_read");
+  dwfl_set_memory_read_range (dwfl, custom_memory_read_range);
+  check_custom (dwfl, "memory_read_range");
+  dwfl_end (dwfl);
+  elf_end (core);
+  close (fd);
+
+  return errors == 0 ? 0 : 1;
+}